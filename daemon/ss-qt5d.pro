@@ -0,0 +1,29 @@
+#-------------------------------------------------
+#
+#          ss-qt5d
+#
+#  ss-qt5 --daemon and --server without the GUI
+#
+#-------------------------------------------------
+
+QT      += core network concurrent
+QT      -= gui widgets
+CONFIG  += c++11 console
+CONFIG  -= app_bundle
+
+TARGET   = ss-qt5d
+TEMPLATE = app
+VERSION  = 0.5.0
+DEFINES += APP_VERSION=\\\"$$VERSION\\\"
+
+include($$PWD/../src/core.pri)
+
+SOURCES += $$PWD/../src/daemonmain.cpp
+
+isEmpty(INSTALL_PREFIX) {
+    unix: INSTALL_PREFIX = /usr
+    else: INSTALL_PREFIX = ..
+}
+target.path = $$INSTALL_PREFIX/bin
+
+INSTALLS += target
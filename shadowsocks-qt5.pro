@@ -4,7 +4,8 @@
 #
 #-------------------------------------------------
 
-QT      += core gui widgets
+QT      += core gui widgets network concurrent
+CONFIG  += c++11
 win32: QT += winextras
 linux: QT += dbus
 
@@ -20,7 +20,7 @@ AddProfileDialogue::~AddProfileDialogue()
 
 void AddProfileDialogue::checkBase64SSURI(const QString &str)
 {
-    if (!SSValidator::validate(str)) {
+    if (!SSValidator::validate(str.toUtf8())) {
         ui->ssuriEdit->setStyleSheet("background: pink");
         ui->buttonBox->setEnabled(false);
     }
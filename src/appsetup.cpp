@@ -0,0 +1,73 @@
+#include <QLibraryInfo>
+#include <QLocale>
+#include <QTimer>
+#include "appsetup.h"
+#include "tracer.h"
+#include "traffictrace.h"
+#include "daemon.h"
+#include "startuptimer.h"
+
+void AppSetup::setupApplication(QCoreApplication &a, QTranslator *qtTranslator, QTranslator *ssqt5Translator)
+{
+    a.setApplicationName(QString("shadowsocks-qt5"));
+    a.setApplicationVersion(APP_VERSION);
+
+    qtTranslator->load("qt_" + QLocale::system().name(), QLibraryInfo::location(QLibraryInfo::TranslationsPath));
+    a.installTranslator(qtTranslator);
+    ssqt5Translator->load("ssqt5_" + QLocale::system().name(), QCoreApplication::applicationDirPath());
+    a.installTranslator(ssqt5Translator);
+    StartupTimer::mark("translations");
+
+    /*
+     * --trace <file> records backend, profile and session spans and writes
+     * them to <file> on exit, in Chrome's trace_event JSON format.
+     */
+    int traceArg = a.arguments().indexOf("--trace");
+    if (traceArg > 0 && traceArg + 1 < a.arguments().size()) {
+        QString traceFile = a.arguments().at(traceArg + 1);
+        Tracer::enable();
+        QObject::connect(&a, &QCoreApplication::aboutToQuit, [traceFile] {
+            if (!Tracer::dump(traceFile)) {
+                qWarning("Warning: cannot write trace file %s", qPrintable(traceFile));
+            }
+        });
+    }
+
+    /*
+     * --record-traffic <file> records the timing and sizes of the sessions
+     * going through the relay, for ss-bench --replay.
+     */
+    int recordArg = a.arguments().indexOf("--record-traffic");
+    if (recordArg > 0 && recordArg + 1 < a.arguments().size()) {
+        QString recordFile = a.arguments().at(recordArg + 1);
+        if (!TrafficTrace::start(recordFile)) {
+            qWarning("Warning: cannot write traffic trace %s", qPrintable(recordFile));
+        }
+    }
+}
+
+int AppSetup::runDaemon(int argc, char *argv[], bool serverRole)
+{
+    QCoreApplication a(argc, argv);
+    StartupTimer::mark("application");
+    QTranslator t, ssqt5t;
+    setupApplication(a, &t, &ssqt5t);
+
+    QStringList profiles;
+    QStringList args = a.arguments();
+    for (int i = 1; i + 1 < args.size(); ++i) {
+        if (args.at(i) == "--profile") {
+            profiles << args.at(++i);
+        }
+    }
+
+    Daemon::installSignalHandlers();
+    Daemon d(args.contains("-v"), serverRole);
+    d.setPublicListen(args.contains("--public"));
+    if (!d.start(profiles)) {
+        return 1;
+    }
+    StartupTimer::mark("backends started");
+    QTimer::singleShot(0, [] { StartupTimer::mark("event loop"); });
+    return a.exec();
+}
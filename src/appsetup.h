@@ -0,0 +1,24 @@
+/*
+ * Application Setup
+ *
+ * The start-up steps ss-qt5 and the headless ss-qt5d share: translations,
+ * --trace and --record-traffic, and running profiles without a window.
+ */
+#ifndef APPSETUP_H
+#define APPSETUP_H
+#include <QCoreApplication>
+#include <QTranslator>
+
+namespace AppSetup
+{
+void setupApplication(QCoreApplication &a, QTranslator *qtTranslator, QTranslator *ssqt5Translator);
+
+/*
+ * --daemon [--profile <name>]... runs the given profiles, or the current
+ * one, without loading any widget or connecting to a display.
+ * --server [--profile <name>]... serves them instead, as a shadowsocks server.
+ */
+int runDaemon(int argc, char *argv[], bool serverRole);
+}
+
+#endif // APPSETUP_H
@@ -0,0 +1,249 @@
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QProcess>
+#include <QRegularExpression>
+#include <QStandardPaths>
+#include <QCoreApplication>
+#include <QtConcurrent>
+#include "backendregistry.h"
+
+const QStringList BackendRegistry::ExecNames = QStringList() << "ss-local" << "sslocal" << "shadowsocks-local"
+#ifdef Q_OS_WIN
+        << "python"//the Python port is run through its interpreter there
+#endif
+        ;
+
+BackendRegistry *BackendRegistry::instance()
+{
+    static BackendRegistry *registry = new BackendRegistry(QCoreApplication::instance());
+    return registry;
+}
+
+BackendRegistry::BackendRegistry(QObject *parent) :
+    QObject(parent),
+    m_rescanPending(false)
+{
+#ifdef Q_OS_WIN
+    m_preferredDirs << QCoreApplication::applicationDirPath();
+#else
+    m_preferredDirs << QDir::homePath() + "/.config/shadowsocks/bin";
+#endif
+
+    QStringList dirs = m_preferredDirs;
+    dirs << QString::fromLocal8Bit(qgetenv("PATH")).split(QDir::listSeparator(), QString::SkipEmptyParts);
+    dirs.removeDuplicates();
+    for (QStringList::const_iterator it = dirs.constBegin(); it != dirs.constEnd(); ++it) {
+        if (QFileInfo(*it).isDir()) {
+            m_watcher.addPath(*it);//inotify on Linux
+        }
+    }
+
+    m_rescan.setSingleShot(true);
+    m_rescan.setInterval(RescanDelayMSecs);//an installation touches many files
+    connect(&m_watcher, &QFileSystemWatcher::directoryChanged, this, &BackendRegistry::invalidate);
+    connect(&m_rescan, &QTimer::timeout, this, &BackendRegistry::startScan);
+    connect(&m_scan, &QFutureWatcher<void>::finished, this, &BackendRegistry::onScanFinished);
+    startScan();
+}
+
+BackendRegistry::~BackendRegistry()
+{
+    m_scan.waitForFinished();
+}
+
+QString BackendRegistry::lookup(const QString &execName, const QStringList &preferredDirs)
+{
+    QString path = QStandardPaths::findExecutable(execName, preferredDirs);//search ss-qt5 directory first
+    if (path.isEmpty()) {//if not found then search system's PATH
+        path = QStandardPaths::findExecutable(execName);
+    }
+    return path;
+}
+
+BackendInfo BackendRegistry::probeType(const QString &path)
+{
+    BackendInfo info;
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return info;
+    }
+
+    QString ident(file.readLine());
+    if (ident.contains("node")) {
+        info.typeID = 1;
+    }
+    else if (ident.contains("python") || path.endsWith(".py")) {
+        info.typeID = 3;
+    }
+    else if (path.contains("ss-local")) {
+        info.typeID = 0;//libev
+    }
+    else {
+        info.typeID = 2;//Go
+    }
+    return info;
+}
+
+bool BackendRegistry::isNamedLike(const QString &path, int typeID)
+{
+    QString name = QFileInfo(path).completeBaseName().toLower();
+    switch (typeID) {
+    case 0:
+        return name == "ss-local";
+    case 1:
+        return name == "sslocal";
+    case 2:
+        return name == "shadowsocks-local";
+    case 3:
+        return name == "sslocal" || name == "sslocal-script";
+    default:
+        return false;
+    }
+}
+
+BackendInfo BackendRegistry::probe(const QString &path)
+{
+    BackendInfo info = probeType(path);
+    //anything else only fell through the type check, running it would start an arbitrary program
+    if (info.typeID < 0 || !isNamedLike(path, info.typeID)) {
+        return info;
+    }
+
+    //every port prints its version somewhere in its usage or version output
+    QProcess proc;
+    proc.setProcessChannelMode(QProcess::MergedChannels);
+    if (path.endsWith(".py")) {
+        proc.start("python", QStringList() << path << "--version");
+    }
+    else {
+        proc.start(path, QStringList() << (info.typeID == 0 ? "-h" : (info.typeID == 2 ? "-version" : "--version")));
+    }
+    if (proc.waitForFinished(2000)) {
+        QRegularExpressionMatch m = QRegularExpression("\\d+\\.\\d+(\\.\\d+)?").match(QString::fromLocal8Bit(proc.readAll()));
+        if (m.hasMatch()) {
+            info.version = m.captured();
+        }
+    }
+    else {
+        proc.kill();
+        proc.waitForFinished(100);
+    }
+    return info;
+}
+
+void BackendRegistry::scan()
+{
+    QStringList paths;
+    {
+        //backends looked up on demand only had their type probed
+        QMutexLocker locker(&m_mutex);
+        for (QHash<QString, BackendInfo>::const_iterator it = m_infos.constBegin(); it != m_infos.constEnd(); ++it) {
+            if (it.value().version.isEmpty()) {
+                paths << it.key();
+            }
+        }
+    }
+
+    QHash<QString, QString> found;
+    for (QStringList::const_iterator it = ExecNames.constBegin(); it != ExecNames.constEnd(); ++it) {
+        QString path = lookup(*it, m_preferredDirs);
+        found.insert(*it, path);
+        if (!path.isEmpty()) {
+            paths << QFileInfo(path).absoluteFilePath();
+        }
+    }
+    paths.removeDuplicates();
+
+    QHash<QString, BackendInfo> infos;
+    for (QStringList::const_iterator it = paths.constBegin(); it != paths.constEnd(); ++it) {
+        infos.insert(*it, probe(*it));
+    }
+
+    QMutexLocker locker(&m_mutex);
+    m_found = found;
+    for (QHash<QString, BackendInfo>::const_iterator it = infos.constBegin(); it != infos.constEnd(); ++it) {
+        m_infos.insert(it.key(), it.value());
+    }
+}
+
+void BackendRegistry::startScan()
+{
+    if (m_scan.isRunning()) {
+        m_rescanPending = true;
+        return;
+    }
+    m_scan.setFuture(QtConcurrent::run(this, &BackendRegistry::scan));
+}
+
+void BackendRegistry::onScanFinished()
+{
+    if (m_rescanPending) {
+        m_rescanPending = false;
+        startScan();
+        return;
+    }
+    emit changed();
+}
+
+void BackendRegistry::invalidate()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_found.clear();
+        m_infos.clear();
+    }
+    m_rescan.start();
+}
+
+void BackendRegistry::watchDirOf(const QString &path)
+{
+    QString dir = QFileInfo(path).absolutePath();
+    if (!m_watcher.directories().contains(dir)) {
+        m_watcher.addPath(dir);
+    }
+}
+
+QString BackendRegistry::find(const QString &execName)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        QHash<QString, QString>::const_iterator it = m_found.constFind(execName);
+        if (it != m_found.constEnd()) {
+            return it.value();
+        }
+    }
+
+    //asked before the scan finished, or right after an invalidation
+    QString path = lookup(execName, m_preferredDirs);
+    QMutexLocker locker(&m_mutex);
+    m_found.insert(execName, path);
+    return path;
+}
+
+BackendInfo BackendRegistry::info(const QString &path)
+{
+    if (path.isEmpty()) {
+        return BackendInfo();
+    }
+    QString key = QFileInfo(path).absoluteFilePath();
+    {
+        QMutexLocker locker(&m_mutex);
+        QHash<QString, BackendInfo>::const_iterator it = m_infos.constFind(key);
+        if (it != m_infos.constEnd()) {
+            return it.value();
+        }
+    }
+
+    //the type is a single line to read, the version waits for the next scan
+    BackendInfo i = probeType(key);
+    watchDirOf(key);//a backend picked by hand may live anywhere
+    {
+        QMutexLocker locker(&m_mutex);
+        m_infos.insert(key, i);
+    }
+    if (i.typeID >= 0) {
+        m_rescan.start();
+    }
+    return i;
+}
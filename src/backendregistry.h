@@ -0,0 +1,70 @@
+/*
+ * Backend Registry Class
+ *
+ * Knows where each backend executable is and what it is.
+ * The search directories are scanned once on the thread pool, and the type
+ * and version of every backend found are cached by path. The directories
+ * are watched, so an installed or removed backend invalidates the cache and
+ * lookups never touch the filesystem in between.
+ */
+#ifndef BACKENDREGISTRY_H
+#define BACKENDREGISTRY_H
+#include <QObject>
+#include <QHash>
+#include <QMutex>
+#include <QTimer>
+#include <QStringList>
+#include <QFileSystemWatcher>
+#include <QFutureWatcher>
+
+struct BackendInfo
+{
+    int typeID;//as SSProfile::getBackendTypeID, -1 if the file doesn't exist
+    QString version;
+
+    BackendInfo() : typeID(-1) {}
+};
+
+class BackendRegistry : public QObject
+{
+    Q_OBJECT
+
+public:
+    static BackendRegistry *instance();
+    ~BackendRegistry();
+
+    QString find(const QString &execName);
+    BackendInfo info(const QString &path);
+
+    static const QStringList ExecNames;
+    static const int RescanDelayMSecs = 500;
+
+signals:
+    void changed();
+
+private:
+    BackendRegistry(QObject *parent = 0);
+
+    QFileSystemWatcher m_watcher;
+    QTimer m_rescan;
+    QFutureWatcher<void> m_scan;
+    bool m_rescanPending;
+    QStringList m_preferredDirs;
+    QMutex m_mutex;
+    QHash<QString, QString> m_found;//executable name to path, empty if not installed
+    QHash<QString, BackendInfo> m_infos;
+
+    void scan();
+    void watchDirOf(const QString &path);
+    static QString lookup(const QString &execName, const QStringList &preferredDirs);
+    static BackendInfo probeType(const QString &path);
+    static BackendInfo probe(const QString &path);//runs the backend for its version
+    static bool isNamedLike(const QString &path, int typeID);
+
+private slots:
+    void invalidate();
+    void startScan();
+    void onScanFinished();
+};
+
+#endif // BACKENDREGISTRY_H
@@ -0,0 +1,127 @@
+#include <QFileDialog>
+#include <QStandardPaths>
+#include <QDir>
+#include "batchexportdialogue.h"
+#include "ui_batchexportdialogue.h"
+
+BatchExportDialogue::BatchExportDialogue(Configuration *conf, QWidget *parent) :
+    QDialog(parent),
+    ui(new Ui::BatchExportDialogue),
+    m_conf(conf)
+{
+    ui->setupUi(this);
+
+    //only the names are needed here, so the profiles are not decoded yet
+    const ProfileStore *store = m_conf->profileStore();
+    for (int row = 0; row < store->count(); ++row) {
+        QListWidgetItem *item = new QListWidgetItem(store->header(store->idAt(row))->profileName, ui->profileList);
+        item->setData(Qt::UserRole, store->idAt(row));
+        item->setCheckState(Qt::Checked);
+    }
+    ui->pathEdit->setText(QDir(QStandardPaths::writableLocation(QStandardPaths::DocumentsLocation)).filePath("shadowsocks.png"));
+
+    connect(ui->checkAllButton, &QPushButton::clicked, this, [this] { setChecked(true); });
+    connect(ui->checkNoneButton, &QPushButton::clicked, this, [this] { setChecked(false); });
+    connect(ui->browseButton, &QToolButton::clicked, this, &BatchExportDialogue::onBrowseButtonClicked);
+    connect(ui->exportButton, &QPushButton::clicked, this, &BatchExportDialogue::onExportButtonClicked);
+    connect(ui->buttonBox, &QDialogButtonBox::rejected, this, &BatchExportDialogue::reject);
+    connect(&m_exporter, &QRBatchExporter::progress, this, &BatchExportDialogue::onProgress);
+    connect(&m_exporter, &QRBatchExporter::finished, this, &BatchExportDialogue::onFinished);
+}
+
+BatchExportDialogue::~BatchExportDialogue()
+{
+    delete ui;
+}
+
+void BatchExportDialogue::setChecked(bool checked)
+{
+    //with a selection, only the selected rows are toggled
+    QList<QListWidgetItem *> items = ui->profileList->selectedItems();
+    if (items.size() < 2) {
+        items.clear();
+        for (int row = 0; row < ui->profileList->count(); ++row) {
+            items << ui->profileList->item(row);
+        }
+    }
+    for (QList<QListWidgetItem *>::iterator it = items.begin(); it != items.end(); ++it) {
+        (*it)->setCheckState(checked ? Qt::Checked : Qt::Unchecked);
+    }
+}
+
+void BatchExportDialogue::onBrowseButtonClicked()
+{
+    QString path;
+    switch (ui->formatCombo->currentIndex()) {
+    case QRBatchExporter::Sheet:
+        path = QFileDialog::getSaveFileName(this, tr("Save Sheet"), ui->pathEdit->text(), tr("PNG Image (*.png)"));
+        break;
+    case QRBatchExporter::Files:
+        path = QFileDialog::getExistingDirectory(this, tr("Save to Directory"), QFileInfo(ui->pathEdit->text()).absolutePath());
+        break;
+    case QRBatchExporter::Html:
+        path = QFileDialog::getSaveFileName(this, tr("Save Page"), ui->pathEdit->text(), tr("HTML Page (*.html)"));
+        break;
+    }
+    if (!path.isEmpty()) {
+        ui->pathEdit->setText(path);
+    }
+}
+
+void BatchExportDialogue::onExportButtonClicked()
+{
+    QString path = ui->pathEdit->text().trimmed();
+    QRBatchExporter::Format format = static_cast<QRBatchExporter::Format>(ui->formatCombo->currentIndex());
+    if (path.isEmpty()) {
+        ui->statusLabel->setText(tr("Choose where to save first."));
+        return;
+    }
+    if (format == QRBatchExporter::Files && !QDir().mkpath(path)) {
+        ui->statusLabel->setText(tr("Cannot create %1").arg(path));
+        return;
+    }
+
+    //the links are cheap and need the profiles, which live on this thread
+    QVector<QRBatchExporter::Item> items;
+    for (int row = 0; row < ui->profileList->count(); ++row) {
+        QListWidgetItem *listItem = ui->profileList->item(row);
+        SSProfile *p = m_conf->profileStore()->profile(listItem->data(Qt::UserRole).toUInt());
+        if (listItem->checkState() != Qt::Checked || !p) {
+            continue;
+        }
+        QRBatchExporter::Item item;
+        item.index = items.size();
+        item.name = p->profileName;
+        item.uri = p->getSsUrl();
+        items << item;
+    }
+    if (items.isEmpty()) {
+        ui->statusLabel->setText(tr("No profile is checked."));
+        return;
+    }
+
+    ui->exportButton->setEnabled(false);
+    ui->progressBar->setRange(0, items.size());
+    ui->progressBar->setValue(0);
+    ui->statusLabel->setText(tr("Exporting..."));
+    m_exporter.start(items, format, path);
+}
+
+void BatchExportDialogue::onProgress(int done, int total)
+{
+    ui->progressBar->setRange(0, total);
+    ui->progressBar->setValue(done);
+}
+
+void BatchExportDialogue::onFinished(bool ok, const QString &message)
+{
+    ui->exportButton->setEnabled(true);
+    ui->progressBar->setValue(ok ? ui->progressBar->maximum() : 0);
+    ui->statusLabel->setText(message);
+}
+
+void BatchExportDialogue::reject()
+{
+    m_exporter.cancel();
+    QDialog::reject();
+}
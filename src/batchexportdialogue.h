@@ -0,0 +1,35 @@
+#ifndef BATCHEXPORTDIALOGUE_H
+#define BATCHEXPORTDIALOGUE_H
+
+#include <QDialog>
+#include "configuration.h"
+#include "qrbatchexporter.h"
+
+namespace Ui {
+class BatchExportDialogue;
+}
+
+class BatchExportDialogue : public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit BatchExportDialogue(Configuration *conf, QWidget *parent = 0);
+    ~BatchExportDialogue();
+
+private:
+    Ui::BatchExportDialogue *ui;
+    Configuration *m_conf;
+    QRBatchExporter m_exporter;
+
+    void setChecked(bool checked);
+
+private slots:
+    void onBrowseButtonClicked();
+    void onExportButtonClicked();
+    void onProgress(int done, int total);
+    void onFinished(bool ok, const QString &message);
+    void reject();
+};
+
+#endif // BATCHEXPORTDIALOGUE_H
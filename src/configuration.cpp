@@ -1,11 +1,16 @@
 #include <QFile>
 #include <QDir>
+#include <QCoreApplication>
 #include <QDebug>
 #include <QJsonDocument>
 #include <QJsonArray>
 #include <QJsonObject>
 #include <QJsonValue>
+#include <QCryptographicHash>
 #include "configuration.h"
+#include "configwriter.h"
+#include "profilecache.h"
+#include "tracer.h"
 
 #ifdef Q_OS_LINUX
 #include <sys/utsname.h>
@@ -25,11 +30,28 @@ Configuration::Configuration(const QString &file)
     QString linux_release(u.release);
     tfo_available = (linux_release.mid(2, 2).toFloat() >= 7 && linux_release.at(0) == '3') ? true : false;
 #endif
+    m_file = QDir::toNativeSeparators(file);
+    writer = new ConfigWriter(m_file);
     setJSONFile(file);
 }
 
 Configuration::~Configuration()
-{}
+{
+    delete writer;//writes out a pending save
+}
+
+QString Configuration::defaultFile()
+{
+#ifdef Q_OS_WIN
+    return QCoreApplication::applicationDirPath() + "/gui-config.json";
+#else
+    QDir ssConfigDir = QDir::homePath() + "/.config/shadowsocks";
+    if (!ssConfigDir.exists()) {
+        ssConfigDir.mkpath(ssConfigDir.absolutePath());
+    }
+    return ssConfigDir.absolutePath() + "/gui-config.json";
+#endif
+}
 
 void Configuration::setJSONFile(const QString &file)
 {
@@ -41,12 +63,24 @@ void Configuration::setJSONFile(const QString &file)
         autoHide = false;
         autoStart = false;
         debugLog = false;
-        m_index = -1;
+        m_current = 0;
         relativePath = false;
+        relayMode = false;
+        connectProbe = false;
+        metricsPort = 0;
         translucent = true;
         return;
     }
 
+    //the binary snapshot is only used while it matches gui-config.json byte for byte
+    ProfileCache::Snapshot snapshot;
+    if (ProfileCache::load(m_file, &snapshot)) {
+        profiles.replaceAll(snapshot.heads, snapshot.bodies, snapshot.offsets);
+        applySettings(snapshot.settings);
+        writer->setKnownHash(snapshot.hash);
+        return;
+    }
+
     JSONFile.open(QIODevice::ReadOnly | QIODevice::Text);
 
     if (!JSONFile.isOpen()) {
@@ -58,7 +92,8 @@ void Configuration::setJSONFile(const QString &file)
     }
 
     QJsonParseError pe;
-    QJsonDocument JSONDoc = QJsonDocument::fromJson(JSONFile.readAll(), &pe);
+    QByteArray raw = JSONFile.readAll();
+    QJsonDocument JSONDoc = QJsonDocument::fromJson(raw, &pe);
 
     if (pe.error != QJsonParseError::NoError) {
         qCritical() << pe.errorString();
@@ -70,60 +105,163 @@ void Configuration::setJSONFile(const QString &file)
 
     QJsonObject JSONObj = JSONDoc.object();
     QJsonArray CONFArray = JSONObj["configs"].toArray();
-    profileList.clear();//clear list before
+    QVector<SSProfile> loaded;
+    loaded.reserve(CONFArray.size());
     if (CONFArray.isEmpty()) {
         qWarning() << "configs is empty. Please check your gui-config.json";
-        m_index = -1;//apparently m_index is invalid.
     }
-    else {
-        for (QJsonArray::iterator it = CONFArray.begin(); it != CONFArray.end(); ++it) {
-            QJsonObject json = (*it).toObject();
-            SSProfile p;
-            p.backend = json["backend"].toString();
-            p.custom_arg = json["custom_arg"].toString();
-            p.local_addr = json["local_address"].toString();
-            p.local_port = json["local_port"].toString();
-            p.method = json["method"].toString().toUpper();//using Upper-case in GUI
-            p.password = json["password"].toString();
-            p.profileName = json["profile"].toString();
-            p.server = json["server"].toString();
-            p.server_port = json["server_port"].toString();
-            p.timeout = json["timeout"].toString();
-            p.type = json["type"].toString();
-            if (tfo_available) {
-                p.fast_open = json["fast_open"].toBool();
+    for (QJsonArray::iterator it = CONFArray.begin(); it != CONFArray.end(); ++it) {
+        loaded << profileFromJson((*it).toObject());
+    }
+    profiles.replaceAll(loaded);
+    applySettings(JSONObj);
+    JSONFile.close();
+
+    writer->setKnownHash(QCryptographicHash::hash(raw, QCryptographicHash::Md5));
+    if (pe.error == QJsonParseError::NoError) {
+        writer->writeCache(JSONObj, raw);
+    }
+}
+
+bool Configuration::isOwnContent(const QByteArray &json) const
+{
+    return writer->isKnown(json);
+}
+
+bool Configuration::sameProfile(const SSProfile &a, const SSProfile &b)
+{
+    //an empty backend in the file means "detect it", which leaves ours as it is
+    return (b.backend.isEmpty() || a.backend == b.backend) && a.custom_arg == b.custom_arg && a.fast_open == b.fast_open
+            && a.limits == b.limits && a.local_addr == b.local_addr && a.local_port == b.local_port && a.method == b.method && a.mux == b.mux && a.password == b.password
+            && a.plugin == b.plugin && a.plugin_opts == b.plugin_opts && a.plugin_trusted == b.plugin_trusted && a.profileName == b.profileName && a.server == b.server
+            && a.server_port == b.server_port && a.socket_options == b.socket_options && a.tag == b.tag && a.timeout == b.timeout && a.type == b.type;
+}
+
+QVector<ProfileId> Configuration::mergeReloaded(const QJsonObject &root, const QByteArray &json, int *added, int *removed, bool *currentReplaced)
+{
+    /*
+     * Profiles are matched by name and server; among duplicates, in order.
+     * Matched profiles are updated in place only if something differs, so
+     * the IDs, and the selection, of untouched profiles survive a reload.
+     */
+    QHash<QString, ProfileId> existing;//find() returns the last inserted, so walk backwards to match in display order
+    for (int row = profiles.count() - 1; row >= 0; --row) {
+        ProfileId id = profiles.idAt(row);
+        const SSProfile *p = profiles.header(id);
+        existing.insertMulti(p->profileName + QChar('\n') + p->server.toLower() + QChar(':') + p->server_port, id);
+    }
+
+    QVector<ProfileId> changed;
+    *added = 0;
+    *removed = 0;
+    QJsonArray CONFArray = root["configs"].toArray();
+    for (QJsonArray::iterator it = CONFArray.begin(); it != CONFArray.end(); ++it) {
+        SSProfile fresh = profileFromJson((*it).toObject());
+        QString key = fresh.profileName + QChar('\n') + fresh.server.toLower() + QChar(':') + fresh.server_port;
+        QHash<QString, ProfileId>::iterator match = existing.find(key);
+        if (match == existing.end()) {
+            profiles.append(fresh);
+            ++(*added);
+            continue;
+        }
+
+        ProfileId id = match.value();
+        existing.erase(match);
+        SSProfile *p = profiles.profile(id);
+        if (!sameProfile(*p, fresh)) {
+            if (fresh.backend.isEmpty()) {
+                fresh.backend = p->backend;
             }
-            profileList << p;
+            *p = fresh;
+            profiles.update(id);
+            changed << id;
         }
-        m_index = JSONObj["index"].toInt();
     }
-    autoHide = JSONObj["autoHide"].toBool();
-    autoStart = JSONObj["autoStart"].toBool();
-    debugLog = JSONObj["debug"].toBool();
-    relativePath = JSONObj["relative_path"].toBool();
-    translucent = JSONObj["translucent"].toBool();
-    JSONFile.close();
+
+    /*
+     * Pick the replacement for a vanishing current profile before removing
+     * anything, so no one observing the removals sees a dangling current ID.
+     */
+    *currentReplaced = false;
+    QList<ProfileId> leftovers = existing.values();
+    if (m_current != 0 && leftovers.contains(m_current)) {
+        m_current = 0;
+        for (int row = 0; row < profiles.count(); ++row) {
+            if (!leftovers.contains(profiles.idAt(row))) {
+                m_current = profiles.idAt(row);
+                break;
+            }
+        }
+        *currentReplaced = true;
+    }
+    for (QList<ProfileId>::const_iterator it = leftovers.constBegin(); it != leftovers.constEnd(); ++it) {
+        profiles.remove(*it);
+        ++(*removed);
+    }
+
+    writer->setKnownHash(QCryptographicHash::hash(json, QCryptographicHash::Md5));
+    writer->writeCache(root, json);
+    return changed;
 }
 
-int Configuration::count()
+SSProfile Configuration::profileFromJson(const QJsonObject &json)
 {
-    return profileList.count();
+    SSProfile p;
+    p.backend = json["backend"].toString();
+    p.custom_arg = json["custom_arg"].toString();
+    p.limits = TrafficLimits::fromJson(json["limits"].toObject());
+    p.local_addr = json["local_address"].toString();
+    p.local_port = json["local_port"].toString();
+    p.method = json["method"].toString().toUpper();//using Upper-case in GUI
+    p.mux = qBound(0, json["mux"].toInt(), 16);
+    p.password = json["password"].toString();
+    p.plugin = json["plugin"].toString();
+    p.plugin_opts = json["plugin_opts"].toString();
+    p.plugin_trusted = json["plugin_trusted"].toBool(true);
+    p.profileName = json["profile"].toString();
+    p.server = json["server"].toString();
+    p.server_port = json["server_port"].toString();
+    p.socket_options = SocketOptions::fromJson(json["socket_options"].toObject());
+    p.tag = json["tag"].toString();
+    p.timeout = json["timeout"].toString();
+    p.type = json["type"].toString();
+    if (tfo_available) {
+        p.fast_open = json["fast_open"].toBool();
+    }
+    return p;
 }
 
-QStringList Configuration::getProfileList()
+void Configuration::applySettings(const QJsonObject &JSONObj)
 {
-    QStringList s;
-    for (QList<SSProfile>::iterator it = profileList.begin(); it != profileList.end(); ++it) {
-        s << it->profileName;
+    //the file keeps the position of the current profile, there is none if the list is empty
+    m_current = profiles.idAt(JSONObj["index"].toInt());
+    autoHide = JSONObj["autoHide"].toBool();
+    autoStart = JSONObj["autoStart"].toBool();
+    metricsPort = JSONObj["metricsPort"].toInt();
+    debugLog = JSONObj["debug"].toBool();
+    relativePath = JSONObj["relative_path"].toBool();
+    relayMode = JSONObj["relay_mode"].toBool();
+    connectProbe = JSONObj["connect_probe"].toBool();
+    translucent = JSONObj["translucent"].toBool();
+
+    subscriptions.clear();
+    QJsonArray subArray = JSONObj["subscriptions"].toArray();
+    for (QJsonArray::iterator it = subArray.begin(); it != subArray.end(); ++it) {
+        QJsonObject json = (*it).toObject();
+        Subscription sub;
+        sub.name = json["name"].toString();
+        sub.url = json["url"].toString();
+        sub.intervalHours = json["interval"].toInt();
+        sub.lastUpdateMSecs = qint64(json["last_update"].toDouble());
+        subscriptions << sub;
     }
-    return s;
 }
 
-void Configuration::addProfile(const QString &pName)
+ProfileId Configuration::addProfile(const QString &pName)
 {
     SSProfile p;
     p.profileName = pName;
-    profileList << p;
+    ProfileId id = profiles.append(p);
 
     QJsonObject json;
     json["profile"] = QJsonValue(p.profileName);
@@ -138,59 +276,65 @@ void Configuration::addProfile(const QString &pName)
     if (tfo_available) {
         json["fast_open"] = QJsonValue(p.fast_open);
     }
+    return id;
 }
 
-void Configuration::addProfileFromSSURI(const QString &name, QString uri)
+ProfileId Configuration::addProfileFromSSURI(const QString &name, QString uri)
 {
     SSProfile p;
-    p.profileName = name;
-
-    uri.remove(0, 5);//remove the prefix "ss://" from uri
-    QStringList resultList = QString(QByteArray::fromBase64(QByteArray(uri.toStdString().c_str()))).split(':');
-    p.method = resultList.first().toUpper();
-    p.server_port = resultList.last();
-    QStringList ser = resultList.at(1).split('@');
-    p.server = ser.last();
-    ser.removeLast();
-    p.password = ser.join('@');//incase there is a '@' in password
-
-    QJsonObject json;
-    json["method"] = QJsonValue(p.method.toLower());
-    json["password"] = QJsonValue(p.password);
-    json["profile"] = QJsonValue(p.profileName);
-    json["server_port"] = QJsonValue(p.server_port);
-    json["server"] = QJsonValue(p.server);
-    //below are using default values
-    json["custom_arg"] = QJsonValue(p.custom_arg);
-    json["local_address"] = QJsonValue(p.local_addr);
-    json["local_port"] = QJsonValue(p.local_port);
-    json["timeout"] = QJsonValue(p.timeout);
-    json["type"] = QJsonValue(p.type);
-    if (tfo_available) {
-        json["fast_open"] = QJsonValue(p.fast_open);
+    if (!SSProfile::fromSsUrl(uri, &p)) {
+        qWarning() << "Invalid ss:// URI, adding an empty profile";
     }
-    profileList << p;
+    if (!name.isEmpty()) {
+        p.profileName = name;
+    }
+    return profiles.append(p);
 }
 
-void Configuration::deleteProfile(int index)
+void Configuration::deleteProfile(ProfileId id)
 {
-    profileList.removeAt(index);
+    if (id == m_current) {//move on before the entry is gone, 0 once the store is empty
+        int row = profiles.rowOf(id);
+        m_current = profiles.idAt(row + 1 < profiles.count() ? row + 1 : row - 1);
+    }
+    profiles.remove(id);
 }
 
 void Configuration::save()
 {
+    SS_TRACE_SCOPE("config save", "config");
     QJsonArray newConfArray;
-    for (QList<SSProfile>::iterator it = profileList.begin(); it != profileList.end(); ++it) {
+    for (int row = 0; row < profiles.count(); ++row) {
+        const SSProfile *it = profiles.profile(profiles.idAt(row));
         QJsonObject json;
         json["backend"] = QJsonValue(it->backend);
         json["custom_arg"] = QJsonValue(it->custom_arg);
+        if (!it->limits.isDefault()) {
+            json["limits"] = it->limits.toJson();
+        }
         json["local_address"] = QJsonValue(it->local_addr);
         json["local_port"] = QJsonValue(it->local_port);
         json["method"] = QJsonValue(it->method.isEmpty() ? QString("table") : it->method.toLower());//lower-case in config
+        if (it->mux > 0) {
+            json["mux"] = QJsonValue(it->mux);
+        }
         json["password"] = QJsonValue(it->password);
+        if (!it->plugin.isEmpty()) {
+            json["plugin"] = QJsonValue(it->plugin);
+            json["plugin_opts"] = QJsonValue(it->plugin_opts);
+            if (!it->plugin_trusted) {
+                json["plugin_trusted"] = QJsonValue(false);
+            }
+        }
         json["profile"] = QJsonValue(it->profileName);
         json["server_port"] = QJsonValue(it->server_port);
         json["server"] = QJsonValue(it->server);
+        if (!it->socket_options.isDefault()) {
+            json["socket_options"] = it->socket_options.toJson();
+        }
+        if (!it->tag.isEmpty()) {
+            json["tag"] = QJsonValue(it->tag);
+        }
         json["timeout"] = QJsonValue(it->timeout);
         json["type"] = QJsonValue(it->type);
         if (tfo_available) {
@@ -203,32 +347,33 @@ void Configuration::save()
     JSONObj["autoHide"] = QJsonValue(autoHide);
     JSONObj["autoStart"] = QJsonValue(autoStart);
     JSONObj["configs"] = QJsonValue(newConfArray);
+    JSONObj["connect_probe"] = QJsonValue(connectProbe);
     JSONObj["debug"] = QJsonValue(debugLog);
-    JSONObj["index"] = QJsonValue(m_index);
+    JSONObj["index"] = QJsonValue(profiles.rowOf(m_current));
+    JSONObj["metricsPort"] = QJsonValue(metricsPort);
     JSONObj["relative_path"] = QJsonValue(relativePath);
+    JSONObj["relay_mode"] = QJsonValue(relayMode);
     JSONObj["translucent"] = QJsonValue(translucent);
 
-    QJsonDocument JSONDoc(JSONObj);
-
-    QFile JSONFile(m_file);
-    JSONFile.open(QIODevice::WriteOnly | QIODevice::Text);
-    if (JSONFile.isWritable()) {
-        JSONFile.write(JSONDoc.toJson());
-    }
-    else {
-        qWarning() << "Warning: file is not writable!";
+    if (!subscriptions.isEmpty()) {
+        QJsonArray subArray;
+        for (SubscriptionList::const_iterator it = subscriptions.constBegin(); it != subscriptions.constEnd(); ++it) {
+            QJsonObject json;
+            json["name"] = QJsonValue(it->name);
+            json["url"] = QJsonValue(it->url);
+            json["interval"] = QJsonValue(it->intervalHours);
+            json["last_update"] = QJsonValue(double(it->lastUpdateMSecs));
+            subArray.append(QJsonValue(json));
+        }
+        JSONObj["subscriptions"] = QJsonValue(subArray);
     }
-    JSONFile.close();
-}
 
-void Configuration::setIndex(int index)
-{
-    m_index = index;
+    writer->schedule(JSONObj);
 }
 
-int Configuration::getIndex()
+void Configuration::flush()
 {
-    return m_index;
+    writer->flush();
 }
 
 bool Configuration::isDebug()
@@ -281,7 +426,38 @@ bool Configuration::isRelativePath()
     return relativePath;
 }
 
+void Configuration::setRelayMode(bool r)
+{
+    relayMode = r;
+}
+
+bool Configuration::isRelayMode()
+{
+    return relayMode;
+}
+
+void Configuration::setConnectProbe(bool p)
+{
+    connectProbe = p;
+}
+
+bool Configuration::isConnectProbe()
+{
+    return connectProbe;
+}
+
+void Configuration::setMetricsPort(int p)
+{
+    metricsPort = p;
+}
+
+int Configuration::getMetricsPort()
+{
+    return metricsPort;
+}
+
 void Configuration::revert()
 {
+    writer->flush();//a save may still be on its way to the file
     setJSONFile(m_file);
 }
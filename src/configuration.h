@@ -5,17 +5,22 @@
 #define CONFIGURATION_H
 #include <QString>
 #include <QStringList>
-#include <QList>
+#include <QJsonObject>
 #include "ssprofile.h"
+#include "profilestore.h"
+#include "subscription.h"
+
+class ConfigWriter;
 
 class Configuration
 {
 public:
     Configuration(const QString &file);
     ~Configuration();
+    static QString defaultFile();//creates the directory if needed
     void setJSONFile(const QString &);
-    void setIndex(int);
-    int getIndex();
+    inline ProfileId currentId() const { return m_current; }
+    inline void setCurrentId(ProfileId id) { m_current = id; }
     void setAutoStart(bool);
     bool isAutoStart();
     void setAutoHide(bool);
@@ -26,28 +31,51 @@ public:
     bool isTranslucent();
     void setRelativePath(bool);
     bool isRelativePath();
+    void setRelayMode(bool);
+    bool isRelayMode();
+    void setConnectProbe(bool);
+    bool isConnectProbe();
+    void setMetricsPort(int);
+    int getMetricsPort();
     inline bool isTFOAvailable() const { return tfo_available; }
-    int count();
-    QStringList getProfileList();
-    inline SSProfile *profileAt(int i) { return &profileList[i]; }
-    inline SSProfile *currentProfile() { return &profileList[m_index]; }
-    inline SSProfile *lastProfile() { return &profileList.last(); }
+    inline ProfileStore *profileStore() { return &profiles; }
+    inline SubscriptionList &subscriptionList() { return subscriptions; }
+    inline SSProfile *currentProfile() { return profiles.profile(m_current); }
     void revert();
-    void addProfile(const QString &);
-    void addProfileFromSSURI(const QString &, QString);
-    void deleteProfile(int);
-    void save();
+    ProfileId addProfile(const QString &);
+    ProfileId addProfileFromSSURI(const QString &, QString);
+    void deleteProfile(ProfileId);//the next profile, or the previous, becomes current if id was
+    static SSProfile profileFromJson(const QJsonObject &json);
+    static bool sameProfile(const SSProfile &a, const SSProfile &b);
+    inline const QString &file() const { return m_file; }
+    bool isOwnContent(const QByteArray &json) const;
+    /*
+     * Applies the profiles of a gui-config.json changed by someone else.
+     * Returns the profiles that were modified in place. If the current
+     * profile was dropped, another one is made current and currentReplaced
+     * is set.
+     */
+    QVector<ProfileId> mergeReloaded(const QJsonObject &root, const QByteArray &json, int *added, int *removed, bool *currentReplaced);
+    void save();//returns at once, the file is written shortly after on another thread
+    void flush();
 
 private:
-    int m_index;
+    ProfileId m_current;
     bool debugLog;
     bool autoHide;
     bool autoStart;
     bool translucent;
     bool relativePath;
-    QList<SSProfile> profileList;
+    bool relayMode;
+    bool connectProbe;
+    int metricsPort;
+    ProfileStore profiles;
+    SubscriptionList subscriptions;
     QString m_file;
+    ConfigWriter *writer;
     static bool tfo_available;
+
+    void applySettings(const QJsonObject &JSONObj);
 };
 
 #endif // CONFIGURATION_H
@@ -0,0 +1,104 @@
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QtConcurrent>
+#include <QDebug>
+#include "configwatcher.h"
+
+ConfigWatcher::ConfigWatcher(Configuration *conf, QObject *parent) :
+    QObject(parent),
+    m_conf(conf),
+    m_reparse(false)
+{
+    QFileInfo info(m_conf->file());
+    m_lastSize = info.size();
+    m_lastModified = info.lastModified();
+
+    /*
+     * Saving by rename, as we do and most tools do, replaces the watched
+     * file, so the directory is watched too to pick the new one up.
+     */
+    m_watcher.addPath(info.absolutePath());
+    if (info.exists()) {
+        m_watcher.addPath(info.absoluteFilePath());
+    }
+
+    m_settle.setSingleShot(true);
+    m_settle.setInterval(SettleMSecs);
+    connect(&m_watcher, &QFileSystemWatcher::fileChanged, this, &ConfigWatcher::onPathChanged);
+    connect(&m_watcher, &QFileSystemWatcher::directoryChanged, this, &ConfigWatcher::onPathChanged);
+    connect(&m_settle, &QTimer::timeout, this, &ConfigWatcher::startParse);
+    connect(&m_parse, &QFutureWatcher<Parsed>::finished, this, &ConfigWatcher::onParsed);
+}
+
+void ConfigWatcher::onPathChanged()
+{
+    QFileInfo info(m_conf->file());
+    if (!info.exists()) {
+        return;//in the middle of a rename, the directory will change again
+    }
+    if (!m_watcher.files().contains(info.absoluteFilePath())) {
+        m_watcher.addPath(info.absoluteFilePath());
+    }
+    //the directory also changes for files we don't care about, like the cache
+    if (info.size() == m_lastSize && info.lastModified() == m_lastModified) {
+        return;
+    }
+    m_lastSize = info.size();
+    m_lastModified = info.lastModified();
+    m_settle.start();
+}
+
+ConfigWatcher::Parsed ConfigWatcher::parse(const QString &file)
+{
+    Parsed p;
+    QFile f(file);
+    if (!f.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return p;
+    }
+    p.json = f.readAll();
+    QJsonParseError pe;
+    QJsonDocument doc = QJsonDocument::fromJson(p.json, &pe);
+    if (pe.error != QJsonParseError::NoError) {
+        qWarning() << "Warning: not reloading" << file << pe.errorString();
+        return p;
+    }
+    p.root = doc.object();
+    p.ok = true;
+    return p;
+}
+
+void ConfigWatcher::reloadNow()
+{
+    m_settle.stop();
+    startParse();
+}
+
+void ConfigWatcher::startParse()
+{
+    if (m_parse.isRunning()) {
+        m_reparse = true;
+        return;
+    }
+    m_parse.setFuture(QtConcurrent::run(&ConfigWatcher::parse, m_conf->file()));
+}
+
+void ConfigWatcher::onParsed()
+{
+    if (m_reparse) {//changed again while parsing, only the newest version matters
+        m_reparse = false;
+        startParse();
+        return;
+    }
+
+    Parsed p = m_parse.result();
+    if (!p.ok || m_conf->isOwnContent(p.json)) {
+        return;
+    }
+
+    int added, removed;
+    bool currentReplaced;
+    emit aboutToReload();
+    QVector<ProfileId> changed = m_conf->mergeReloaded(p.root, p.json, &added, &removed, &currentReplaced);
+    emit profilesReloaded(changed, added, removed, currentReplaced);
+}
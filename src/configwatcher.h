@@ -0,0 +1,59 @@
+/*
+ * Config Watcher Class
+ *
+ * Notices when gui-config.json is changed by another program, such as a
+ * configuration management tool, parses it on the thread pool, and merges
+ * the profiles that differ into the running configuration.
+ * Our own saves are recognized by their hash and ignored.
+ */
+#ifndef CONFIGWATCHER_H
+#define CONFIGWATCHER_H
+#include <QObject>
+#include <QTimer>
+#include <QDateTime>
+#include <QFileSystemWatcher>
+#include <QFutureWatcher>
+#include <QJsonObject>
+#include "configuration.h"
+
+class ConfigWatcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Parsed
+    {
+        bool ok;
+        QByteArray json;
+        QJsonObject root;
+
+        Parsed() : ok(false) {}
+    };
+
+    ConfigWatcher(Configuration *conf, QObject *parent = 0);
+    static Parsed parse(const QString &file);
+    void reloadNow();//without waiting for the file system to report a change
+
+    static const int SettleMSecs = 200;
+
+signals:
+    //profilesReloaded() always follows aboutToReload(), even if nothing changed
+    void aboutToReload();
+    void profilesReloaded(const QVector<ProfileId> &changed, int added, int removed, bool currentReplaced);
+
+private:
+    Configuration *m_conf;
+    QFileSystemWatcher m_watcher;
+    QTimer m_settle;
+    QFutureWatcher<Parsed> m_parse;
+    qint64 m_lastSize;
+    QDateTime m_lastModified;
+    bool m_reparse;
+
+private slots:
+    void onPathChanged();
+    void startParse();
+    void onParsed();
+};
+
+#endif // CONFIGWATCHER_H
@@ -0,0 +1,147 @@
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QJsonDocument>
+#include <QCryptographicHash>
+#include <QDebug>
+#include "configwriter.h"
+#include "tracer.h"
+#include "profilecache.h"
+
+#ifdef Q_OS_WIN
+#include <io.h>
+#else
+#include <unistd.h>
+#include <fcntl.h>
+#endif
+
+ConfigWriter::ConfigWriter(const QString &file, QObject *parent) :
+    QObject(parent),
+    m_hasPending(false)
+{
+    m_debounce.setSingleShot(true);
+    m_debounce.setInterval(DebounceMSecs);
+    connect(&m_debounce, &QTimer::timeout, this, &ConfigWriter::onDebounceTimeout);
+
+    m_worker = new ConfigWriterWorker(file);
+    m_worker->moveToThread(&m_thread);
+    connect(&m_thread, &QThread::finished, m_worker, &QObject::deleteLater);
+    connect(m_worker, &ConfigWriterWorker::written, this, &ConfigWriter::onWritten);
+    m_thread.start(QThread::LowPriority);
+}
+
+ConfigWriter::~ConfigWriter()
+{
+    flush();
+    m_thread.quit();
+    m_thread.wait();
+}
+
+void ConfigWriter::schedule(const QJsonObject &doc)
+{
+    m_pending = doc;
+    m_hasPending = true;
+    m_debounce.start();//restarting pushes the write back
+}
+
+void ConfigWriter::onDebounceTimeout()
+{
+    if (!m_hasPending) {
+        return;
+    }
+    //QJsonObject is implicitly shared, handing it over copies nothing
+    QMetaObject::invokeMethod(m_worker, "write", Qt::QueuedConnection, Q_ARG(QJsonObject, m_pending));
+    m_pending = QJsonObject();
+    m_hasPending = false;
+}
+
+bool ConfigWriter::isKnown(const QByteArray &json) const
+{
+    return !m_knownHash.isEmpty() && QCryptographicHash::hash(json, QCryptographicHash::Md5) == m_knownHash;
+}
+
+void ConfigWriter::writeCache(const QJsonObject &doc, const QByteArray &json)
+{
+    QMetaObject::invokeMethod(m_worker, "cache", Qt::QueuedConnection, Q_ARG(QJsonObject, doc), Q_ARG(QByteArray, json));
+}
+
+void ConfigWriter::flush()
+{
+    m_debounce.stop();
+    onDebounceTimeout();
+    QMetaObject::invokeMethod(m_worker, "sync", Qt::BlockingQueuedConnection);
+}
+
+ConfigWriterWorker::ConfigWriterWorker(const QString &file, QObject *parent) :
+    QObject(parent),
+    m_file(file),
+    m_lastKnown(false)
+{}
+
+void ConfigWriterWorker::write(const QJsonObject &doc)
+{
+    SS_TRACE_SCOPE("config write", "config");
+    QByteArray data = QJsonDocument(doc).toJson();
+
+    if (!m_lastKnown) {
+        QFile current(m_file);
+        if (current.open(QIODevice::ReadOnly)) {
+            m_lastWritten = current.readAll();
+        }
+        m_lastKnown = true;
+    }
+    if (data == m_lastWritten) {
+        return;
+    }
+
+    if (writeAtomically(m_file, data)) {
+        m_lastWritten = data;
+        emit written(QCryptographicHash::hash(data, QCryptographicHash::Md5));
+        ProfileCache::write(m_file, doc, data);
+    }
+}
+
+void ConfigWriterWorker::cache(const QJsonObject &doc, const QByteArray &json)
+{
+    SS_TRACE_SCOPE("profile cache write", "config");
+    m_lastWritten = json;//also tells the next save what the file holds now
+    m_lastKnown = true;
+    ProfileCache::write(m_file, doc, json);
+}
+
+void ConfigWriterWorker::sync()
+{}
+
+bool ConfigWriterWorker::writeAtomically(const QString &file, const QByteArray &data)
+{
+    QSaveFile out(file);
+    if (!out.open(QIODevice::WriteOnly)) {
+        qWarning() << "Warning: file is not writable!" << out.errorString();
+        return false;
+    }
+    out.write(data);
+    if (!out.flush()) {
+        qWarning() << "Warning: cannot write" << file << out.errorString();
+        out.cancelWriting();
+        return false;
+    }
+#ifdef Q_OS_WIN
+    _commit(out.handle());
+#else
+    fsync(out.handle());
+#endif
+    if (!out.commit()) {
+        qWarning() << "Warning: cannot replace" << file << out.errorString();
+        return false;
+    }
+
+#ifndef Q_OS_WIN
+    //make the rename itself durable
+    int dir = ::open(QFile::encodeName(QFileInfo(file).absolutePath()).constData(), O_RDONLY);
+    if (dir >= 0) {
+        fsync(dir);
+        ::close(dir);
+    }
+#endif
+    return true;
+}
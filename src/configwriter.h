@@ -0,0 +1,70 @@
+/*
+ * Config Writer Class
+ *
+ * Persists gui-config.json off the GUI thread.
+ * Saves requested within DebounceMSecs of each other are coalesced into one
+ * write; the document is serialized on the writer thread and replaces the
+ * file atomically (temporary file, fsync, rename), so a crash leaves either
+ * the old or the new configuration on disk. Unchanged bytes are not written.
+ */
+#ifndef CONFIGWRITER_H
+#define CONFIGWRITER_H
+#include <QObject>
+#include <QThread>
+#include <QTimer>
+#include <QJsonObject>
+#include <QByteArray>
+
+class ConfigWriterWorker;
+
+class ConfigWriter : public QObject
+{
+    Q_OBJECT
+
+public:
+    ConfigWriter(const QString &file, QObject *parent = 0);
+    ~ConfigWriter();
+    void schedule(const QJsonObject &doc);
+    void flush();//write anything pending now and wait until it's on disk
+    void writeCache(const QJsonObject &doc, const QByteArray &json);//json is the file's current content
+    inline void setKnownHash(const QByteArray &md5) { m_knownHash = md5; }
+    bool isKnown(const QByteArray &json) const;//whether json is what we loaded or wrote last
+
+    static const int DebounceMSecs = 300;
+
+private:
+    QThread m_thread;
+    ConfigWriterWorker *m_worker;
+    QTimer m_debounce;
+    QJsonObject m_pending;
+    bool m_hasPending;
+    QByteArray m_knownHash;
+
+private slots:
+    void onDebounceTimeout();
+    inline void onWritten(const QByteArray &md5) { m_knownHash = md5; }
+};
+
+class ConfigWriterWorker : public QObject
+{
+    Q_OBJECT
+
+public:
+    ConfigWriterWorker(const QString &file, QObject *parent = 0);
+    static bool writeAtomically(const QString &file, const QByteArray &data);
+
+public slots:
+    void write(const QJsonObject &doc);
+    void cache(const QJsonObject &doc, const QByteArray &json);
+    void sync();//no-op, queued behind the writes to wait for them
+
+signals:
+    void written(const QByteArray &md5);
+
+private:
+    QString m_file;
+    QByteArray m_lastWritten;
+    bool m_lastKnown;
+};
+
+#endif // CONFIGWRITER_H
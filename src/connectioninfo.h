@@ -0,0 +1,86 @@
+/*
+ * Connection statistics shared between the relay workers and the GUI.
+ */
+#ifndef CONNECTIONINFO_H
+#define CONNECTIONINFO_H
+#include <QString>
+#include <QVector>
+#include <QMetaType>
+#include <atomic>
+
+struct ConnectionInfo
+{
+    quint64 id;
+    QString client;
+    QString destination;
+    quint64 bytesUp;
+    quint64 bytesDown;
+    quint32 rateUp;//bytes per second
+    quint32 rateDown;
+    qint64 startMSecs;
+};
+
+typedef QVector<ConnectionInfo> ConnectionInfoList;
+typedef QVector<quint64> ConnectionIdList;
+
+struct RelayTotals
+{
+    quint64 bytesUp;
+    quint64 bytesDown;
+    quint64 sessions;
+    quint32 active;
+    quint64 shaped;//bytes that waited for rate limit tokens
+    quint64 rejected;//sessions refused over the session limit
+
+    RelayTotals() : bytesUp(0), bytesDown(0), sessions(0), active(0), shaped(0), rejected(0) {}
+
+    RelayTotals &operator+=(const RelayTotals &o)
+    {
+        bytesUp += o.bytesUp;
+        bytesDown += o.bytesDown;
+        sessions += o.sessions;
+        active += o.active;
+        shaped += o.shaped;
+        rejected += o.rejected;
+        return *this;
+    }
+
+    RelayTotals &operator-=(const RelayTotals &o)
+    {
+        bytesUp -= o.bytesUp;
+        bytesDown -= o.bytesDown;
+        sessions -= o.sessions;
+        shaped -= o.shaped;
+        rejected -= o.rejected;
+        return *this;//active is a gauge, it is left alone
+    }
+};
+
+/*
+ * Written only by the owning worker thread with relaxed atomics and read by
+ * whoever aggregates. Padded to its own cache line so that two workers never
+ * bounce the same line.
+ */
+struct alignas(64) WorkerCounters
+{
+    std::atomic<quint64> bytesUp;
+    std::atomic<quint64> bytesDown;
+    std::atomic<quint64> sessions;
+    std::atomic<quint32> active;
+    std::atomic<quint64> shaped;
+
+    WorkerCounters() : bytesUp(0), bytesDown(0), sessions(0), active(0), shaped(0) {}
+
+    void addTo(RelayTotals &t) const
+    {
+        t.bytesUp += bytesUp.load(std::memory_order_relaxed);
+        t.bytesDown += bytesDown.load(std::memory_order_relaxed);
+        t.sessions += sessions.load(std::memory_order_relaxed);
+        t.active += active.load(std::memory_order_relaxed);
+        t.shaped += shaped.load(std::memory_order_relaxed);
+    }
+};
+
+Q_DECLARE_METATYPE(ConnectionInfo)
+
+#endif // CONNECTIONINFO_H
@@ -0,0 +1,162 @@
+#include <QDateTime>
+#include <algorithm>
+#include <functional>
+#include "connectionmodel.h"
+
+ConnectionModel::ConnectionModel(QObject *parent) :
+    QAbstractTableModel(parent)
+{}
+
+int ConnectionModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_rows.size();
+}
+
+int ConnectionModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : ColumnCount;
+}
+
+QString ConnectionModel::formatBytes(quint64 bytes)
+{
+    if (bytes < 1024) {
+        return QString("%1 B").arg(bytes);
+    }
+    if (bytes < 1024 * 1024) {
+        return QString("%1 KiB").arg(bytes / 1024.0, 0, 'f', 1);
+    }
+    if (bytes < Q_UINT64_C(1024) * 1024 * 1024) {
+        return QString("%1 MiB").arg(bytes / (1024.0 * 1024), 0, 'f', 1);
+    }
+    return QString("%1 GiB").arg(bytes / (1024.0 * 1024 * 1024), 0, 'f', 2);
+}
+
+QVariant ConnectionModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= m_rows.size()) {
+        return QVariant();
+    }
+    if (role == Qt::TextAlignmentRole) {
+        return index.column() >= UpColumn ? int(Qt::AlignRight | Qt::AlignVCenter) : int(Qt::AlignLeft | Qt::AlignVCenter);
+    }
+    if (role != Qt::DisplayRole) {
+        return QVariant();
+    }
+
+    const ConnectionInfo &c = m_rows[index.row()];
+    switch (index.column()) {
+    case ClientColumn:
+        return c.client;
+    case DestinationColumn:
+        return c.destination;
+    case UpColumn:
+        return formatBytes(c.bytesUp);
+    case DownColumn:
+        return formatBytes(c.bytesDown);
+    case RateColumn:
+        return QString("%1/s / %2/s").arg(formatBytes(c.rateUp)).arg(formatBytes(c.rateDown));
+    default:
+        qint64 secs = (QDateTime::currentMSecsSinceEpoch() - c.startMSecs) / 1000;
+        return QString("%1:%2").arg(secs / 60).arg(secs % 60, 2, 10, QChar('0'));
+    }
+}
+
+QVariant ConnectionModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole) {
+        return QVariant();
+    }
+
+    switch (section) {
+    case ClientColumn:
+        return tr("Client");
+    case DestinationColumn:
+        return tr("Destination");
+    case UpColumn:
+        return tr("Sent");
+    case DownColumn:
+        return tr("Received");
+    case RateColumn:
+        return tr("Rate");
+    default:
+        return tr("Age");
+    }
+}
+
+void ConnectionModel::applyDelta(const ConnectionInfoList &changed, const ConnectionIdList &closed)
+{
+    removeRows(closed);
+
+    int first = m_rows.size();
+    int last = -1;
+    ConnectionInfoList added;
+    for (ConnectionInfoList::const_iterator it = changed.constBegin(); it != changed.constEnd(); ++it) {
+        QHash<quint64, int>::const_iterator row = m_rowOf.constFind(it->id);
+        if (row == m_rowOf.constEnd()) {
+            added.append(*it);
+            continue;
+        }
+        m_rows[row.value()] = *it;
+        first = qMin(first, row.value());
+        last = qMax(last, row.value());
+    }
+    if (last >= 0) {
+        emit dataChanged(index(first, 0), index(last, RateColumn));
+    }
+
+    if (!added.isEmpty()) {
+        beginInsertRows(QModelIndex(), m_rows.size(), m_rows.size() + added.size() - 1);
+        for (ConnectionInfoList::const_iterator it = added.constBegin(); it != added.constEnd(); ++it) {
+            m_rowOf.insert(it->id, m_rows.size());
+            m_rows.append(*it);
+        }
+        endInsertRows();
+    }
+
+    if (!m_rows.isEmpty()) {
+        emit dataChanged(index(0, AgeColumn), index(m_rows.size() - 1, AgeColumn));
+    }
+}
+
+void ConnectionModel::removeRows(const ConnectionIdList &ids)
+{
+    QVector<int> rows;
+    rows.reserve(ids.size());
+    for (ConnectionIdList::const_iterator it = ids.constBegin(); it != ids.constEnd(); ++it) {
+        QHash<quint64, int>::const_iterator row = m_rowOf.constFind(*it);
+        if (row != m_rowOf.constEnd()) {
+            rows.append(row.value());
+        }
+    }
+    if (rows.isEmpty()) {
+        return;
+    }
+    std::sort(rows.begin(), rows.end(), std::greater<int>());
+
+    //remove from the bottom up, one contiguous range at a time
+    int i = 0;
+    while (i < rows.size()) {
+        int last = rows[i];
+        int first = last;
+        while (i + 1 < rows.size() && rows[i + 1] == first - 1) {
+            first = rows[++i];
+        }
+        ++i;
+        beginRemoveRows(QModelIndex(), first, last);
+        m_rows.remove(first, last - first + 1);
+        endRemoveRows();
+    }
+
+    m_rowOf.clear();
+    for (int r = 0; r < m_rows.size(); ++r) {
+        m_rowOf.insert(m_rows[r].id, r);
+    }
+}
+
+void ConnectionModel::clear()
+{
+    beginResetModel();
+    m_rows.clear();
+    m_rowOf.clear();
+    endResetModel();
+}
@@ -0,0 +1,48 @@
+/*
+ * Connection Model Class
+ *
+ * Table of the sessions of the running profile.
+ * It is fed with the deltas published by the relay workers.
+ */
+#ifndef CONNECTIONMODEL_H
+#define CONNECTIONMODEL_H
+
+#include <QAbstractTableModel>
+#include <QHash>
+#include "connectioninfo.h"
+
+class ConnectionModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    explicit ConnectionModel(QObject *parent = 0);
+    int rowCount(const QModelIndex &parent = QModelIndex()) const;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const;
+
+    static QString formatBytes(quint64 bytes);
+
+public slots:
+    void applyDelta(const ConnectionInfoList &changed, const ConnectionIdList &closed);
+    void clear();
+
+private:
+    enum Column {
+        ClientColumn = 0,
+        DestinationColumn,
+        UpColumn,
+        DownColumn,
+        RateColumn,
+        AgeColumn,
+        ColumnCount
+    };
+
+    QVector<ConnectionInfo> m_rows;
+    QHash<quint64, int> m_rowOf;
+
+    void removeRows(const ConnectionIdList &ids);
+};
+
+#endif // CONNECTIONMODEL_H
@@ -0,0 +1,27 @@
+#include <QAbstractItemModel>
+#include "connectionspanel.h"
+#include "ui_connectionspanel.h"
+
+ConnectionsPanel::ConnectionsPanel(QAbstractItemModel *connections, QWidget *parent) :
+    QWidget(parent),
+    ui(new Ui::ConnectionsPanel)
+{
+    ui->setupUi(this);
+    ui->connectionView->setModel(connections);
+    connect(ui->exportLatencyButton, &QPushButton::clicked, this, &ConnectionsPanel::exportLatencyRequested);
+}
+
+ConnectionsPanel::~ConnectionsPanel()
+{
+    delete ui;
+}
+
+void ConnectionsPanel::setSummary(const QString &text)
+{
+    ui->connectionSummaryLabel->setText(text);
+}
+
+void ConnectionsPanel::setLatency(const QString &html)
+{
+    ui->latencyLabel->setText(html);
+}
@@ -0,0 +1,35 @@
+/*
+ * Connections Panel Class
+ *
+ * The contents of the Connections tab: the live connection table, the
+ * relay's summary line and the latency percentiles. MainWindow builds it
+ * the first time the tab is opened.
+ */
+#ifndef CONNECTIONSPANEL_H
+#define CONNECTIONSPANEL_H
+#include <QWidget>
+
+class QAbstractItemModel;
+
+namespace Ui {
+class ConnectionsPanel;
+}
+
+class ConnectionsPanel : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit ConnectionsPanel(QAbstractItemModel *connections, QWidget *parent = 0);
+    ~ConnectionsPanel();
+    void setSummary(const QString &text);
+    void setLatency(const QString &html);
+
+signals:
+    void exportLatencyRequested();
+
+private:
+    Ui::ConnectionsPanel *ui;
+};
+
+#endif // CONNECTIONSPANEL_H
@@ -0,0 +1,60 @@
+#include "connectprobe.h"
+
+const int ConnectProbe::ProbeInterval = 30000;
+const int ConnectProbe::ProbeTimeout = 10000;
+
+ConnectProbe::ConnectProbe(QObject *parent) :
+    QObject(parent),
+    m_socket(this),
+    m_interval(this),
+    m_timeout(this),
+    m_port(0),
+    m_sink(0)
+{
+    m_interval.setInterval(ProbeInterval);
+    m_timeout.setInterval(ProbeTimeout);
+    m_timeout.setSingleShot(true);
+    connect(&m_interval, &QTimer::timeout, this, &ConnectProbe::probe);
+    connect(&m_timeout, &QTimer::timeout, &m_socket, &QTcpSocket::abort);
+    connect(&m_socket, &QTcpSocket::hostFound, this, &ConnectProbe::onHostFound);
+    connect(&m_socket, &QTcpSocket::connected, this, &ConnectProbe::onConnected);
+}
+
+void ConnectProbe::start(const QString &host, quint16 port, LatencyHistogram *sink)
+{
+    m_host = host;
+    m_port = port;
+    m_sink = sink;
+    m_interval.start();
+    probe();
+}
+
+void ConnectProbe::stop()
+{
+    m_interval.stop();
+    m_timeout.stop();
+    m_socket.abort();
+    m_sink = 0;
+}
+
+void ConnectProbe::probe()
+{
+    m_socket.abort();
+    m_elapsed.start();
+    m_timeout.start();
+    m_socket.connectToHost(m_host, m_port);
+}
+
+void ConnectProbe::onHostFound()
+{
+    m_elapsed.start();//the lookup is done, only the connect is timed
+}
+
+void ConnectProbe::onConnected()
+{
+    m_timeout.stop();
+    if (m_sink) {
+        m_sink->record(m_elapsed.nsecsElapsed() / 1000);
+    }
+    m_socket.abort();
+}
@@ -0,0 +1,43 @@
+/*
+ * Connect Probe Class
+ *
+ * Periodically measures how long a TCP connect to the profile's server takes,
+ * from the end of the DNS lookup to the handshake, so that a slow resolver
+ * doesn't show up as a slow server. Opt-in, it opens connections of its own.
+ */
+#ifndef CONNECTPROBE_H
+#define CONNECTPROBE_H
+#include <QObject>
+#include <QTcpSocket>
+#include <QTimer>
+#include <QElapsedTimer>
+#include "latencyhistogram.h"
+
+class ConnectProbe : public QObject
+{
+    Q_OBJECT
+
+public:
+    ConnectProbe(QObject *parent = 0);
+    void start(const QString &host, quint16 port, LatencyHistogram *sink);
+    void stop();
+
+    static const int ProbeInterval;
+    static const int ProbeTimeout;
+
+private:
+    QTcpSocket m_socket;
+    QTimer m_interval;
+    QTimer m_timeout;
+    QElapsedTimer m_elapsed;
+    QString m_host;
+    quint16 m_port;
+    LatencyHistogram *m_sink;
+
+private slots:
+    void probe();
+    void onHostFound();
+    void onConnected();
+};
+
+#endif // CONNECTPROBE_H
@@ -0,0 +1,309 @@
+#include <QLocalSocket>
+#include <QJsonDocument>
+#include <QJsonArray>
+#include <QStandardPaths>
+#include <QDir>
+#include <QDebug>
+#include "ss_process.h"
+#include "controlserver.h"
+
+ControlServer::ControlServer(Configuration *conf, ControlTarget *target, QObject *parent) :
+    QObject(parent),
+    m_conf(conf),
+    m_target(target)
+{
+    m_server.setSocketOptions(QLocalServer::UserAccessOption);
+    m_statsTimer.setInterval(StatsIntervalMSecs);
+    connect(&m_server, &QLocalServer::newConnection, this, &ControlServer::onNewConnection);
+    connect(&m_statsTimer, &QTimer::timeout, this, &ControlServer::onStatsTimeout);
+}
+
+QString ControlServer::serverName(bool serverRole)
+{
+    //one instance per user, the GUI and the daemon share the name
+#ifdef Q_OS_WIN
+    QString name = QString("shadowsocks-qt5-%1").arg(QString::fromLocal8Bit(qgetenv("USERNAME")));
+#else
+    //a full path keeps the socket out of the shared temporary directory, where anyone could take the name first
+    QString dir = QStandardPaths::writableLocation(QStandardPaths::RuntimeLocation);
+    if (dir.isEmpty()) {
+        dir = QDir::homePath();
+    }
+    QString name = dir + QString("/shadowsocks-qt5");
+#endif
+    return serverRole ? name + "-server" : name;
+}
+
+bool ControlServer::isInstanceRunning(bool serverRole)
+{
+    QLocalSocket probe;
+    probe.connectToServer(serverName(serverRole));
+    return probe.waitForConnected(100);
+}
+
+bool ControlServer::listen(bool serverRole)
+{
+    QString name = serverName(serverRole);
+    QLocalSocket probe;
+    probe.connectToServer(name);
+    if (probe.waitForConnected(100)) {
+        qWarning() << "Warning: control socket unavailable, another instance is listening on" << name;
+        return false;
+    }
+    if (probe.error() == QLocalSocket::ConnectionRefusedError) {//left behind by an instance that crashed
+        QLocalServer::removeServer(name);
+    }
+    if (!m_server.listen(name)) {
+        qWarning() << "Warning: control socket unavailable," << m_server.errorString();
+        return false;
+    }
+    return true;
+}
+
+void ControlServer::close()
+{
+    m_server.close();
+    m_statsTimer.stop();
+    //disconnected() may fire right away and take the client out of m_clients
+    QList<QLocalSocket *> sockets = m_clients.keys();
+    for (QList<QLocalSocket *>::const_iterator it = sockets.constBegin(); it != sockets.constEnd(); ++it) {
+        (*it)->disconnectFromServer();
+    }
+}
+
+void ControlServer::onNewConnection()
+{
+    while (m_server.hasPendingConnections()) {
+        QLocalSocket *socket = m_server.nextPendingConnection();
+        m_clients.insert(socket, Client());
+        connect(socket, &QLocalSocket::readyRead, this, &ControlServer::onReadyRead);
+        connect(socket, &QLocalSocket::disconnected, this, [this, socket] {
+            m_clients.remove(socket);
+            socket->deleteLater();
+        });
+    }
+}
+
+void ControlServer::onReadyRead()
+{
+    QLocalSocket *socket = qobject_cast<QLocalSocket *>(sender());
+    while (socket && socket->canReadLine()) {
+        QJsonParseError pe;
+        QJsonDocument doc = QJsonDocument::fromJson(socket->readLine(), &pe);
+        QJsonObject r;
+        if (pe.error != QJsonParseError::NoError || !doc.isObject()) {
+            r["ok"] = false;
+            r["error"] = pe.errorString();
+        } else {
+            r = handle(socket, doc.object());
+        }
+        send(socket, r);
+    }
+    if (socket && (socket->bytesAvailable() > MaxLineBytes || socket->bytesToWrite() > MaxQueuedBytes)) {
+        qWarning() << "Control client misbehaves, disconnecting it";
+        socket->abort();
+    }
+}
+
+ProfileId ControlServer::findProfile(const QJsonObject &request, QString *error) const
+{
+    QString name = request["profile"].toString();
+    if (name.isEmpty()) {
+        return 0;
+    }
+    QVector<ProfileId> found = m_conf->profileStore()->findByName(name);
+    if (found.isEmpty()) {
+        *error = QString("no profile named %1").arg(name);
+        return 0;
+    }
+    return found.first();
+}
+
+QJsonObject ControlServer::listProfiles() const
+{
+    //headers only, listing doesn't decode the profiles
+    const ProfileStore *store = m_conf->profileStore();
+    QJsonArray list;
+    for (int row = 0; row < store->count(); ++row) {
+        ProfileId id = store->idAt(row);
+        const SSProfile *p = store->header(id);
+        QJsonObject profile;
+        profile["profile"] = p->profileName;
+        profile["server"] = p->server;
+        profile["server_port"] = p->server_port;
+        if (!p->tag.isEmpty()) {
+            profile["tag"] = p->tag;
+        }
+        if (id == m_conf->currentId()) {
+            profile["current"] = true;
+        }
+        list.append(profile);
+    }
+    QJsonObject r;
+    r["profiles"] = list;
+    return r;
+}
+
+QJsonObject ControlServer::handle(QLocalSocket *socket, const QJsonObject &request)
+{
+    QString cmd = request["cmd"].toString();
+    QString error;
+    QJsonObject r;
+    bool ok = true;
+
+    if (cmd == "list-profiles") {
+        r = listProfiles();
+    } else if (cmd == "status") {
+        r = m_target->status();
+    } else if (cmd == "stats") {
+        r["stats"] = m_target->stats();
+    } else if (cmd == "start" || cmd == "stop" || cmd == "switch") {
+        ProfileId id = findProfile(request, &error);
+        if (!error.isEmpty()) {
+            ok = false;
+        } else if (cmd == "start") {
+            ok = m_target->startProfile(id, &error);
+        } else if (cmd == "stop") {
+            m_target->stopProfile(id);
+        } else if (id == 0) {
+            ok = false;
+            error = QString("switch needs a profile");
+        } else {
+            ok = m_target->switchProfile(id, &error);
+        }
+    } else if (cmd == "subscribe" || cmd == "unsubscribe") {
+        Client &client = m_clients[socket];
+        QJsonArray events = request["events"].toArray();
+        if (cmd == "unsubscribe" && events.isEmpty()) {
+            client.topics.clear();
+        }
+        for (QJsonArray::const_iterator it = events.constBegin(); it != events.constEnd(); ++it) {
+            if (cmd == "subscribe") {
+                client.topics.insert((*it).toString());
+            } else {
+                client.topics.remove((*it).toString());
+            }
+        }
+        if (!client.topics.contains("stats")) {
+            client.lastStats = QJsonObject();//a new subscription starts with a full snapshot
+        } else if (!m_statsTimer.isActive()) {
+            m_statsTimer.start();
+        }
+        r["events"] = QJsonArray::fromStringList(client.topics.toList());
+    } else {
+        ok = false;
+        error = QString("unknown command");
+    }
+
+    r["reply"] = cmd;
+    r["ok"] = ok;
+    if (!error.isEmpty()) {
+        r["error"] = error;
+    }
+    return r;
+}
+
+void ControlServer::publish(const QString &topic, const QJsonObject &event)
+{
+    QList<QLocalSocket *> stalled;
+    for (QHash<QLocalSocket *, Client>::const_iterator it = m_clients.constBegin(); it != m_clients.constEnd(); ++it) {
+        if (!it->topics.contains(topic)) {
+            continue;
+        }
+        if (it.key()->bytesToWrite() > MaxQueuedBytes) {
+            stalled.append(it.key());
+        } else {
+            send(it.key(), event);
+        }
+    }
+    abortStalled(stalled);
+}
+
+QJsonObject ControlServer::statsDelta(const QJsonObject &previous, const QJsonObject &current)
+{
+    QJsonObject delta;
+    for (QJsonObject::const_iterator it = current.constBegin(); it != current.constEnd(); ++it) {
+        QJsonObject now = it.value().toObject();
+        QJsonObject before = previous.value(it.key()).toObject();
+        QJsonObject changed;
+        for (QJsonObject::const_iterator f = now.constBegin(); f != now.constEnd(); ++f) {
+            if (before.value(f.key()) != f.value()) {
+                changed.insert(f.key(), f.value());
+            }
+        }
+        if (!changed.isEmpty()) {
+            delta.insert(it.key(), changed);
+        }
+    }
+    //null marks a profile that is no longer running
+    for (QJsonObject::const_iterator it = previous.constBegin(); it != previous.constEnd(); ++it) {
+        if (!current.contains(it.key())) {
+            delta.insert(it.key(), QJsonValue());
+        }
+    }
+    return delta;
+}
+
+void ControlServer::onStatsTimeout()
+{
+    QJsonObject current;
+    bool watched = false;
+    QList<QLocalSocket *> stalled;
+    for (QHash<QLocalSocket *, Client>::iterator it = m_clients.begin(); it != m_clients.end(); ++it) {
+        if (!it->topics.contains("stats")) {
+            continue;
+        }
+        if (it.key()->bytesToWrite() > MaxQueuedBytes) {
+            stalled.append(it.key());
+            continue;
+        }
+        if (!watched) {//collected once per tick, however many clients watch
+            current = m_target->stats();
+            watched = true;
+        }
+        QJsonObject delta = statsDelta(it->lastStats, current);
+        it->lastStats = current;
+        if (!delta.isEmpty()) {
+            QJsonObject event;
+            event["event"] = QString("stats");
+            event["delta"] = delta;
+            send(it.key(), event);
+        }
+    }
+    abortStalled(stalled);
+    if (!watched) {
+        m_statsTimer.stop();
+    }
+}
+
+QJsonObject ControlServer::processStats(const SS_Process *proc)
+{
+    return totalsStats(proc->isRunning(), proc->relay()->totals());
+}
+
+QJsonObject ControlServer::totalsStats(bool running, const RelayTotals &t)
+{
+    QJsonObject s;
+    s["running"] = running;
+    s["bytes_up"] = double(t.bytesUp);
+    s["bytes_down"] = double(t.bytesDown);
+    s["sessions"] = double(t.sessions);
+    s["active"] = double(t.active);
+    s["shaped_bytes"] = double(t.shaped);
+    s["rejected_sessions"] = double(t.rejected);
+    return s;
+}
+
+void ControlServer::send(QLocalSocket *socket, const QJsonObject &message)
+{
+    socket->write(QJsonDocument(message).toJson(QJsonDocument::Compact) + '\n');
+}
+
+void ControlServer::abortStalled(const QList<QLocalSocket *> &sockets)
+{
+    //outside the loops over m_clients, disconnected() takes the client out of it
+    for (QList<QLocalSocket *>::const_iterator it = sockets.constBegin(); it != sockets.constEnd(); ++it) {
+        qWarning() << "Control client stopped reading, disconnecting it";
+        (*it)->abort();
+    }
+}
@@ -0,0 +1,94 @@
+/*
+ * Control Server Class
+ *
+ * Local control API, one JSON object per line over a per-user local socket
+ * (a Unix domain socket on Unix, a named pipe on Windows).
+ *
+ * Requests:   {"cmd": "list-profiles" | "status" | "start" | "stop" | "switch"
+ *                     | "stats" | "subscribe" | "unsubscribe",
+ *              "profile": <name>, "events": ["state", "log", "stats"]}
+ * Replies:    {"reply": <cmd>, "ok": true|false, "error": <text>, ...}
+ * Events:     {"event": "started" | "stopped" | "log" | "stats", ...}
+ *
+ * Stats events only carry the counters that changed since the previous
+ * event sent to that client, so watching many instances stays cheap.
+ * A client that sends an overlong line, or stops reading while events
+ * queue up for it, is disconnected.
+ */
+#ifndef CONTROLSERVER_H
+#define CONTROLSERVER_H
+#include <QObject>
+#include <QLocalServer>
+#include <QJsonObject>
+#include <QHash>
+#include <QSet>
+#include <QTimer>
+#include "configuration.h"
+#include "connectioninfo.h"
+
+class QLocalSocket;
+class SS_Process;
+
+class ControlTarget
+{
+public:
+    virtual ~ControlTarget() {}
+    //0 means the current profile
+    virtual bool startProfile(ProfileId id, QString *error) = 0;
+    //0 means every running profile
+    virtual void stopProfile(ProfileId id) = 0;
+    //makes id the current profile, restarting it if the previous one was running
+    virtual bool switchProfile(ProfileId id, QString *error) = 0;
+    //{"instances": [{"profile", "running", "pid"}]}
+    virtual QJsonObject status() const = 0;
+    //{<profile name>: {"bytes_up", "bytes_down", "sessions", "active"}}
+    virtual QJsonObject stats() const = 0;
+};
+
+class ControlServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    ControlServer(Configuration *conf, ControlTarget *target, QObject *parent = 0);
+    bool listen(bool serverRole = false);
+    void close();
+    void publish(const QString &topic, const QJsonObject &event);
+
+    //a server daemon has a socket of its own, so that a GUI never attaches to it
+    static QString serverName(bool serverRole = false);
+    static bool isInstanceRunning(bool serverRole = false);
+    static QJsonObject processStats(const SS_Process *proc);
+    static QJsonObject totalsStats(bool running, const RelayTotals &t);
+
+    static const int StatsIntervalMSecs = 1000;
+    static const qint64 MaxLineBytes = 64 * 1024;
+    static const qint64 MaxQueuedBytes = 1024 * 1024;
+
+private:
+    struct Client
+    {
+        QSet<QString> topics;
+        QJsonObject lastStats;
+    };
+
+    Configuration *m_conf;
+    ControlTarget *m_target;
+    QLocalServer m_server;
+    QHash<QLocalSocket *, Client> m_clients;
+    QTimer m_statsTimer;
+
+    QJsonObject handle(QLocalSocket *socket, const QJsonObject &request);
+    ProfileId findProfile(const QJsonObject &request, QString *error) const;
+    QJsonObject listProfiles() const;
+    static void send(QLocalSocket *socket, const QJsonObject &message);
+    static void abortStalled(const QList<QLocalSocket *> &sockets);
+    static QJsonObject statsDelta(const QJsonObject &previous, const QJsonObject &current);
+
+private slots:
+    void onNewConnection();
+    void onReadyRead();
+    void onStatsTimeout();
+};
+
+#endif // CONTROLSERVER_H
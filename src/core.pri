@@ -0,0 +1,32 @@
+#-------------------------------------------------
+#
+#  What ss-qt5 and the headless ss-qt5d share:
+#  the proxy engine, configuration, daemon and
+#  control socket, nothing that needs a display
+#
+#-------------------------------------------------
+
+include($$PWD/proxy.pri)
+
+SOURCES      += $$PWD/configuration.cpp \
+                $$PWD/logfile.cpp \
+                $$PWD/configwriter.cpp \
+                $$PWD/profilestore.cpp \
+                $$PWD/profilecache.cpp \
+                $$PWD/configwatcher.cpp \
+                $$PWD/daemon.cpp \
+                $$PWD/controlserver.cpp \
+                $$PWD/startuptimer.cpp \
+                $$PWD/appsetup.cpp
+
+HEADERS      += $$PWD/configuration.h \
+                $$PWD/logfile.h \
+                $$PWD/configwriter.h \
+                $$PWD/profilestore.h \
+                $$PWD/subscription.h \
+                $$PWD/profilecache.h \
+                $$PWD/configwatcher.h \
+                $$PWD/daemon.h \
+                $$PWD/controlserver.h \
+                $$PWD/startuptimer.h \
+                $$PWD/appsetup.h
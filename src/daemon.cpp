@@ -0,0 +1,385 @@
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QSocketNotifier>
+#include <QJsonArray>
+#include <QDebug>
+#include "daemon.h"
+#include "startuptimer.h"
+#include "ssvalidator.h"
+
+#ifdef Q_OS_UNIX
+#include <sys/socket.h>
+#include <signal.h>
+#include <unistd.h>
+#endif
+
+int Daemon::s_signalFd[2] = { -1, -1 };
+
+Daemon::Daemon(bool verbose, bool serverRole, QObject *parent) :
+    QObject(parent),
+    m_verbose(verbose),
+    m_serverRole(serverRole),
+    m_publicListen(false),
+    m_signalNotifier(0)
+{
+    m_conf = new Configuration(Configuration::defaultFile());
+    StartupTimer::mark("configuration");
+    m_watcher = new ConfigWatcher(m_conf, this);
+    connect(m_watcher, &ConfigWatcher::profilesReloaded, this, &Daemon::onProfilesReloaded);
+    m_control = new ControlServer(m_conf, this, this);
+
+    if (s_signalFd[1] >= 0) {
+        m_signalNotifier = new QSocketNotifier(s_signalFd[1], QSocketNotifier::Read, this);
+        connect(m_signalNotifier, &QSocketNotifier::activated, this, &Daemon::onSignal);
+    }
+
+    m_drainTimer.setInterval(200);
+    connect(&m_drainTimer, &QTimer::timeout, this, &Daemon::onDrainTick);
+}
+
+Daemon::~Daemon()
+{
+    while (!m_instances.isEmpty()) {
+        stopInstance(m_instances.size() - 1);
+    }
+    delete m_control;
+    delete m_watcher;
+    delete m_conf;
+}
+
+bool Daemon::installSignalHandlers()
+{
+#ifdef Q_OS_UNIX
+    /*
+     * Only async-signal-safe calls are allowed in a signal handler, so the
+     * handler just writes the signal number to a socket pair and the event
+     * loop picks it up from there.
+     */
+    if (::socketpair(AF_UNIX, SOCK_STREAM, 0, s_signalFd) != 0) {
+        qWarning() << "Warning: cannot create the signal socket pair";
+        return false;
+    }
+    struct sigaction sa;
+    sa.sa_handler = &Daemon::unixSignalHandler;
+    sigemptyset(&sa.sa_mask);
+    sa.sa_flags = SA_RESTART;
+    return sigaction(SIGHUP, &sa, 0) == 0 && sigaction(SIGTERM, &sa, 0) == 0 && sigaction(SIGINT, &sa, 0) == 0;
+#else
+    return false;
+#endif
+}
+
+void Daemon::unixSignalHandler(int sig)
+{
+#ifdef Q_OS_UNIX
+    char c = char(sig);
+    ssize_t r = ::write(s_signalFd[0], &c, 1);
+    Q_UNUSED(r);
+#else
+    Q_UNUSED(sig);
+#endif
+}
+
+void Daemon::onSignal()
+{
+#ifdef Q_OS_UNIX
+    m_signalNotifier->setEnabled(false);
+    char c;
+    if (::read(s_signalFd[1], &c, 1) == 1) {
+        if (c == SIGHUP) {
+            qDebug() << "SIGHUP received, reloading" << m_conf->file();
+            m_watcher->reloadNow();
+        } else {
+            drain();
+        }
+    }
+    m_signalNotifier->setEnabled(true);
+#endif
+}
+
+bool Daemon::start(const QStringList &profileNames)
+{
+    if (ControlServer::isInstanceRunning(m_serverRole)) {
+        qCritical() << "Error: shadowsocks-qt5 is already running for this user";
+        return false;
+    }
+    m_control->listen(m_serverRole);
+    if (m_serverRole && !m_publicListen) {
+        qWarning() << "The built-in server is meant for testing, it only listens on loopback. Pass --public to accept other hosts";
+    }
+
+    QVector<ProfileId> ids;
+    if (profileNames.isEmpty()) {
+        if (m_conf->currentId() != 0) {
+            ids << m_conf->currentId();
+        }
+    }
+    for (QStringList::const_iterator it = profileNames.constBegin(); it != profileNames.constEnd(); ++it) {
+        QVector<ProfileId> found = m_conf->profileStore()->findByName(*it);
+        if (found.isEmpty()) {
+            qCritical() << "Error: no profile named" << *it;
+            return false;
+        }
+        ids << found.first();
+    }
+    if (ids.isEmpty()) {
+        qCritical() << "Error: no profile to start";
+        return false;
+    }
+
+    for (QVector<ProfileId>::const_iterator it = ids.constBegin(); it != ids.constEnd(); ++it) {
+        if (indexOf(*it) < 0 && !startInstance(*it)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Daemon::startInstance(ProfileId id)
+{
+    SSProfile *p = m_conf->profileStore()->profile(id);
+    if (!p) {
+        return false;
+    }
+    Instance inst;
+    inst.id = id;
+    inst.proc = 0;
+    inst.server = 0;
+    if (m_serverRole) {
+        return startServer(inst, p);
+    }
+
+    if (p->backend.isEmpty()) {
+        p->setBackend(m_conf->isRelativePath());
+    }
+    if (!p->isValid()) {
+        qCritical() << "Error: invalid profile or backend:" << p->profileName;
+        return false;
+    }
+    if (!p->plugin.isEmpty() && !p->plugin_trusted) {//nobody to ask, confirm it in the GUI or set plugin_trusted
+        qCritical() << "Error: the plugin of" << p->profileName << "hasn't been confirmed:" << p->plugin;
+        return false;
+    }
+
+    inst.proc = new SS_Process(this);
+    inst.log = new LogFile(this);
+    const QString name = p->profileName;
+    if (inst.log->open(LogFile::pathForProfile(m_conf->file(), name))) {
+        inst.log->write(QString("---- %1 Starting profile %2 ----\n").arg(QDateTime::currentDateTime().toString(Qt::ISODate)).arg(name).toLocal8Bit());
+    }
+
+    LogFile *log = inst.log;
+    SS_Process *proc = inst.proc;
+    connect(proc, &SS_Process::readReadyProcess, this, [this, log, name](const QByteArray &o) {
+        log->write(o);
+        if (m_verbose) {
+            qDebug() << name << o.trimmed();
+        }
+        QJsonObject event;
+        event["event"] = QString("log");
+        event["profile"] = name;
+        event["line"] = QString::fromLocal8Bit(o);
+        m_control->publish("log", event);
+    });
+    connect(proc, &SS_Process::sigstart, this, [this, proc, name] {
+        QJsonObject event;
+        event["event"] = QString("started");
+        event["profile"] = name;
+        event["pid"] = double(proc->pid());
+        m_control->publish("state", event);
+    });
+    connect(proc, &SS_Process::sigstop, this, [this, name] {
+        QJsonObject event;
+        event["event"] = QString("stopped");
+        event["profile"] = name;
+        m_control->publish("state", event);
+    });
+
+    m_instances << inst;
+    proc->setRelayMode(m_conf->isRelayMode());
+    proc->setConnectProbe(m_conf->isConnectProbe());
+    proc->start(p, m_conf->isDebug());
+    return true;
+}
+
+bool Daemon::startServer(Instance &inst, SSProfile *p)
+{
+    if (!SSValidator::validatePort(p->server_port) || p->server_port.toInt() == 0 || p->password.isEmpty()) {
+        qCritical() << "Error: invalid profile:" << p->profileName;
+        return false;
+    }
+    inst.server = new SSServer(this);
+    if (!inst.server->start(*p, m_publicListen)) {
+        qCritical() << "Error: cannot serve profile" << p->profileName;
+        delete inst.server;
+        return false;
+    }
+
+    //there is no backend output, the log only records the runs
+    inst.log = new LogFile(this);
+    if (inst.log->open(LogFile::pathForProfile(m_conf->file(), p->profileName))) {
+        inst.log->write(QString("---- %1 Serving profile %2 on port %3 ----\n").arg(QDateTime::currentDateTime().toString(Qt::ISODate)).arg(p->profileName).arg(inst.server->serverPort()).toLocal8Bit());
+    }
+    qDebug() << "Serving" << p->profileName << "on port" << inst.server->serverPort() << "with" << p->method;
+    m_instances << inst;
+
+    QJsonObject event;
+    event["event"] = QString("started");
+    event["profile"] = p->profileName;
+    event["pid"] = double(QCoreApplication::applicationPid());
+    m_control->publish("state", event);
+    return true;
+}
+
+void Daemon::stopInstance(int index)
+{
+    Instance inst = m_instances.takeAt(index);
+    if (inst.server) {
+        inst.server->stop();
+        QJsonObject event;
+        event["event"] = QString("stopped");
+        event["profile"] = m_conf->profileStore()->header(inst.id) ? m_conf->profileStore()->header(inst.id)->profileName : QString();
+        m_control->publish("state", event);
+    } else {
+        inst.proc->stop();
+    }
+    inst.log->close();
+    delete inst.proc;
+    delete inst.server;
+    delete inst.log;
+}
+
+int Daemon::indexOf(ProfileId id) const
+{
+    for (int i = 0; i < m_instances.size(); ++i) {
+        if (m_instances.at(i).id == id) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+void Daemon::drain()
+{
+    if (m_drainTimer.isActive()) {//asked twice, don't wait any longer
+        qDebug() << "Stopping now";
+        m_drainElapsed.invalidate();
+        onDrainTick();
+        return;
+    }
+    qDebug() << "Draining sessions, send the signal again to stop at once";
+    m_control->close();
+    for (QVector<Instance>::iterator it = m_instances.begin(); it != m_instances.end(); ++it) {
+        if (it->server) {
+            it->server->stopAccepting();
+        } else {
+            it->proc->relay()->stopAccepting();
+        }
+    }
+    m_drainElapsed.start();
+    m_drainTimer.start();
+    onDrainTick();
+}
+
+void Daemon::onDrainTick()
+{
+    //without relay mode the sessions belong to the backend, there is nothing to wait for
+    quint32 active = 0;
+    for (QVector<Instance>::const_iterator it = m_instances.constBegin(); it != m_instances.constEnd(); ++it) {
+        active += it->server ? it->server->totals().active : it->proc->relay()->activeSessions();
+    }
+    if (active > 0 && m_drainElapsed.isValid() && m_drainElapsed.elapsed() < DrainMSecs) {
+        return;
+    }
+    if (active > 0) {
+        qWarning() << "Warning: closing" << active << "sessions that did not finish in time";
+    }
+    m_drainTimer.stop();
+    while (!m_instances.isEmpty()) {
+        stopInstance(m_instances.size() - 1);
+    }
+    QCoreApplication::quit();
+}
+
+void Daemon::onProfilesReloaded(const QVector<ProfileId> &changed, int added, int removed, bool)
+{
+    if (changed.isEmpty() && added == 0 && removed == 0) {
+        return;
+    }
+    qDebug() << "Reloaded:" << changed.size() << "changed," << added << "added," << removed << "removed";
+    for (int i = m_instances.size() - 1; i >= 0; --i) {
+        ProfileId id = m_instances.at(i).id;
+        if (m_conf->profileStore()->rowOf(id) < 0) {
+            stopInstance(i);
+        } else if (changed.contains(id)) {
+            stopInstance(i);
+            startInstance(id);
+        }
+    }
+}
+
+QJsonObject Daemon::status() const
+{
+    QJsonArray running;
+    for (QVector<Instance>::const_iterator it = m_instances.constBegin(); it != m_instances.constEnd(); ++it) {
+        QJsonObject inst;
+        inst["profile"] = m_conf->profileStore()->header(it->id)->profileName;
+        inst["running"] = it->server ? it->server->isListening() : it->proc->isRunning();
+        inst["pid"] = double(it->server ? QCoreApplication::applicationPid() : it->proc->pid());
+        running.append(inst);
+    }
+    QJsonObject s;
+    s["instances"] = running;
+    return s;
+}
+
+bool Daemon::startProfile(ProfileId id, QString *error)
+{
+    if (id == 0) {
+        id = m_conf->currentId();
+    }
+    if (id == 0) {
+        *error = QString("no profile to start");
+        return false;
+    }
+    if (indexOf(id) >= 0) {
+        return true;
+    }
+    if (!startInstance(id)) {
+        *error = QString("invalid profile or backend");
+        return false;
+    }
+    return true;
+}
+
+void Daemon::stopProfile(ProfileId id)
+{
+    for (int i = m_instances.size() - 1; i >= 0; --i) {
+        if (id == 0 || m_instances.at(i).id == id) {
+            stopInstance(i);
+        }
+    }
+}
+
+bool Daemon::switchProfile(ProfileId id, QString *error)
+{
+    //failover: whatever ran is replaced by the new profile
+    bool wasRunning = !m_instances.isEmpty();
+    stopProfile(0);
+    m_conf->setCurrentId(id);
+    return !wasRunning || startProfile(id, error);
+}
+
+QJsonObject Daemon::stats() const
+{
+    QJsonObject s;
+    for (QVector<Instance>::const_iterator it = m_instances.constBegin(); it != m_instances.constEnd(); ++it) {
+        QString name = m_conf->profileStore()->header(it->id)->profileName;
+        if (it->server) {
+            s[name] = ControlServer::totalsStats(it->server->isListening(), it->server->totals());
+        } else {
+            s[name] = ControlServer::processStats(it->proc);
+        }
+    }
+    return s;
+}
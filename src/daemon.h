@@ -0,0 +1,85 @@
+/*
+ * Daemon Class
+ *
+ * Runs profiles without any widget, for headless gateways.
+ * SIGHUP reloads gui-config.json, SIGTERM and SIGINT stop accepting new
+ * clients and let the open sessions drain before the backends are stopped.
+ * It is driven through the control socket, which is also how a GUI started
+ * later attaches instead of running a backend of its own, see DaemonLink.
+ * In the server role, profiles are served by the built-in SSServer instead
+ * of being started as clients.
+ */
+#ifndef DAEMON_H
+#define DAEMON_H
+#include <QObject>
+#include <QVector>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QJsonObject>
+#include "configuration.h"
+#include "configwatcher.h"
+#include "controlserver.h"
+#include "ss_process.h"
+#include "ssserver.h"
+#include "logfile.h"
+
+class QSocketNotifier;
+
+class Daemon : public QObject, public ControlTarget
+{
+    Q_OBJECT
+
+public:
+    Daemon(bool verbose, bool serverRole = false, QObject *parent = 0);
+    ~Daemon();
+
+    //profile names, or the current profile if empty
+    bool start(const QStringList &profileNames);
+    //the built-in server listens on loopback only, unless this is set (--public)
+    inline void setPublicListen(bool p) { m_publicListen = p; }
+    static bool installSignalHandlers();
+
+    bool startProfile(ProfileId id, QString *error);
+    void stopProfile(ProfileId id);
+    bool switchProfile(ProfileId id, QString *error);
+    QJsonObject status() const;
+    QJsonObject stats() const;
+
+    static const int DrainMSecs = 10000;
+
+private:
+    struct Instance
+    {
+        ProfileId id;
+        SS_Process *proc;//one of proc and server, depending on the role
+        SSServer *server;
+        LogFile *log;
+    };
+
+    bool m_verbose;
+    bool m_serverRole;
+    bool m_publicListen;
+    Configuration *m_conf;
+    ConfigWatcher *m_watcher;
+    QVector<Instance> m_instances;
+    ControlServer *m_control;
+    QSocketNotifier *m_signalNotifier;
+    QTimer m_drainTimer;
+    QElapsedTimer m_drainElapsed;
+
+    static int s_signalFd[2];
+    static void unixSignalHandler(int sig);
+
+    bool startInstance(ProfileId id);
+    bool startServer(Instance &inst, SSProfile *p);
+    void stopInstance(int index);
+    int indexOf(ProfileId id) const;
+    void drain();
+
+private slots:
+    void onSignal();
+    void onDrainTick();
+    void onProfilesReloaded(const QVector<ProfileId> &changed, int added, int removed, bool currentReplaced);
+};
+
+#endif // DAEMON_H
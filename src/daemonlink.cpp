@@ -0,0 +1,91 @@
+#include <QJsonDocument>
+#include <QJsonArray>
+#include "controlserver.h"
+#include "daemonlink.h"
+
+DaemonLink::DaemonLink(QObject *parent) :
+    QObject(parent),
+    m_running(false)
+{
+    connect(&m_socket, &QLocalSocket::readyRead, this, &DaemonLink::onReadyRead);
+    connect(&m_socket, &QLocalSocket::disconnected, this, [this] {
+        m_running = false;
+        emit detached();
+    });
+}
+
+bool DaemonLink::attach()
+{
+    m_socket.connectToServer(ControlServer::serverName());
+    if (!m_socket.waitForConnected(AttachTimeoutMSecs)) {
+        m_socket.abort();
+        return false;
+    }
+    QJsonObject subscribe;
+    subscribe["cmd"] = QString("subscribe");
+    subscribe["events"] = QJsonArray() << QString("state") << QString("log");
+    send(subscribe);
+    QJsonObject request;
+    request["cmd"] = QString("status");
+    send(request);
+    return true;
+}
+
+void DaemonLink::start(const QString &profileName)
+{
+    QJsonObject request;
+    request["cmd"] = QString("start");
+    request["profile"] = profileName;
+    m_profile = profileName;
+    send(request);
+}
+
+void DaemonLink::stop()
+{
+    QJsonObject request;
+    request["cmd"] = QString("stop");
+    if (!m_profile.isEmpty()) {//leave the daemon's other profiles running
+        request["profile"] = m_profile;
+    }
+    send(request);
+}
+
+void DaemonLink::send(const QJsonObject &request)
+{
+    m_socket.write(QJsonDocument(request).toJson(QJsonDocument::Compact) + '\n');
+}
+
+void DaemonLink::onReadyRead()
+{
+    while (m_socket.canReadLine()) {
+        QJsonObject msg = QJsonDocument::fromJson(m_socket.readLine()).object();
+        QString event = msg["event"].toString();
+        QString profile = msg["profile"].toString();
+        if (!event.isEmpty() && !m_profile.isEmpty() && profile != m_profile) {
+            continue;//another instance of the daemon
+        }
+        if (event == "log") {
+            emit output(msg["line"].toString().toLocal8Bit());
+        } else if (event == "started") {
+            m_running = true;
+            m_profile = profile;
+            emit started(profile, qint64(msg["pid"].toDouble()));
+        } else if (event == "stopped") {
+            m_running = false;
+            emit stopped(profile);
+        } else if (msg["reply"].toString() == "start" && !msg["ok"].toBool()) {
+            emit failed(msg["error"].toString());
+        } else if (msg["reply"].toString() == "status") {
+            //the GUI shows one profile, the first one the daemon runs
+            QJsonArray instances = msg["instances"].toArray();
+            if (!instances.isEmpty()) {
+                QJsonObject first = instances.first().toObject();
+                if (first["running"].toBool()) {
+                    m_running = true;
+                    m_profile = first["profile"].toString();
+                    emit started(first["profile"].toString(), qint64(first["pid"].toDouble()));
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,47 @@
+/*
+ * Daemon Link Class
+ *
+ * The GUI's side of the control socket of another instance, usually the
+ * daemon. While attached, the GUI starts and stops profiles there and shows
+ * the backend output, instead of running a backend of its own. The daemon
+ * may run other profiles too, only the one shown is followed.
+ */
+#ifndef DAEMONLINK_H
+#define DAEMONLINK_H
+#include <QObject>
+#include <QLocalSocket>
+#include <QJsonObject>
+
+class DaemonLink : public QObject
+{
+    Q_OBJECT
+
+public:
+    DaemonLink(QObject *parent = 0);
+    bool attach();
+    inline bool isAttached() const { return m_socket.state() == QLocalSocket::ConnectedState; }
+    inline bool isRunning() const { return m_running; }
+    void start(const QString &profileName);
+    void stop();
+
+    static const int AttachTimeoutMSecs = 100;
+
+signals:
+    void started(const QString &profileName, qint64 pid);
+    void stopped(const QString &profileName);
+    void failed(const QString &error);//the daemon refused to start the profile
+    void output(const QByteArray &o);
+    void detached();
+
+private:
+    QLocalSocket m_socket;
+    bool m_running;
+    QString m_profile;//the profile the GUI shows, empty until one is known
+
+    void send(const QJsonObject &request);
+
+private slots:
+    void onReadyRead();
+};
+
+#endif // DAEMONLINK_H
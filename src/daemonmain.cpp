@@ -0,0 +1,19 @@
+#include "appsetup.h"
+#include "startuptimer.h"
+
+/*
+ * ss-qt5d: ss-qt5 --daemon and --server, built without Qt GUI and Widgets
+ * for machines that have no display libraries.
+ */
+int main(int argc, char *argv[])
+{
+    StartupTimer::start();
+    bool server = false;
+    for (int i = 1; i < argc; ++i) {
+        server = server || qstrcmp(argv[i], "--server") == 0;
+        if (qstrcmp(argv[i], "-v") == 0) {
+            StartupTimer::setVerbose(true);
+        }
+    }
+    return AppSetup::runDaemon(argc, argv, server);
+}
@@ -0,0 +1,177 @@
+#include "latencyhistogram.h"
+
+LatencyHistogram::LatencyHistogram()
+{
+    reset();
+}
+
+LatencyHistogram::LatencyHistogram(const LatencyHistogram &other)
+{
+    reset();
+    merge(other);
+}
+
+LatencyHistogram &LatencyHistogram::operator=(const LatencyHistogram &other)
+{
+    if (this != &other) {
+        reset();
+        merge(other);
+    }
+    return *this;
+}
+
+void LatencyHistogram::reset()
+{
+    for (int i = 0; i < BucketCount; ++i) {
+        m_counts[i].store(0, std::memory_order_relaxed);
+    }
+    m_total.store(0, std::memory_order_relaxed);
+    m_sum.store(0, std::memory_order_relaxed);
+    m_max.store(0, std::memory_order_relaxed);
+}
+
+int LatencyHistogram::indexOf(qint64 us)
+{
+    if (us < SubBuckets) {
+        return us < 0 ? 0 : int(us);
+    }
+
+    int msb = 63 - __builtin_clzll(quint64(us));
+    int shift = msb - 5;//keep the top 6 bits, i.e. 32..63
+    int index = SubBuckets + (shift - 1) * (SubBuckets / 2) + int(us >> shift) - SubBuckets / 2;
+    return qMin(index, BucketCount - 1);
+}
+
+qint64 LatencyHistogram::highestEquivalent(int index)
+{
+    if (index < SubBuckets) {
+        return index;
+    }
+
+    int shift = (index - SubBuckets) / (SubBuckets / 2) + 1;
+    qint64 sub = (index - SubBuckets) % (SubBuckets / 2) + SubBuckets / 2;
+    return ((sub + 1) << shift) - 1;
+}
+
+void LatencyHistogram::record(qint64 us)
+{
+    m_counts[indexOf(us)].fetch_add(1, std::memory_order_relaxed);
+    m_total.fetch_add(1, std::memory_order_relaxed);
+    m_sum.fetch_add(quint64(qMax(us, qint64(0))), std::memory_order_relaxed);
+
+    qint64 seen = m_max.load(std::memory_order_relaxed);
+    while (us > seen && !m_max.compare_exchange_weak(seen, us, std::memory_order_relaxed)) {}
+}
+
+void LatencyHistogram::merge(const LatencyHistogram &other)
+{
+    for (int i = 0; i < BucketCount; ++i) {
+        quint64 c = other.m_counts[i].load(std::memory_order_relaxed);
+        if (c) {
+            m_counts[i].fetch_add(c, std::memory_order_relaxed);
+        }
+    }
+    m_total.fetch_add(other.m_total.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    m_sum.fetch_add(other.m_sum.load(std::memory_order_relaxed), std::memory_order_relaxed);
+
+    qint64 theirs = other.m_max.load(std::memory_order_relaxed);
+    qint64 seen = m_max.load(std::memory_order_relaxed);
+    while (theirs > seen && !m_max.compare_exchange_weak(seen, theirs, std::memory_order_relaxed)) {}
+}
+
+quint64 LatencyHistogram::count() const
+{
+    return m_total.load(std::memory_order_relaxed);
+}
+
+quint64 LatencyHistogram::countAtOrBelow(qint64 us) const
+{
+    quint64 sum = 0;
+    int last = indexOf(us);
+    for (int i = 0; i <= last; ++i) {
+        sum += m_counts[i].load(std::memory_order_relaxed);
+    }
+    return sum;
+}
+
+qint64 LatencyHistogram::max() const
+{
+    return m_max.load(std::memory_order_relaxed);
+}
+
+double LatencyHistogram::mean() const
+{
+    quint64 n = count();
+    return n ? double(m_sum.load(std::memory_order_relaxed)) / n : 0.0;
+}
+
+qint64 LatencyHistogram::percentile(double p) const
+{
+    quint64 n = count();
+    if (n == 0) {
+        return 0;
+    }
+
+    quint64 target = quint64(p / 100.0 * n + 0.5);
+    target = qBound(quint64(1), target, n);
+    quint64 seen = 0;
+    for (int i = 0; i < BucketCount; ++i) {
+        seen += m_counts[i].load(std::memory_order_relaxed);
+        if (seen >= target) {
+            return qMin(highestEquivalent(i), max());
+        }
+    }
+    return max();
+}
+
+QString LatencyHistogram::formatMicroseconds(qint64 us)
+{
+    if (us < 1000) {
+        return QString("%1 us").arg(us);
+    }
+    if (us < 1000000) {
+        return QString("%1 ms").arg(us / 1000.0, 0, 'f', 1);
+    }
+    return QString("%1 s").arg(us / 1000000.0, 0, 'f', 2);
+}
+
+QString LatencyHistogram::summary() const
+{
+    if (count() == 0) {
+        return QString("-");
+    }
+    return QString("p50 %1  p90 %2  p99 %3  p999 %4  (n=%5)")
+            .arg(formatMicroseconds(percentile(50)))
+            .arg(formatMicroseconds(percentile(90)))
+            .arg(formatMicroseconds(percentile(99)))
+            .arg(formatMicroseconds(percentile(99.9)))
+            .arg(count());
+}
+
+void LatencyHistogram::exportDistribution(QTextStream &out, const QString &title) const
+{
+    /*
+     * Same layout as HdrHistogram's percentile distribution output,
+     * so the existing plotting tools can read it.
+     */
+    out << "# " << title << "\n";
+    out << "       Value     Percentile TotalCount 1/(1-Percentile)\n\n";
+
+    quint64 n = count();
+    quint64 seen = 0;
+    for (int i = 0; i < BucketCount && n > 0; ++i) {
+        quint64 c = m_counts[i].load(std::memory_order_relaxed);
+        if (c == 0) {
+            continue;
+        }
+        seen += c;
+        double p = double(seen) / n;
+        out << QString("%1 %2 %3 ").arg(highestEquivalent(i) / 1000.0, 12, 'f', 3).arg(p, 14, 'f', 12).arg(seen, 10);
+        if (seen < n) {
+            out << QString("%1").arg(1.0 / (1.0 - p), 14, 'f', 2);
+        }
+        out << "\n";
+    }
+    out << QString("#[Mean    = %1, Max     = %2]\n").arg(mean() / 1000.0, 12, 'f', 3).arg(max() / 1000.0, 12, 'f', 3);
+    out << QString("#[Total count    = %1]\n\n").arg(n, 12);
+}
@@ -0,0 +1,68 @@
+/*
+ * Latency Histogram Class
+ *
+ * An HDR-style histogram of microsecond values: every power of two is split
+ * into a fixed number of linear sub-buckets, so the relative error stays
+ * below 1/32 from 1 us up to hours.
+ * Recording is a single relaxed atomic increment, and histograms recorded by
+ * different threads can simply be merged.
+ */
+#ifndef LATENCYHISTOGRAM_H
+#define LATENCYHISTOGRAM_H
+#include <QString>
+#include <QTextStream>
+#include <atomic>
+
+class LatencyHistogram
+{
+public:
+    LatencyHistogram();
+    LatencyHistogram(const LatencyHistogram &other);
+    LatencyHistogram &operator=(const LatencyHistogram &other);
+
+    void record(qint64 us);
+    void merge(const LatencyHistogram &other);
+    void reset();
+
+    quint64 count() const;
+    quint64 countAtOrBelow(qint64 us) const;
+    qint64 percentile(double p) const;
+    qint64 max() const;
+    double mean() const;
+
+    QString summary() const;
+    void exportDistribution(QTextStream &out, const QString &title) const;
+
+    static QString formatMicroseconds(qint64 us);
+
+    static const int SubBuckets = 64;
+    static const int BucketCount = 1024;
+
+private:
+    std::atomic<quint64> m_counts[BucketCount];
+    std::atomic<quint64> m_total;
+    std::atomic<quint64> m_sum;
+    std::atomic<qint64> m_max;
+
+    static int indexOf(qint64 us);
+    static qint64 highestEquivalent(int index);
+};
+
+/*
+ * The three latencies recorded for a profile.
+ */
+struct LatencySet
+{
+    LatencyHistogram connect;//TCP connect to server:server_port
+    LatencyHistogram ttfb;//SOCKS request to the first byte of the response
+    LatencyHistogram duration;//whole session
+
+    void merge(const LatencySet &other)
+    {
+        connect.merge(other.connect);
+        ttfb.merge(other.ttfb);
+        duration.merge(other.duration);
+    }
+};
+
+#endif // LATENCYHISTOGRAM_H
@@ -0,0 +1,124 @@
+#include <QDateTime>
+#include <algorithm>
+#include "logeventmodel.h"
+
+LogEventModel::LogEventModel(const LogEventStore *store, QObject *parent) :
+    QAbstractTableModel(parent),
+    m_store(store),
+    m_dropped(0),
+    m_end(0),
+    m_mask(LogEventStore::AllMask)
+{}
+
+int LogEventModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_rows.size();
+}
+
+int LogEventModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : 4;
+}
+
+QVariant LogEventModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || role != Qt::DisplayRole || index.row() >= m_rows.size()) {
+        return QVariant();
+    }
+
+    int row = m_rows[index.row()];
+    if (row >= m_store->count()) {//evicted since the last sync
+        return QVariant();
+    }
+    switch (index.column()) {
+    case 0:
+        return QDateTime::fromMSecsSinceEpoch(m_store->timeAt(row)).toString("MM-dd HH:mm:ss");
+    case 1:
+        switch (m_store->typeAt(row)) {
+        case LogEventStore::Connect:
+            return tr("Connect");
+        case LogEventStore::Error:
+            return tr("Error");
+        case LogEventStore::Timeout:
+            return tr("Timeout");
+        default:
+            return QString();
+        }
+    case 2:
+        if (m_store->portAt(row) == 0) {
+            return m_store->hostAt(row);
+        }
+        return QString("%1:%2").arg(m_store->hostAt(row)).arg(m_store->portAt(row));
+    default:
+        return m_store->messageAt(row);
+    }
+}
+
+QVariant LogEventModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole) {
+        return QVariant();
+    }
+
+    switch (section) {
+    case 0:
+        return tr("Time");
+    case 1:
+        return tr("Type");
+    case 2:
+        return tr("Destination");
+    default:
+        return tr("Message");
+    }
+}
+
+void LogEventModel::setFilter(const QString &hostPattern, int typeMask)
+{
+    m_pattern = hostPattern;
+    m_mask = typeMask;
+    refresh();
+}
+
+void LogEventModel::refresh()
+{
+    beginResetModel();
+    m_rows = m_store->search(m_pattern, m_mask);
+    m_dropped = m_store->dropped();
+    m_end = m_dropped + m_store->count();
+    endResetModel();
+}
+
+void LogEventModel::sync()
+{
+    if (m_store->dropped() < m_dropped || m_store->dropped() + m_store->count() < m_end) {//the store was cleared
+        refresh();
+        return;
+    }
+
+    qint64 shift = m_store->dropped() - m_dropped;
+    if (shift > 0) {
+        int gone = std::lower_bound(m_rows.begin(), m_rows.end(), shift) - m_rows.begin();
+        if (gone > 0) {
+            beginRemoveRows(QModelIndex(), 0, gone - 1);
+            m_rows.remove(0, gone);
+            endRemoveRows();
+        }
+        for (QVector<quint32>::iterator it = m_rows.begin(); it != m_rows.end(); ++it) {
+            *it -= shift;
+        }
+        m_dropped += shift;
+    }
+
+    QVector<quint32> fresh;
+    for (int row = qMax<qint64>(0, m_end - m_dropped); row < m_store->count(); ++row) {
+        if (m_store->matches(row, m_pattern, m_mask)) {
+            fresh.append(row);
+        }
+    }
+    m_end = m_dropped + m_store->count();
+    if (!fresh.isEmpty()) {
+        beginInsertRows(QModelIndex(), m_rows.size(), m_rows.size() + fresh.size() - 1);
+        m_rows += fresh;
+        endInsertRows();
+    }
+}
@@ -0,0 +1,34 @@
+#ifndef LOGEVENTMODEL_H
+#define LOGEVENTMODEL_H
+
+#include <QAbstractTableModel>
+#include <QVector>
+#include "logeventstore.h"
+
+class LogEventModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    explicit LogEventModel(const LogEventStore *store, QObject *parent = 0);
+    int rowCount(const QModelIndex &parent = QModelIndex()) const;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const;
+
+public slots:
+    void setFilter(const QString &hostPattern, int typeMask);
+    void refresh();
+    //picks up events appended to, or evicted from, the store since the last call, keeping the view's scroll and selection
+    void sync();
+
+private:
+    const LogEventStore *m_store;
+    QVector<quint32> m_rows;
+    qint64 m_dropped;//store's dropped() and dropped() + count() as of the last refresh or sync
+    qint64 m_end;
+    QString m_pattern;
+    int m_mask;
+};
+
+#endif // LOGEVENTMODEL_H
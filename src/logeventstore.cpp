@@ -0,0 +1,182 @@
+#include <algorithm>
+#include "logeventstore.h"
+
+const int LogEventStore::MaxEvents = 1 << 20;
+
+LogEventStore::LogEventStore()
+{
+    clear();
+}
+
+void LogEventStore::clear()
+{
+    m_time.clear();
+    m_type.clear();
+    m_host.clear();
+    m_port.clear();
+    m_msgOffset.clear();
+    m_text.clear();
+    m_hosts.clear();
+    m_hostIds.clear();
+    m_postings.clear();
+    m_dropped = 0;
+
+    //id 0 is reserved for events without a destination
+    m_hosts.append(QString());
+    m_postings.append(QVector<quint32>());
+}
+
+quint32 LogEventStore::hostId(const QString &host)
+{
+    if (host.isEmpty()) {
+        return 0;
+    }
+
+    QString key = host.toLower();
+    QHash<QString, quint32>::const_iterator it = m_hostIds.constFind(key);
+    if (it != m_hostIds.constEnd()) {
+        return it.value();
+    }
+
+    quint32 id = m_hosts.size();
+    m_hosts.append(key);
+    m_postings.append(QVector<quint32>());
+    m_hostIds.insert(key, id);
+    return id;
+}
+
+void LogEventStore::append(qint64 msecs, EventType type, const QString &host, quint16 port, const QByteArray &message)
+{
+    if (count() >= MaxEvents) {
+        dropOldest(MaxEvents / 2);
+    }
+
+    quint32 row = m_type.size();
+    quint32 id = hostId(host);
+    m_time.append(msecs);
+    m_type.append(static_cast<quint8>(type));
+    m_host.append(id);
+    m_port.append(port);
+    m_text.append(message);
+    m_msgOffset.append(m_text.size());
+    if (id != 0) {
+        m_postings[id].append(row);
+    }
+}
+
+QString LogEventStore::messageAt(int row) const
+{
+    int begin = row == 0 ? 0 : m_msgOffset[row - 1];
+    return QString::fromUtf8(m_text.constData() + begin, m_msgOffset[row] - begin);
+}
+
+bool LogEventStore::matches(int row, const QString &hostPattern, int typeMask) const
+{
+    if (!(typeMask & (1 << m_type[row]))) {
+        return false;
+    }
+    return hostPattern.isEmpty() || (m_host[row] != 0 && m_hosts[m_host[row]].contains(hostPattern, Qt::CaseInsensitive));
+}
+
+QVector<quint32> LogEventStore::search(const QString &hostPattern, int typeMask) const
+{
+    QVector<quint32> rows;
+    const int n = count();
+
+    if (hostPattern.isEmpty()) {
+        rows.reserve(typeMask == AllMask ? n : 0);
+        for (int i = 0; i < n; ++i) {
+            if (typeMask & (1 << m_type[i])) {
+                rows.append(i);
+            }
+        }
+        return rows;
+    }
+
+    QString pattern = hostPattern.toLower();
+    QVector<quint32> ids;
+    int hits = 0;
+    for (int id = 1; id < m_hosts.size(); ++id) {
+        if (m_hosts[id].contains(pattern)) {
+            ids.append(id);
+            hits += m_postings[id].size();
+        }
+    }
+    if (ids.isEmpty()) {
+        return rows;
+    }
+    rows.reserve(hits);
+
+    if (ids.size() == 1) {
+        const QVector<quint32> &posting = m_postings[ids.first()];
+        for (QVector<quint32>::const_iterator it = posting.constBegin(); it != posting.constEnd(); ++it) {
+            if (typeMask & (1 << m_type[*it])) {
+                rows.append(*it);
+            }
+        }
+    }
+    else if (hits > n / 8) {
+        //a broad pattern, a single pass over the host column beats merging postings
+        QVector<bool> matched(m_hosts.size(), false);
+        for (QVector<quint32>::const_iterator it = ids.constBegin(); it != ids.constEnd(); ++it) {
+            matched[*it] = true;
+        }
+        for (int i = 0; i < n; ++i) {
+            if (matched[m_host[i]] && (typeMask & (1 << m_type[i]))) {
+                rows.append(i);
+            }
+        }
+    }
+    else {
+        for (QVector<quint32>::const_iterator id = ids.constBegin(); id != ids.constEnd(); ++id) {
+            const QVector<quint32> &posting = m_postings[*id];
+            for (QVector<quint32>::const_iterator it = posting.constBegin(); it != posting.constEnd(); ++it) {
+                if (typeMask & (1 << m_type[*it])) {
+                    rows.append(*it);
+                }
+            }
+        }
+        std::sort(rows.begin(), rows.end());
+    }
+    return rows;
+}
+
+void LogEventStore::dropOldest(int n)
+{
+    n = qMin(n, count());
+    int textBegin = m_msgOffset[n - 1];
+    m_dropped += n;
+
+    m_time.remove(0, n);
+    m_type.remove(0, n);
+    m_host.remove(0, n);
+    m_port.remove(0, n);
+    m_msgOffset.remove(0, n);
+    m_text.remove(0, textBegin);
+    for (QVector<quint32>::iterator it = m_msgOffset.begin(); it != m_msgOffset.end(); ++it) {
+        *it -= textBegin;
+    }
+
+    //renumber the hosts still referenced, the evicted ones go with their events
+    QVector<quint32> remap(m_hosts.size(), 0);
+    QVector<QString> hosts;
+    hosts.append(QString());
+    m_hostIds.clear();
+    m_postings.clear();
+    m_postings.append(QVector<quint32>());
+    for (int i = 0; i < m_host.size(); ++i) {
+        quint32 old = m_host[i];
+        if (old == 0) {
+            continue;
+        }
+        if (remap[old] == 0) {
+            remap[old] = hosts.size();
+            hosts.append(m_hosts[old]);
+            m_hostIds.insert(m_hosts[old], remap[old]);
+            m_postings.append(QVector<quint32>());
+        }
+        m_host[i] = remap[old];
+        m_postings[remap[old]].append(i);
+    }
+    m_hosts = hosts;
+}
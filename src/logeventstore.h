@@ -0,0 +1,72 @@
+/*
+ * Log Event Store Class
+ *
+ * Keeps parsed backend log events in a columnar layout, together with an
+ * inverted index from destination host to event rows.
+ */
+#ifndef LOGEVENTSTORE_H
+#define LOGEVENTSTORE_H
+#include <QString>
+#include <QByteArray>
+#include <QVector>
+#include <QHash>
+
+class LogEventStore
+{
+public:
+    enum EventType {
+        Other = 0,
+        Connect,
+        Error,
+        Timeout
+    };
+
+    enum TypeMask {
+        OtherMask = 1 << Other,
+        ConnectMask = 1 << Connect,
+        ErrorMask = 1 << Error,
+        TimeoutMask = 1 << Timeout,
+        AllMask = OtherMask | ConnectMask | ErrorMask | TimeoutMask
+    };
+
+    LogEventStore();
+
+    void append(qint64 msecs, EventType type, const QString &host, quint16 port, const QByteArray &message);
+    void clear();
+    inline int count() const { return m_type.size(); }
+    inline qint64 dropped() const { return m_dropped; }//rows evicted from the front since clear()
+
+    inline qint64 timeAt(int row) const { return m_time[row]; }
+    inline EventType typeAt(int row) const { return static_cast<EventType>(m_type[row]); }
+    inline QString hostAt(int row) const { return m_hosts[m_host[row]]; }
+    inline quint16 portAt(int row) const { return m_port[row]; }
+    QString messageAt(int row) const;
+
+    /*
+     * Returns the rows, in chronological order, whose type is in typeMask
+     * and whose destination host contains hostPattern (case-insensitive).
+     * An empty hostPattern matches every event, including those without a host.
+     */
+    QVector<quint32> search(const QString &hostPattern, int typeMask = AllMask) const;
+    bool matches(int row, const QString &hostPattern, int typeMask = AllMask) const;//same rule as search()
+
+    static const int MaxEvents;
+
+private:
+    QVector<qint64> m_time;
+    QVector<quint8> m_type;
+    QVector<quint32> m_host;//id into m_hosts, 0 means no host
+    QVector<quint16> m_port;
+    QVector<quint32> m_msgOffset;//end offset of each message in m_text
+    QByteArray m_text;
+
+    QVector<QString> m_hosts;
+    QHash<QString, quint32> m_hostIds;
+    QVector<QVector<quint32> > m_postings;//rows per host id
+    qint64 m_dropped;
+
+    quint32 hostId(const QString &host);
+    void dropOldest(int n);
+};
+
+#endif // LOGEVENTSTORE_H
@@ -0,0 +1,103 @@
+#include <QDir>
+#include <QFileInfo>
+#include <QDebug>
+#include "logfile.h"
+
+const qint64 LogFile::MaxSize = 16 * 1024 * 1024;
+const int LogFile::MaxBackups = 5;
+
+LogFile::LogFile(QObject *parent) :
+    QObject(parent),
+    m_size(0)
+{
+    m_flushTimer.setInterval(1000);
+    connect(&m_flushTimer, &QTimer::timeout, this, &LogFile::flush);
+}
+
+LogFile::~LogFile()
+{
+    close();
+}
+
+QString LogFile::pathForProfile(const QString &configFile, const QString &profileName)
+{
+    QString name = profileName;
+    for (QString::iterator it = name.begin(); it != name.end(); ++it) {
+        if (!it->isLetterOrNumber() && *it != '-' && *it != '_') {
+            *it = '_';
+        }
+    }
+    return QFileInfo(configFile).absoluteDir().absoluteFilePath(QString("ss-qt5-%1.log").arg(name));
+}
+
+QStringList LogFile::rotatedFiles(const QString &path)
+{
+    QStringList files;
+    if (QFile::exists(path)) {
+        files << path;
+    }
+    for (int i = 1; i <= MaxBackups; ++i) {
+        QString backup = QString("%1.%2").arg(path).arg(i);
+        if (QFile::exists(backup)) {
+            files << backup;
+        }
+    }
+    return files;
+}
+
+bool LogFile::open(const QString &path)
+{
+    close();
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        qWarning() << "Warning: cannot open log file" << path;
+        return false;
+    }
+    m_size = m_file.size();
+    m_flushTimer.start();
+    return true;
+}
+
+void LogFile::write(const QByteArray &data)
+{
+    if (!m_file.isOpen()) {
+        return;
+    }
+
+    if (m_size + data.size() > MaxSize && m_size > 0) {
+        rotate();
+    }
+    m_size += m_file.write(data);
+}
+
+void LogFile::flush()
+{
+    if (m_file.isOpen()) {
+        m_file.flush();
+    }
+}
+
+void LogFile::close()
+{
+    m_flushTimer.stop();
+    if (m_file.isOpen()) {
+        m_file.close();
+    }
+}
+
+void LogFile::rotate()
+{
+    QString path = m_file.fileName();
+    m_file.close();
+
+    QFile::remove(QString("%1.%2").arg(path).arg(MaxBackups));
+    for (int i = MaxBackups - 1; i > 0; --i) {
+        QFile::rename(QString("%1.%2").arg(path).arg(i), QString("%1.%2").arg(path).arg(i + 1));
+    }
+    QFile::rename(path, path + ".1");
+
+    m_size = 0;
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        qWarning() << "Warning: cannot reopen log file" << path << "after rotation";
+    }
+}
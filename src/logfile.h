@@ -0,0 +1,44 @@
+/*
+ * Log File Class
+ *
+ * Append-only, size-rotated log of the backend output.
+ * Writes are buffered and flushed periodically instead of per line.
+ */
+#ifndef LOGFILE_H
+#define LOGFILE_H
+#include <QObject>
+#include <QFile>
+#include <QTimer>
+#include <QStringList>
+
+class LogFile : public QObject
+{
+    Q_OBJECT
+
+public:
+    LogFile(QObject *parent = 0);
+    ~LogFile();
+    bool open(const QString &path);
+    void write(const QByteArray &data);
+    void close();
+    inline bool isOpen() const { return m_file.isOpen(); }
+    inline QString path() const { return m_file.fileName(); }
+
+    static QString pathForProfile(const QString &configFile, const QString &profileName);
+    static QStringList rotatedFiles(const QString &path);
+
+    static const qint64 MaxSize;
+    static const int MaxBackups;
+
+public slots:
+    void flush();
+
+private:
+    QFile m_file;
+    qint64 m_size;
+    QTimer m_flushTimer;
+
+    void rotate();
+};
+
+#endif // LOGFILE_H
@@ -0,0 +1,102 @@
+#include <QDebug>
+#include <cstring>
+#include "loglinemodel.h"
+
+const int LogLineModel::FetchLines = 4096;
+
+LogLineModel::LogLineModel(QObject *parent) :
+    QAbstractListModel(parent),
+    m_data(0),
+    m_size(0),
+    m_scanned(0)
+{}
+
+LogLineModel::~LogLineModel()
+{
+    unmap();
+}
+
+void LogLineModel::unmap()
+{
+    if (m_data) {
+        m_file.unmap(reinterpret_cast<uchar *>(const_cast<char *>(m_data)));
+        m_data = 0;
+    }
+    if (m_file.isOpen()) {
+        m_file.close();
+    }
+    m_size = 0;
+    m_scanned = 0;
+    m_offsets.clear();
+}
+
+bool LogLineModel::setFile(const QString &path)
+{
+    beginResetModel();
+    unmap();
+    m_file.setFileName(path);
+    bool ok = m_file.open(QIODevice::ReadOnly);
+    if (ok && m_file.size() > 0) {
+        m_size = m_file.size();
+        m_data = reinterpret_cast<const char *>(m_file.map(0, m_size));
+        if (!m_data) {
+            qWarning() << "Warning: cannot map log file" << path;
+            m_size = 0;
+            ok = false;
+        }
+    }
+    endResetModel();
+
+    if (canFetchMore(QModelIndex())) {
+        fetchMore(QModelIndex());
+    }
+    return ok;
+}
+
+int LogLineModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_offsets.size();
+}
+
+QVariant LogLineModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || role != Qt::DisplayRole || index.row() >= m_offsets.size()) {
+        return QVariant();
+    }
+
+    qint64 begin = m_offsets[index.row()];
+    qint64 end = index.row() + 1 < m_offsets.size() ? m_offsets[index.row() + 1] - 1 : m_scanned;
+    if (end > begin && m_data[end - 1] == '\n') {
+        --end;//the last indexed line may end the file with a newline
+    }
+    if (end > begin && m_data[end - 1] == '\r') {
+        --end;
+    }
+    return QString::fromLocal8Bit(m_data + begin, end - begin);
+}
+
+bool LogLineModel::canFetchMore(const QModelIndex &parent) const
+{
+    return !parent.isValid() && m_scanned < m_size;
+}
+
+void LogLineModel::fetchMore(const QModelIndex &parent)
+{
+    if (parent.isValid()) {
+        return;
+    }
+
+    QVector<qint64> found;
+    found.reserve(FetchLines);
+    qint64 pos = m_scanned;
+    while (pos < m_size && found.size() < FetchLines) {
+        found.append(pos);
+        const void *nl = memchr(m_data + pos, '\n', m_size - pos);
+        pos = nl ? (static_cast<const char *>(nl) - m_data) + 1 : m_size;
+    }
+
+    beginInsertRows(QModelIndex(), m_offsets.size(), m_offsets.size() + found.size() - 1);
+    m_offsets += found;
+    m_scanned = pos;
+    endInsertRows();
+}
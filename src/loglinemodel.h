@@ -0,0 +1,39 @@
+/*
+ * Log Line Model Class
+ *
+ * Presents a memory-mapped log file line by line.
+ * The line-offset index is only built as far as the view has scrolled.
+ */
+#ifndef LOGLINEMODEL_H
+#define LOGLINEMODEL_H
+
+#include <QAbstractListModel>
+#include <QFile>
+#include <QVector>
+
+class LogLineModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+public:
+    explicit LogLineModel(QObject *parent = 0);
+    ~LogLineModel();
+    bool setFile(const QString &path);
+    int rowCount(const QModelIndex &parent = QModelIndex()) const;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const;
+    bool canFetchMore(const QModelIndex &parent) const;
+    void fetchMore(const QModelIndex &parent);
+
+    static const int FetchLines;
+
+private:
+    QFile m_file;
+    const char *m_data;
+    qint64 m_size;
+    qint64 m_scanned;//bytes covered by m_offsets so far
+    QVector<qint64> m_offsets;//start offset of every indexed line
+
+    void unmap();
+};
+
+#endif // LOGLINEMODEL_H
@@ -0,0 +1,114 @@
+#include <QDateTime>
+#include "logparser.h"
+
+LogParser::LogParser(LogEventStore *store) :
+    m_store(store),
+    m_timestamp("^\\s*(\\d{4}-\\d{2}-\\d{2}[ T]\\d{2}:\\d{2}:\\d{2})"),
+    m_error("\\b(ERROR|error|Error|failed|refused|unreachable)\\b"),
+    m_timeout("\\b(timeout|timed out|TIMEOUT)\\b"),
+    m_target("\\[?([A-Za-z0-9._:-]*[A-Za-z0-9])\\]?:(\\d{1,5})\\b")
+{
+    m_timestamp.optimize();
+    m_error.optimize();
+    m_timeout.optimize();
+    m_target.optimize();
+    setBackendType(0);
+}
+
+void LogParser::setBackendType(int typeID)
+{
+    m_typeID = typeID;
+    switch (typeID) {
+    case 1://nodejs: "connecting www.example.com:443"
+        m_connect.setPattern("\\bconnecting\\s+(\\S+)");
+        break;
+    case 2://go: "connecting www.example.com:443" or "connected to www.example.com:443"
+        m_connect.setPattern("\\bconnect(?:ing|ed)?\\s+(?:to\\s+)?(\\S+)");
+        break;
+    case 3://python: "connecting www.example.com:443 from 127.0.0.1:50000"
+        m_connect.setPattern("\\bconnecting\\s+(\\S+)\\s+from\\b");
+        break;
+    default://libev: "INFO: connect to www.example.com:443"
+        m_connect.setPattern("\\bconnect to\\s+(\\S+)");
+    }
+    m_connect.optimize();
+}
+
+void LogParser::feed(const QByteArray &output)
+{
+    m_pending.append(output);
+    int begin = 0;
+    int end;
+    while ((end = m_pending.indexOf('\n', begin)) != -1) {
+        parseLine(m_pending.mid(begin, end - begin));
+        begin = end + 1;
+    }
+    m_pending.remove(0, begin);
+}
+
+void LogParser::flush()
+{
+    if (!m_pending.isEmpty()) {
+        parseLine(m_pending);
+        m_pending.clear();
+    }
+}
+
+void LogParser::parseLine(const QByteArray &rawLine)
+{
+    QByteArray line = rawLine.trimmed();
+    if (line.isEmpty()) {
+        return;
+    }
+    QString text = QString::fromLocal8Bit(line);
+
+    qint64 msecs;
+    QRegularExpressionMatch ts = m_timestamp.match(text);
+    if (ts.hasMatch()) {
+        QString stamp = ts.captured(1);
+        stamp[10] = QChar(' ');
+        msecs = QDateTime::fromString(stamp, "yyyy-MM-dd HH:mm:ss").toMSecsSinceEpoch();
+    }
+    else {
+        msecs = QDateTime::currentMSecsSinceEpoch();
+    }
+
+    LogEventStore::EventType type = LogEventStore::Other;
+    QString target;
+    QRegularExpressionMatch conn = m_connect.match(text);
+    if (m_timeout.match(text).hasMatch()) {
+        type = LogEventStore::Timeout;
+    }
+    else if (m_error.match(text).hasMatch()) {
+        type = LogEventStore::Error;
+    }
+    else if (conn.hasMatch()) {
+        type = LogEventStore::Connect;
+    }
+
+    //errors and timeouts usually mention the destination too
+    if (conn.hasMatch()) {
+        target = conn.captured(1);
+    }
+    else if (type != LogEventStore::Other) {
+        QRegularExpressionMatch t = m_target.match(text, ts.hasMatch() ? ts.capturedEnd() : 0);
+        if (t.hasMatch()) {
+            target = t.captured(0);
+        }
+    }
+
+    QString host;
+    quint16 port = 0;
+    if (!target.isEmpty()) {
+        QRegularExpressionMatch t = m_target.match(target);
+        if (t.hasMatch()) {
+            host = t.captured(1);
+            port = t.captured(2).toUShort();
+        }
+        else {
+            host = target;
+        }
+    }
+
+    m_store->append(msecs, type, host, port, line);
+}
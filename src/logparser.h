@@ -0,0 +1,34 @@
+/*
+ * Log Parser Class
+ *
+ * Turns the output of the libev, NodeJS, Go and Python backends into
+ * typed events stored in a LogEventStore.
+ */
+#ifndef LOGPARSER_H
+#define LOGPARSER_H
+#include <QByteArray>
+#include <QRegularExpression>
+#include "logeventstore.h"
+
+class LogParser
+{
+public:
+    LogParser(LogEventStore *store);
+    void setBackendType(int typeID);
+    void feed(const QByteArray &output);
+    void flush();
+
+private:
+    LogEventStore *m_store;
+    int m_typeID;
+    QByteArray m_pending;
+    QRegularExpression m_timestamp;
+    QRegularExpression m_connect;
+    QRegularExpression m_error;
+    QRegularExpression m_timeout;
+    QRegularExpression m_target;
+
+    void parseLine(const QByteArray &line);
+};
+
+#endif // LOGPARSER_H
@@ -0,0 +1,27 @@
+#include "logviewer.h"
+#include "logfile.h"
+#include "ui_logviewer.h"
+
+LogViewer::LogViewer(const QString &logFile, QWidget *parent) :
+    QDialog(parent),
+    ui(new Ui::LogViewer)
+{
+    ui->setupUi(this);
+    setAttribute(Qt::WA_DeleteOnClose);
+    ui->lineView->setModel(&model);
+    ui->fileCombo->addItems(LogFile::rotatedFiles(logFile));
+    connect(ui->fileCombo, &QComboBox::currentTextChanged, this, &LogViewer::onFileChanged);
+    onFileChanged(ui->fileCombo->currentText());
+}
+
+LogViewer::~LogViewer()
+{
+    delete ui;
+}
+
+void LogViewer::onFileChanged(const QString &file)
+{
+    if (!file.isEmpty()) {
+        model.setFile(file);
+    }
+}
@@ -0,0 +1,27 @@
+#ifndef LOGVIEWER_H
+#define LOGVIEWER_H
+
+#include <QDialog>
+#include "loglinemodel.h"
+
+namespace Ui {
+class LogViewer;
+}
+
+class LogViewer : public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit LogViewer(const QString &logFile, QWidget *parent = 0);
+    ~LogViewer();
+
+private:
+    Ui::LogViewer *ui;
+    LogLineModel model;
+
+private slots:
+    void onFileChanged(const QString &file);
+};
+
+#endif // LOGVIEWER_H
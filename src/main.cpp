@@ -1,17 +1,32 @@
 #include "mainwindow.h"
-#include "ss_process.h"
+#include "appsetup.h"
+#include "startuptimer.h"
 #include <QApplication>
 #include <QTranslator>
-#include <QLibraryInfo>
 #include <QLocale>
+#include <QTimer>
 
 int main(int argc, char *argv[])
 {
-    QApplication a(argc, argv);
+    StartupTimer::start();
+    bool daemon = false;
+    bool server = false;
+    for (int i = 1; i < argc; ++i) {
+        daemon = daemon || qstrcmp(argv[i], "--daemon") == 0;
+        server = server || qstrcmp(argv[i], "--server") == 0;
+        if (qstrcmp(argv[i], "-v") == 0) {
+            StartupTimer::setVerbose(true);
+        }
+    }
+    if (daemon || server) {//ss-qt5d does the same without linking the widgets
+        return AppSetup::runDaemon(argc, argv, server);
+    }
 
-    a.setApplicationName(QString("shadowsocks-qt5"));
+    QApplication a(argc, argv);
+    StartupTimer::mark("application");
     a.setApplicationDisplayName(QString("Shadowsocks Qt5"));
-    a.setApplicationVersion(APP_VERSION);
+    QTranslator t, ssqt5t;
+    AppSetup::setupApplication(a, &t, &ssqt5t);
 
 #ifdef Q_OS_WIN
     if (QLocale::system().country() == QLocale::China) {
@@ -22,23 +37,18 @@ int main(int argc, char *argv[])
     }
 #endif
 
-    QTranslator t;
-    t.load("qt_" + QLocale::system().name(), QLibraryInfo::location(QLibraryInfo::TranslationsPath));
-    a.installTranslator(&t);
-
-    QTranslator ssqt5t;
-    ssqt5t.load("ssqt5_" + QLocale::system().name(), QCoreApplication::applicationDirPath());
-    a.installTranslator(&ssqt5t);
-
+    //MainWindow starts the backend of an autostart profile before building its widgets
     MainWindow w(a.arguments().contains("-v"));
     w.show();
+    StartupTimer::mark("window shown");
 
-    if (w.m_conf->isAutoStart()) {
-        w.startButtonPressed();
+    if (w.m_conf->isAutoStart() && !w.isAttached()) {
+        w.reportAutoStartFailure();//the backend may still be starting, don't start it again
     }
     if (w.m_conf->isAutoHide()) {
         w.minimizeToSysTray();
     }
+    QTimer::singleShot(0, [] { StartupTimer::mark("event loop"); });
 
     return a.exec();
 }
@@ -1,7 +1,20 @@
 #include <QDebug>
+#include <QDateTime>
+#include <QCompleter>
+#include <QListView>
+#include <QJsonArray>
 #include "mainwindow.h"
 #include "ui_mainwindow.h"
 #include "sharedialogue.h"
+#include "logviewer.h"
+#include "sparklinewidget.h"
+#include "connectionspanel.h"
+#include "resourcespanel.h"
+#include "tracer.h"
+#include "startuptimer.h"
+#include "subscriptiondialogue.h"
+#include "backendregistry.h"
+#include "batchexportdialogue.h"
 
 #ifdef Q_OS_WIN
 #include <QtWin>
@@ -15,32 +28,74 @@
 
 MainWindow::MainWindow(bool verbose, QWidget *parent) :
     QMainWindow(parent),
+    logParser(&logEvents),
+    profileSearchModel(NULL),
+    profileCompleter(NULL),
+    connectionsPanel(NULL),
+    resourcesPanel(NULL),
+    current_profile(NULL),
     ui(new Ui::MainWindow)
 {
-    ui->setupUi(this);
-
     //initialisation
     verboseOutput = verbose;
     if (verboseOutput) {
         qDebug() << "Verbose Enabled.";
     }
-#ifdef Q_OS_WIN
-    jsonconfigFile = QCoreApplication::applicationDirPath() + "/gui-config.json";
-#else
-    QDir ssConfigDir = QDir::homePath() + "/.config/shadowsocks";
-    jsonconfigFile = ssConfigDir.absolutePath() + "/gui-config.json";
-    if (!ssConfigDir.exists()) {
-        ssConfigDir.mkpath(ssConfigDir.absolutePath());
-    }
-#endif
+    jsonconfigFile = Configuration::defaultFile();
     m_conf = new Configuration(jsonconfigFile);
+    StartupTimer::mark("configuration");
+
+    metricsCollector = NULL;
+    if (m_conf->getMetricsPort() > 0 && metricsServer.start(m_conf->getMetricsPort())) {
+        metricsCollector = new MetricsCollector(&ss_local, &metricsServer, this);
+    }
+    logEventModel = new LogEventModel(&logEvents, this);
+    connectionModel = new ConnectionModel(this);
+
+    /*
+     * The proxy comes before any widget: attach to a running instance, or
+     * start the backend right away so autostart users are listening while
+     * the window is still being built. processStarted() catches the UI up.
+     */
+    daemonPid = 0;
+    controlServer = new ControlServer(m_conf, this, this);
+    if (daemonLink.attach()) {
+        qDebug() << "Attached to the running daemon";
+    } else {
+        controlServer->listen();
+        if (m_conf->isAutoStart()) {
+            current_profile = m_conf->currentProfile();
+            if (current_profile && current_profile->backend.isEmpty()) {
+                current_profile->setBackend(m_conf->isRelativePath());
+            }
+            //the window isn't there yet, failures are shown once it is
+            if (!current_profile || !current_profile->isValid()) {
+                autoStartFailure = tr("Invalid profile or configuration.");
+            } else if (!current_profile->plugin.isEmpty() && !current_profile->plugin_trusted) {
+                autoStartFailure = tr("The plugin of this profile hasn't been confirmed yet, start it once from the window.");
+            } else {
+                startBackend();
+            }
+        }
+    }
+    StartupTimer::mark("backend started");
+
+    ui->setupUi(this);
+    StartupTimer::mark("setupUi");
 
     ui->laddrEdit->setValidator(&ipv4addrValidator);
     ui->lportEdit->setValidator(&portValidator);
     ui->methodComboBox->addItems(SSValidator::supportedMethod);
-    ui->profileComboBox->addItems(m_conf->getProfileList());
+    profileModel = new ProfileModel(m_conf->profileStore(), this);
+    ui->profileComboBox->setModel(profileModel);
+    //measuring every row of a long list would defeat the lazy model
+    static_cast<QListView *>(ui->profileComboBox->view())->setUniformItemSizes(true);
+    ui->profileComboBox->setMaxVisibleItems(20);
+    subscriptionManager = new SubscriptionManager(m_conf, this);
+    configWatcher = new ConfigWatcher(m_conf, this);
     ui->sportEdit->setValidator(&portValidator);
     ui->stopButton->setEnabled(false);
+    ui->logEventView->setModel(logEventModel);
 
     ui->autohideCheck->setChecked(m_conf->isAutoHide());
     ui->autostartCheck->setChecked(m_conf->isAutoStart());
@@ -55,6 +110,8 @@ MainWindow::MainWindow(bool verbose, QWidget *parent) :
     ui->tfoCheckBox->setVisible(false);
 #endif
     ui->relativePathCheck->setChecked(m_conf->isRelativePath());
+    ui->relayModeCheck->setChecked(m_conf->isRelayMode());
+    ui->connectProbeCheck->setChecked(m_conf->isConnectProbe());
 
     //desktop systray
     systrayMenu.addAction(tr("Show"), this, SLOT(showWindow()));
@@ -95,6 +152,13 @@ MainWindow::MainWindow(bool verbose, QWidget *parent) :
     connect(&ss_local, &SS_Process::readReadyProcess, this, &MainWindow::onReadReadyProcess);
     connect(&ss_local, &SS_Process::sigstart, this, &MainWindow::processStarted);
     connect(&ss_local, &SS_Process::sigstop, this, &MainWindow::processStopped);
+    connect(ss_local.relay(), &SocksRelay::sessionsUpdated, connectionModel, &ConnectionModel::applyDelta);
+    connect(ss_local.relay(), &SocksRelay::sessionsUpdated, this, &MainWindow::onSessionsUpdated);
+    connect(&daemonLink, &DaemonLink::started, this, &MainWindow::onDaemonStarted);
+    connect(&daemonLink, &DaemonLink::stopped, this, &MainWindow::processStopped);
+    connect(&daemonLink, &DaemonLink::output, this, &MainWindow::onReadReadyProcess);
+    connect(&daemonLink, &DaemonLink::failed, this, &MainWindow::onDaemonFailed);
+    connect(&daemonLink, &DaemonLink::detached, this, &MainWindow::onDaemonDetached);
     connect(&systray, &QSystemTrayIcon::activated, this, &MainWindow::systrayActivated);
 
     connect(ui->backendToolButton, &QToolButton::clicked, this, &MainWindow::onBackendToolButtonPressed);
@@ -107,12 +171,21 @@ MainWindow::MainWindow(bool verbose, QWidget *parent) :
     */
     connect(ui->profileComboBox, SIGNAL(currentIndexChanged(int)), this, SLOT(onCurrentProfileChanged(int)));
 
+    connect(ui->profileSearchEdit, &QLineEdit::textEdited, this, &MainWindow::onProfileSearchEdited);
+    connect(subscriptionManager, &SubscriptionManager::refreshed, this, &MainWindow::onSubscriptionRefreshed);
+    connect(subscriptionManager, &SubscriptionManager::failed, this, &MainWindow::onSubscriptionFailed);
+    connect(configWatcher, &ConfigWatcher::aboutToReload, this, &MainWindow::onAboutToReloadProfiles);
+    connect(configWatcher, &ConfigWatcher::profilesReloaded, this, &MainWindow::onProfilesReloaded);
     connect(ui->backendTypeCombo, &QComboBox::currentTextChanged, this, &MainWindow::backendTypeChanged);
     connect(ui->addProfileButton, &QToolButton::clicked, this, &MainWindow::addProfileDialogue);
     connect(ui->delProfileButton, &QToolButton::clicked, this, &MainWindow::deleteProfile);
     connect(ui->startButton, &QPushButton::clicked, this, &MainWindow::startButtonPressed);
     connect(ui->stopButton, &QPushButton::clicked, this, &MainWindow::stopButtonPressed);
     connect(ui->shareButton, &QPushButton::clicked, this, &MainWindow::onShareButtonClicked);
+    connect(ui->exportButton, &QPushButton::clicked, this, &MainWindow::onExportButtonClicked);
+    connect(ui->logFilterEdit, &QLineEdit::textChanged, this, &MainWindow::onLogFilterChanged);
+    connect(ui->logHistoryButton, &QPushButton::clicked, this, &MainWindow::onLogHistoryButtonClicked);
+    connect(ui->logTypeCombo, static_cast<void (QComboBox::*)(int)>(&QComboBox::currentIndexChanged), this, &MainWindow::onLogFilterChanged);
 
     connect(this, &MainWindow::configurationChanged, this, &MainWindow::onConfigurationChanged);
     connect(ui->customArgEdit, &QLineEdit::textChanged, this, &MainWindow::onCustomArgsEditFinished);
@@ -133,18 +206,33 @@ MainWindow::MainWindow(bool verbose, QWidget *parent) :
     connect(ui->debugCheck, &QCheckBox::stateChanged, this, &MainWindow::debugToggled);
     connect(ui->translucentCheck, &QCheckBox::toggled, this, &MainWindow::transculentToggled);
     connect(ui->relativePathCheck, &QCheckBox::toggled, this, &MainWindow::relativePathToggled);
+    connect(ui->relayModeCheck, &QCheckBox::toggled, this, &MainWindow::relayModeToggled);
+    connect(ui->connectProbeCheck, &QCheckBox::toggled, this, &MainWindow::connectProbeToggled);
+    connect(ui->tabWidget, &QTabWidget::currentChanged, this, &MainWindow::onTabChanged);
+    connect(&statsTimer, &QTimer::timeout, this, &MainWindow::updateLatencyLabel);
+    connect(&resourceMonitor, &ProcessMonitor::sampled, this, &MainWindow::onProcessSampled);
+    connect(&resourceMonitor, &ProcessMonitor::thresholdCrossed, this, &MainWindow::showNotification);
+    statsTimer.start(2000);
     connect(ui->miscSaveButton, &QPushButton::clicked, this, &MainWindow::saveConfig);
     connect(ui->aboutButton, &QPushButton::clicked, this, &MainWindow::aboutButtonClicked);
+    connect(ui->subscriptionsButton, &QPushButton::clicked, this, &MainWindow::onSubscriptionsButtonClicked);
+    connect(BackendRegistry::instance(), &BackendRegistry::changed, this, [this] { showBackend(ui->backendEdit->text()); });
 
     //update current configuration
-    ui->profileComboBox->setCurrentIndex(m_conf->getIndex());
+    int currentRow = m_conf->profileStore()->rowOf(m_conf->currentId());
+    ui->profileComboBox->setCurrentIndex(currentRow);
     /*
      * If there is no gui-config file, or the index is 0, then the function above wouldn't emit signal.
      * Therefore, we have to emit a signal manually.
      */
-    if (m_conf->getIndex() <= 0) {
-        emit ui->profileComboBox->currentIndexChanged(m_conf->getIndex());
+    if (currentRow <= 0) {
+        emit ui->profileComboBox->currentIndexChanged(currentRow);
+    }
+
+    if (ss_local.isRunning()) {//started before the UI existed
+        processStarted();
     }
+    StartupTimer::mark("main window");
 }
 
 MainWindow::~MainWindow()
@@ -161,7 +249,7 @@ void MainWindow::onBackendToolButtonPressed()
     QString backend = QFileDialog::getOpenFileName();
     if (!backend.isEmpty()) {
         current_profile->setBackend(backend, m_conf->isRelativePath());
-        ui->backendEdit->setText(current_profile->backend);
+        showBackend(current_profile->backend);
         emit configurationChanged();
     }
     this->setWindowState(Qt::WindowActive);
@@ -175,6 +263,7 @@ void MainWindow::onCurrentProfileChanged(int i)
         addProfileDialogue(true);//enforce
         return;
     }
+    SS_TRACE_SCOPE("profile switch", "ui");
 
     /*
      * block all children signals temporarily.
@@ -182,11 +271,12 @@ void MainWindow::onCurrentProfileChanged(int i)
      */
     blockChildrenSignals(true);
 
-    ss_local.stop();//Q: should we stop the backend when profile changed?
-    if(i != m_conf->getIndex()) {
+    ProfileId id = m_conf->profileStore()->idAt(i);
+    if(id != m_conf->currentId()) {
+        ss_local.stop();//Q: should we stop the backend when profile changed?
         emit configurationChanged();
     }
-    m_conf->setIndex(i);
+    m_conf->setCurrentId(id);
     current_profile = m_conf->currentProfile();
     if (current_profile->backend.isEmpty()) {
         current_profile->setBackend(m_conf->isRelativePath());
@@ -196,7 +286,7 @@ void MainWindow::onCurrentProfileChanged(int i)
         }
     }
 
-    ui->backendEdit->setText(current_profile->backend);
+    showBackend(current_profile->backend);
     ui->backendTypeCombo->setCurrentIndex(current_profile->getBackendTypeID());
     ui->customArgEdit->setText(current_profile->custom_arg);
     ui->laddrEdit->setText(current_profile->local_addr);
@@ -225,6 +315,13 @@ void MainWindow::onShareButtonClicked()
     shareDlg->exec();
 }
 
+void MainWindow::onExportButtonClicked()
+{
+    BatchExportDialogue *exportDlg = new BatchExportDialogue(m_conf, this);
+    exportDlg->setAttribute(Qt::WA_DeleteOnClose);
+    exportDlg->exec();
+}
+
 void MainWindow::addProfileDialogue(bool enforce = false)
 {
     addProfileDlg = new AddProfileDialogue(this, enforce);
@@ -244,25 +341,17 @@ void MainWindow::addProfileDialogue(bool enforce = false)
 
 void MainWindow::onAddProfileDialogueAccepted(const QString &name, bool u, const QString &uri)
 {
-    if(u) {
-        m_conf->addProfileFromSSURI(name, uri);
-    }
-    else {
-        m_conf->addProfile(name);
-    }
-    current_profile = m_conf->lastProfile();
-    ui->profileComboBox->insertItem(ui->profileComboBox->count(), current_profile->profileName);
+    ProfileId id = u ? m_conf->addProfileFromSSURI(name, uri) : m_conf->addProfile(name);
+    current_profile = m_conf->profileStore()->profile(id);
 
     //change serverComboBox, let it emit currentIndexChanged signal.
-    ui->profileComboBox->setCurrentIndex(ui->profileComboBox->count() - 1);
+    ui->profileComboBox->setCurrentIndex(m_conf->profileStore()->rowOf(id));
 }
 
 void MainWindow::onAddProfileDialogueRejected(bool enforce)
 {
     if (enforce) {
-        m_conf->addProfile("Unnamed");
-        current_profile = m_conf->lastProfile();
-        ui->profileComboBox->insertItem(ui->profileComboBox->count(), "Unnamed");
+        current_profile = m_conf->profileStore()->profile(m_conf->addProfile("Unnamed"));
         //since there was no item previously, serverComboBox would change itself automatically.
         //we don't need to emit the signal again.
     }
@@ -295,13 +384,13 @@ void MainWindow::profileEditButtonClicked(QAbstractButton *b)
         saveConfig();
     }
     else {//reset
+        //the store is reset while reverting, keep the combo box from switching profiles halfway
+        ui->profileComboBox->blockSignals(true);
         m_conf->revert();
-        disconnect(ui->profileComboBox, static_cast<void (QComboBox::*)(int)>(&QComboBox::currentIndexChanged), this, &MainWindow::onCurrentProfileChanged);
-        ui->profileComboBox->clear();
-        ui->profileComboBox->insertItems(0, m_conf->getProfileList());
-        ui->profileComboBox->setCurrentIndex(m_conf->getIndex());
-        connect(ui->profileComboBox, static_cast<void (QComboBox::*)(int)>(&QComboBox::currentIndexChanged), this, &MainWindow::onCurrentProfileChanged);
-        emit ui->profileComboBox->currentIndexChanged(m_conf->getIndex());//same in MainWindow's constructor
+        int currentRow = m_conf->profileStore()->rowOf(m_conf->currentId());
+        ui->profileComboBox->setCurrentIndex(currentRow);
+        ui->profileComboBox->blockSignals(false);
+        onCurrentProfileChanged(currentRow);
         emit configurationChanged(true);
     }
 }
@@ -312,10 +401,148 @@ void MainWindow::startButtonPressed()
         QMessageBox::critical(this, tr("Error"), tr("Invalid profile or configuration."));
         return;
     }
+    if (!current_profile->plugin.isEmpty() && !current_profile->plugin_trusted) {//came from a subscription
+        QMessageBox::StandardButton answer = QMessageBox::question(this, tr("Run Plugin"), tr("This profile runs the plugin program below. Only continue if you trust it.\n\n%1 %2").arg(current_profile->plugin).arg(current_profile->plugin_opts));
+        if (answer != QMessageBox::Yes) {
+            return;
+        }
+        current_profile->plugin_trusted = true;
+        m_conf->profileStore()->update(m_conf->currentId());
+        saveConfig();
+    }
+    startBackend();
+}
 
+void MainWindow::reportAutoStartFailure()
+{
+    if (!autoStartFailure.isEmpty()) {
+        QMessageBox::critical(this, tr("Error"), autoStartFailure);
+        autoStartFailure.clear();
+    }
+}
+
+void MainWindow::startBackend()
+{
+    logParser.setBackendType(current_profile->getBackendTypeID());
+    if (logFile.open(LogFile::pathForProfile(jsonconfigFile, current_profile->profileName))) {
+        logFile.write(QString("---- %1 Starting profile %2 ----\n").arg(QDateTime::currentDateTime().toString(Qt::ISODate)).arg(current_profile->profileName).toLocal8Bit());
+    }
+    connectionModel->clear();
+    if (metricsCollector) {
+        metricsCollector->setProfile(current_profile->profileName);
+    }
+    if (daemonLink.isAttached()) {//the daemon runs it, we only watch
+        daemonLink.start(current_profile->profileName);
+        return;
+    }
+    ss_local.setRelayMode(m_conf->isRelayMode());
+    ss_local.setConnectProbe(m_conf->isConnectProbe());
     ss_local.start(current_profile);
 }
 
+void MainWindow::stopButtonPressed()
+{
+    if (daemonLink.isAttached()) {
+        daemonLink.stop();
+    } else {
+        ss_local.stop();
+    }
+}
+
+void MainWindow::onDaemonStarted(const QString &profileName, qint64 pid)
+{
+    Q_UNUSED(profileName);
+    daemonPid = pid;
+    processStarted();
+}
+
+void MainWindow::onDaemonFailed(const QString &error)
+{
+    qWarning() << "The daemon refused to start the profile:" << error;
+    ui->logBrowser->append(tr("The daemon couldn't start the profile: %1").arg(error));
+    showNotification(tr("Profile: %1 failed to start").arg(current_profile->profileName));
+}
+
+void MainWindow::onDaemonDetached()
+{
+    qDebug() << "The daemon went away, running backends locally from now on";
+    daemonPid = 0;
+    if (ui->stopButton->isEnabled()) {
+        processStopped();
+    }
+    controlServer->listen();
+}
+
+bool MainWindow::startProfile(ProfileId id, QString *error)
+{
+    if (id != 0 && id != m_conf->currentId() && !switchProfile(id, error)) {
+        return false;
+    }
+    //don't pop up a message box for a script
+    if (!current_profile->isValid()) {
+        *error = QString("invalid profile or backend");
+        return false;
+    }
+    if (!current_profile->plugin.isEmpty() && !current_profile->plugin_trusted) {//startButtonPressed() would ask
+        *error = QString("plugin not confirmed, start the profile once from the window");
+        return false;
+    }
+    if (!ss_local.isRunning()) {
+        startButtonPressed();
+    }
+    return true;
+}
+
+void MainWindow::stopProfile(ProfileId id)
+{
+    if (id == 0 || id == m_conf->currentId()) {
+        stopButtonPressed();
+    }
+}
+
+bool MainWindow::switchProfile(ProfileId id, QString *error)
+{
+    int row = m_conf->profileStore()->rowOf(id);
+    if (row < 0) {
+        *error = QString("no such profile");
+        return false;
+    }
+    bool wasRunning = ss_local.isRunning();
+    ui->profileComboBox->setCurrentIndex(row);//onCurrentProfileChanged() stops the backend if the profile differs
+    if (wasRunning) {
+        if (!current_profile->isValid()) {
+            *error = QString("invalid profile or backend");
+            return false;
+        }
+        startButtonPressed();
+    }
+    return true;
+}
+
+QJsonObject MainWindow::status() const
+{
+    QJsonArray instances;
+    if (current_profile) {
+        QJsonObject inst;
+        inst["profile"] = current_profile->profileName;
+        inst["running"] = ss_local.isRunning();
+        inst["pid"] = double(ss_local.pid());
+        instances.append(inst);
+    }
+    QJsonObject s;
+    s["instances"] = instances;
+    return s;
+}
+
+QJsonObject MainWindow::stats() const
+{
+    QJsonObject s;
+    if (current_profile && ss_local.isRunning()) {
+        s[current_profile->profileName] = ControlServer::processStats(&ss_local);
+    }
+    return s;
+}
+
 void MainWindow::showNotification(const QString &msg)
 {
 #ifdef Q_OS_LINUX
@@ -332,9 +559,17 @@ void MainWindow::showNotification(const QString &msg)
 
 void MainWindow::deleteProfile()
 {
-    int i = ui->profileComboBox->currentIndex();
-    m_conf->deleteProfile(i);
-    ui->profileComboBox->removeItem(i);
+    //stop while current_profile still points at the profile being deleted, processStopped() uses it
+    ss_local.stop();
+    current_profile = 0;
+
+    ui->profileComboBox->blockSignals(true);
+    m_conf->deleteProfile(m_conf->currentId());
+    int row = m_conf->profileStore()->rowOf(m_conf->currentId());
+    ui->profileComboBox->setCurrentIndex(row);
+    ui->profileComboBox->blockSignals(false);
+    emit configurationChanged();
+    onCurrentProfileChanged(row);//asks for a new profile if that was the last one
 }
 
 void MainWindow::processStarted()
@@ -344,9 +579,17 @@ void MainWindow::processStarted()
     ui->stopButton->setEnabled(true);
     ui->startButton->setEnabled(false);
     ui->logBrowser->clear();
+    logEvents.clear();
+    logEventModel->refresh();
 
     systray.setIcon(QIcon(":/icon/running_icon.png"));
     showNotification(tr("Profile: %1 Started").arg(current_profile->profileName));
+    QJsonObject event;
+    event["event"] = QString("started");
+    event["profile"] = current_profile->profileName;
+    event["pid"] = double(ss_local.pid());
+    controlServer->publish("state", event);
+    resourceMonitor.start(daemonLink.isAttached() ? daemonPid : ss_local.pid());
 }
 
 void MainWindow::processStopped()
@@ -355,6 +598,9 @@ void MainWindow::processStopped()
     systrayMenu.actions().at(2)->setEnabled(false);
     ui->stopButton->setEnabled(false);
     ui->startButton->setEnabled(true);
+    logFile.flush();
+    resourceMonitor.stop();
+    systray.setToolTip(QString("Shadowsocks-Qt5"));
 
 #ifdef Q_OS_WIN
     systray.setIcon(QIcon(":/icon/black_icon.png"));
@@ -363,6 +609,10 @@ void MainWindow::processStopped()
 #endif
 
     showNotification(tr("Profile: %1 Stopped").arg(current_profile->profileName));
+    QJsonObject event;
+    event["event"] = QString("stopped");
+    event["profile"] = current_profile->profileName;
+    controlServer->publish("state", event);
 }
 
 void MainWindow::showWindow()
@@ -412,6 +662,37 @@ void MainWindow::onReadReadyProcess(const QByteArray &o)
     ui->logBrowser->moveCursor(QTextCursor::End);
     ui->logBrowser->append(logStream);
     ui->logBrowser->moveCursor(QTextCursor::End);
+
+    logFile.write(o);
+    logParser.feed(o);
+    if (!daemonLink.isAttached()) {//the daemon publishes its own output
+        QJsonObject event;
+        event["event"] = QString("log");
+        event["profile"] = current_profile->profileName;
+        event["line"] = logStream;
+        controlServer->publish("log", event);
+    }
+    logEventModel->sync();//incremental, keeps the hidden view's rows valid when the store evicts
+}
+
+void MainWindow::onLogHistoryButtonClicked()
+{
+    if (!current_profile) {//no profile left, nothing has been logged
+        return;
+    }
+    LogViewer *viewer = new LogViewer(LogFile::pathForProfile(jsonconfigFile, current_profile->profileName), this);
+    viewer->show();
+}
+
+void MainWindow::onLogFilterChanged()
+{
+    int typeID = ui->logTypeCombo->currentIndex();//0 is All, the rest follow LogEventStore::EventType
+    int mask = typeID == 0 ? LogEventStore::AllMask : (1 << typeID);
+    bool filtered = !ui->logFilterEdit->text().isEmpty() || typeID != 0;
+
+    logEventModel->setFilter(ui->logFilterEdit->text(), mask);
+    ui->logEventView->setVisible(filtered);
+    ui->logBrowser->setVisible(!filtered);
 }
 
 void MainWindow::onConfigurationChanged(bool saved)
@@ -424,7 +705,7 @@ void MainWindow::backendTypeChanged(const QString &type)
 {
     current_profile->type = type;
 
-    ui->backendEdit->setText(current_profile->getBackend());
+    showBackend(current_profile->getBackend());
 
     int tID = current_profile->getBackendTypeID();
     if (tID == 2) {//shadowsocks-go doesn't support timeout argument
@@ -450,12 +731,14 @@ void MainWindow::backendTypeChanged(const QString &type)
 void MainWindow::serverEditFinished(const QString &str)
 {
     current_profile->server = str;
+    m_conf->profileStore()->update(m_conf->currentId());
     emit configurationChanged();
 }
 
 void MainWindow::sportEditFinished(const QString &str)
 {
     current_profile->server_port = str;
+    m_conf->profileStore()->update(m_conf->currentId());
     emit configurationChanged();
 }
 
@@ -527,9 +810,205 @@ void MainWindow::relativePathToggled(bool r)
     emit configurationChanged();
 }
 
+void MainWindow::relayModeToggled(bool r)
+{
+    m_conf->setRelayMode(r);
+    emit configurationChanged();
+}
+
+void MainWindow::connectProbeToggled(bool p)
+{
+    m_conf->setConnectProbe(p);
+    emit configurationChanged();
+}
+
+void MainWindow::onSessionsUpdated()
+{
+    RelayTotals t = ss_local.relay()->totals();
+    QString summary = tr("Active: %1  Total: %2  Sent: %3  Received: %4")
+            .arg(t.active)
+            .arg(t.sessions)
+            .arg(ConnectionModel::formatBytes(t.bytesUp))
+            .arg(ConnectionModel::formatBytes(t.bytesDown));
+    if (t.shaped > 0 || t.rejected > 0) {//only once the profile's limits have been hit
+        summary += tr("  Shaped: %1  Refused: %2").arg(ConnectionModel::formatBytes(t.shaped)).arg(t.rejected);
+    }
+    connectionSummary = summary;
+    if (connectionsPanel) {
+        connectionsPanel->setSummary(summary);
+    }
+}
+
+void MainWindow::onTabChanged(int index)
+{
+    //the monitoring tabs are built when first opened, most sessions never look at them
+    QWidget *tab = ui->tabWidget->widget(index);
+    if (tab == ui->connectionsTab && !connectionsPanel) {
+        connectionsPanel = new ConnectionsPanel(connectionModel, tab);
+        ui->connectionsTabLayout->addWidget(connectionsPanel);
+        connect(connectionsPanel, &ConnectionsPanel::exportLatencyRequested, this, &MainWindow::onExportLatencyButtonClicked);
+        if (!connectionSummary.isEmpty()) {
+            connectionsPanel->setSummary(connectionSummary);
+        }
+        updateLatencyLabel();
+    } else if (tab == ui->resourcesTab && !resourcesPanel) {
+        resourcesPanel = new ResourcesPanel(tab);
+        ui->resourcesTabLayout->addWidget(resourcesPanel);
+        resourcesPanel->setHistory(resourceMonitor.history());
+    }
+}
+
+void MainWindow::updateLatencyLabel()
+{
+    if (!connectionsPanel || !ui->connectionsTab->isVisible() || !current_profile) {
+        return;
+    }
+
+    LatencySet l = ss_local.latency(current_profile->profileName);
+    connectionsPanel->setLatency(QString("<table><tr><td>%1&nbsp;</td><td>%2</td></tr><tr><td>%3&nbsp;</td><td>%4</td></tr><tr><td>%5&nbsp;</td><td>%6</td></tr></table>")
+                              .arg(tr("Connect")).arg(l.connect.summary())
+                              .arg(tr("First byte")).arg(l.ttfb.summary())
+                              .arg(tr("Duration")).arg(l.duration.summary()));
+}
+
+void MainWindow::onExportLatencyButtonClicked()
+{
+    QString file = QFileDialog::getSaveFileName(this, tr("Export Latency Histograms"), current_profile->profileName + ".hgrm");
+    if (file.isEmpty()) {
+        return;
+    }
+
+    QFile out(file);
+    if (!out.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        QMessageBox::critical(this, tr("Error"), tr("Cannot write to %1").arg(file));
+        return;
+    }
+    QTextStream stream(&out);
+    LatencySet l = ss_local.latency(current_profile->profileName);
+    QString server = QString("%1:%2").arg(current_profile->server).arg(current_profile->server_port);
+    l.connect.exportDistribution(stream, QString("connect %1 %2").arg(current_profile->profileName).arg(server));
+    l.ttfb.exportDistribution(stream, QString("first-byte %1 %2").arg(current_profile->profileName).arg(server));
+    l.duration.exportDistribution(stream, QString("duration %1 %2").arg(current_profile->profileName).arg(server));
+}
+
+void MainWindow::onProcessSampled(const ProcessSample &s)
+{
+    QVector<double> cpu, rss;
+    const QVector<ProcessSample> &history = resourceMonitor.history();
+    for (QVector<ProcessSample>::const_iterator it = history.constBegin(); it != history.constEnd(); ++it) {
+        cpu << it->cpuPercent;
+        rss << it->rssKiB;
+    }
+
+    if (resourcesPanel) {
+        resourcesPanel->setHistory(history);
+    }
+
+    systray.setToolTip(tr("Shadowsocks-Qt5: %1\nCPU %2 %3%\nMemory %4 %5")
+                       .arg(current_profile->profileName)
+                       .arg(SparklineWidget::toText(cpu)).arg(s.cpuPercent, 0, 'f', 0)
+                       .arg(SparklineWidget::toText(rss)).arg(ConnectionModel::formatBytes(quint64(s.rssKiB) * 1024)));
+}
+
+void MainWindow::onProfileSearchEdited(const QString &text)
+{
+    if (!profileCompleter) {//built on first use, most sessions never search
+        profileSearchModel = new ProfileSearchModel(m_conf->profileStore(), this);
+        profileCompleter = new QCompleter(profileSearchModel, this);
+        profileCompleter->setCompletionMode(QCompleter::UnfilteredPopupCompletion);
+        profileCompleter->setMaxVisibleItems(20);
+        ui->profileSearchEdit->setCompleter(profileCompleter);
+        connect(profileCompleter, static_cast<void (QCompleter::*)(const QModelIndex &)>(&QCompleter::activated), this, &MainWindow::onProfileSearchActivated);
+    }
+    profileSearchModel->setQuery(text);
+    if (!text.isEmpty()) {
+        profileCompleter->complete();
+    }
+}
+
+void MainWindow::onProfileSearchActivated(const QModelIndex &index)
+{
+    ProfileId id = index.data(ProfileModel::IdRole).toUInt();
+    ui->profileComboBox->setCurrentIndex(m_conf->profileStore()->rowOf(id));
+    //the completer writes the chosen name into the edit right after this signal
+    QMetaObject::invokeMethod(ui->profileSearchEdit, "clear", Qt::QueuedConnection);
+}
+
+void MainWindow::onSubscriptionsButtonClicked()
+{
+    SubscriptionDialogue *dlg = new SubscriptionDialogue(m_conf, subscriptionManager, this);
+    connect(dlg, &SubscriptionDialogue::subscriptionsEdited, [this] { emit configurationChanged(); });
+    dlg->setAttribute(Qt::WA_DeleteOnClose);
+    dlg->exec();
+}
+
+void MainWindow::onSubscriptionRefreshed(const QString &name, int added, int updated, int removed)
+{
+    Q_UNUSED(name);
+    //the refresh time is persisted too, but only a changed list is worth asking to save
+    if (added + updated + removed > 0) {
+        emit configurationChanged();
+    }
+}
+
+void MainWindow::onSubscriptionFailed(const QString &name, const QString &error)
+{
+    showNotification(tr("Failed to update subscription %1: %2").arg(name).arg(error));
+}
+
+void MainWindow::onAboutToReloadProfiles()
+{
+    //removing the selected row moves the combo box, don't let it switch profiles behind the merge
+    ui->profileComboBox->blockSignals(true);
+}
+
+void MainWindow::onProfilesReloaded(const QVector<ProfileId> &changed, int added, int removed, bool currentReplaced)
+{
+    int row = m_conf->profileStore()->rowOf(m_conf->currentId());
+    ui->profileComboBox->setCurrentIndex(row);
+    ui->profileComboBox->blockSignals(false);
+    if (changed.isEmpty() && added == 0 && removed == 0) {
+        return;
+    }
+
+    qDebug() << "gui-config.json changed on disk:" << changed.size() << "profiles changed," << added << "added," << removed << "removed";
+    if (currentReplaced) {
+        //current_profile is gone with the removed row, don't touch it before it's reloaded below
+        if (ss_local.isRunning()) {
+            ss_local.stop();
+            showNotification(tr("The running profile was removed on disk, backend stopped."));
+        }
+        emit configurationChanged();
+        onCurrentProfileChanged(row);
+        return;
+    }
+    if (!changed.contains(m_conf->currentId())) {
+        return;//the backend keeps running untouched
+    }
+
+    bool wasRunning = ss_local.isRunning();
+    onCurrentProfileChanged(row);//reloads the fields, starting again below restarts the backend
+    if (wasRunning && row >= 0) {
+        startButtonPressed();
+        showNotification(tr("Profile %1 was changed on disk, backend restarted.").arg(current_profile->profileName));
+    }
+}
+
+void MainWindow::showBackend(const QString &path)
+{
+    ui->backendEdit->setText(path);
+    QString version = BackendRegistry::instance()->info(path).version;
+    ui->backendEdit->setToolTip(version.isEmpty() ? QString() : tr("Version %1").arg(version));
+}
+
 void MainWindow::blockChildrenSignals(bool b)
 {
-    QList<QWidget *> children = this->findChildren<QWidget *>();
+    /*
+     * Walked every time, widgets come and go after setupUi(). Only the
+     * central widget holds the profile fields, dialogs parented to the
+     * window are left alone.
+     */
+    QList<QWidget *> children = ui->centralWidget->findChildren<QWidget *>();
     for (QList<QWidget *>::iterator it = children.begin(); it != children.end(); ++it) {
         (*it)->blockSignals(b);
     }
@@ -18,6 +18,7 @@
 #include <QInputDialog>
 #include <QMessageBox>
 #include <QCloseEvent>
+#include <QTimer>
 #include "ssprofile.h"
 #include "configuration.h"
 #include "ss_process.h"
@@ -25,12 +26,29 @@
 #include "ip4validator.h"
 #include "portvalidator.h"
 #include "addprofiledialogue.h"
+#include "logeventstore.h"
+#include "logparser.h"
+#include "logeventmodel.h"
+#include "logfile.h"
+#include "connectionmodel.h"
+#include "metricsserver.h"
+#include "metricscollector.h"
+#include "processmonitor.h"
+#include "profilemodel.h"
+#include "subscriptionmanager.h"
+#include "configwatcher.h"
+#include "daemonlink.h"
+#include "controlserver.h"
+
+class QCompleter;
+class ConnectionsPanel;
+class ResourcesPanel;
 
 namespace Ui {
 class MainWindow;
 }
 
-class MainWindow : public QMainWindow
+class MainWindow : public QMainWindow, public ControlTarget
 {
     Q_OBJECT
 
@@ -44,12 +62,21 @@ signals:
 
 public:
     void minimizeToSysTray();
+    inline bool isAttached() const { return daemonLink.isAttached(); }
+    //why the constructor didn't start the autostart profile, if it didn't
+    void reportAutoStartFailure();
+
+    bool startProfile(ProfileId id, QString *error);
+    void stopProfile(ProfileId id);
+    bool switchProfile(ProfileId id, QString *error);
+    QJsonObject status() const;
+    QJsonObject stats() const;
 
 public slots:
     void startButtonPressed();
 
 private slots:
-    inline void stopButtonPressed() { ss_local.stop(); }
+    void stopButtonPressed();
     void addProfileDialogue(bool);
     void backendTypeChanged(const QString &);
     void deleteProfile();
@@ -63,7 +90,10 @@ private slots:
     void onCurrentProfileChanged(int);
     void onCustomArgsEditFinished(const QString &);
     void onShareButtonClicked();
+    void onExportButtonClicked();
     void onReadReadyProcess(const QByteArray &o);
+    void onLogFilterChanged();
+    void onLogHistoryButtonClicked();
     void processStarted();
     void processStopped();
     void profileEditButtonClicked(QAbstractButton*);
@@ -81,6 +111,23 @@ private slots:
     void autoStartToggled(bool);
     void debugToggled(bool);
     void relativePathToggled(bool);
+    void relayModeToggled(bool);
+    void connectProbeToggled(bool);
+    void onSessionsUpdated();
+    void onTabChanged(int index);
+    void updateLatencyLabel();
+    void onExportLatencyButtonClicked();
+    void onProcessSampled(const ProcessSample &sample);
+    void onProfileSearchEdited(const QString &text);
+    void onProfileSearchActivated(const QModelIndex &index);
+    void onSubscriptionsButtonClicked();
+    void onSubscriptionRefreshed(const QString &name, int added, int updated, int removed);
+    void onSubscriptionFailed(const QString &name, const QString &error);
+    void onAboutToReloadProfiles();
+    void onProfilesReloaded(const QVector<ProfileId> &changed, int added, int removed, bool currentReplaced);
+    void onDaemonStarted(const QString &profileName, qint64 pid);
+    void onDaemonFailed(const QString &error);
+    void onDaemonDetached();
     void saveConfig();
     void transculentToggled(bool);
 
@@ -88,16 +135,39 @@ private:
     AddProfileDialogue *addProfileDlg;
     bool verboseOutput;
     IP4Validator ipv4addrValidator;
+    LogEventStore logEvents;
+    LogParser logParser;
+    LogEventModel *logEventModel;
+    LogFile logFile;
+    ConnectionModel *connectionModel;
+    MetricsServer metricsServer;
+    QTimer statsTimer;
+    ProcessMonitor resourceMonitor;
+    MetricsCollector *metricsCollector;
+    ProfileModel *profileModel;
+    ProfileSearchModel *profileSearchModel;
+    QCompleter *profileCompleter;
+    ConnectionsPanel *connectionsPanel;//built when their tab is first opened
+    ResourcesPanel *resourcesPanel;
+    QString connectionSummary;
+    SubscriptionManager *subscriptionManager;
+    ConfigWatcher *configWatcher;
     PortValidator portValidator;
     QMenu systrayMenu;
     QString jsonconfigFile;
     QSystemTrayIcon systray;
     SS_Process ss_local;
+    DaemonLink daemonLink;
+    ControlServer *controlServer;
+    qint64 daemonPid;
     SSProfile *current_profile;
     static const QString aboutText;
     Ui::MainWindow *ui;
     void showNotification(const QString &);
+    void showBackend(const QString &path);
+    void startBackend();
     void blockChildrenSignals(bool);
+    QString autoStartFailure;
 
 #ifdef Q_OS_LINUX
     bool isUbuntuUnity;
@@ -0,0 +1,116 @@
+#include "ss_process.h"
+#include "metricsserver.h"
+#include "metricscollector.h"
+
+const int MetricsCollector::RefreshInterval = 5000;
+const qint64 MetricsCollector::BucketBoundsMs[] = { 1, 5, 10, 25, 50, 100, 250, 500, 1000, 2500, 5000, 10000, 30000, 60000, 300000 };
+
+MetricsCollector::MetricsCollector(SS_Process *process, MetricsServer *server, QObject *parent) :
+    QObject(parent),
+    m_process(process),
+    m_server(server)
+{
+    connect(m_process, &SS_Process::sigstart, this, &MetricsCollector::onStarted);
+    connect(m_process, &SS_Process::sigstop, this, &MetricsCollector::onStopped);
+    connect(&m_timer, &QTimer::timeout, this, &MetricsCollector::refresh);
+    m_timer.start(RefreshInterval);
+}
+
+void MetricsCollector::setProfile(const QString &name)
+{
+    m_profile = name;
+    if (!m_profiles.contains(name)) {
+        m_profiles.insert(name, ProfileMetrics());
+    }
+}
+
+void MetricsCollector::onStarted()
+{
+    m_running = m_profile;
+    m_profiles[m_running].starts++;
+    m_baseline = m_process->relay()->totals();
+    m_uptime.start();
+    refresh();
+}
+
+void MetricsCollector::onStopped()
+{
+    if (m_running.isEmpty()) {
+        return;
+    }
+    RelayTotals run = m_process->relay()->totals();
+    run -= m_baseline;
+    run.active = 0;
+    m_profiles[m_running].relay += run;
+    m_running.clear();
+    m_uptime.invalidate();
+    refresh();
+}
+
+void MetricsCollector::refresh()
+{
+    m_server->publish(render());
+}
+
+QString MetricsCollector::escape(const QString &label)
+{
+    QString e = label;
+    e.replace('\\', "\\\\").replace('"', "\\\"").replace('\n', "\\n");
+    return e;
+}
+
+QString MetricsCollector::histogram(const QString &name, const QString &label, const LatencyHistogram &h)
+{
+    QString out;
+    const int bounds = sizeof(BucketBoundsMs) / sizeof(BucketBoundsMs[0]);
+    for (int b = 0; b < bounds; ++b) {
+        out += QString("%1_bucket{%2,le=\"%3\"} %4\n").arg(name).arg(label).arg(BucketBoundsMs[b] / 1000.0).arg(h.countAtOrBelow(BucketBoundsMs[b] * 1000));
+    }
+    out += QString("%1_bucket{%2,le=\"+Inf\"} %3\n").arg(name).arg(label).arg(h.count());
+    out += QString("%1_sum{%2} %3\n").arg(name).arg(label).arg(h.mean() * h.count() / 1e6);
+    out += QString("%1_count{%2} %3\n").arg(name).arg(label).arg(h.count());
+    return out;
+}
+
+QByteArray MetricsCollector::render() const
+{
+    QString up, restarts, uptime, bytes, active, shaped, rejected, connectLatency, ttfb, duration;
+    for (QHash<QString, ProfileMetrics>::const_iterator it = m_profiles.constBegin(); it != m_profiles.constEnd(); ++it) {
+        const bool running = !m_running.isEmpty() && it.key() == m_running;
+        const QString label = QString("profile=\"%1\"").arg(escape(it.key()));
+
+        RelayTotals t = it->relay;
+        if (running) {
+            RelayTotals current = m_process->relay()->totals();
+            current -= m_baseline;
+            t += current;
+        }
+
+        up += QString("ssqt5_backend_up{%1} %2\n").arg(label).arg(running ? 1 : 0);
+        restarts += QString("ssqt5_backend_restarts_total{%1} %2\n").arg(label).arg(it->starts > 0 ? it->starts - 1 : 0);
+        uptime += QString("ssqt5_backend_uptime_seconds{%1} %2\n").arg(label).arg(running ? m_uptime.elapsed() / 1000.0 : 0.0);
+        bytes += QString("ssqt5_relay_bytes_total{%1,direction=\"up\"} %2\n").arg(label).arg(t.bytesUp);
+        bytes += QString("ssqt5_relay_bytes_total{%1,direction=\"down\"} %2\n").arg(label).arg(t.bytesDown);
+        active += QString("ssqt5_relay_active_connections{%1} %2\n").arg(label).arg(t.active);
+        shaped += QString("ssqt5_relay_shaped_bytes_total{%1} %2\n").arg(label).arg(t.shaped);
+        rejected += QString("ssqt5_relay_rejected_connections_total{%1} %2\n").arg(label).arg(t.rejected);
+
+        LatencySet l = m_process->latency(it.key());
+        connectLatency += histogram("ssqt5_connect_latency_seconds", label, l.connect);
+        ttfb += histogram("ssqt5_first_byte_latency_seconds", label, l.ttfb);
+        duration += histogram("ssqt5_session_duration_seconds", label, l.duration);
+    }
+
+    QString out;
+    out += "# HELP ssqt5_backend_up Whether the backend of the profile is running.\n# TYPE ssqt5_backend_up gauge\n" + up;
+    out += "# HELP ssqt5_backend_restarts_total Times the profile was started again after its first start.\n# TYPE ssqt5_backend_restarts_total counter\n" + restarts;
+    out += "# HELP ssqt5_backend_uptime_seconds Seconds since the running backend was started.\n# TYPE ssqt5_backend_uptime_seconds gauge\n" + uptime;
+    out += "# HELP ssqt5_relay_bytes_total Bytes forwarded by the relay.\n# TYPE ssqt5_relay_bytes_total counter\n" + bytes;
+    out += "# HELP ssqt5_relay_active_connections Sessions currently open through the relay.\n# TYPE ssqt5_relay_active_connections gauge\n" + active;
+    out += "# HELP ssqt5_relay_shaped_bytes_total Bytes the relay held back to keep to the profile's rate limits.\n# TYPE ssqt5_relay_shaped_bytes_total counter\n" + shaped;
+    out += "# HELP ssqt5_relay_rejected_connections_total Connections refused over the profile's session limit.\n# TYPE ssqt5_relay_rejected_connections_total counter\n" + rejected;
+    out += "# HELP ssqt5_connect_latency_seconds Time to open a TCP connection to the profile's server.\n# TYPE ssqt5_connect_latency_seconds histogram\n" + connectLatency;
+    out += "# HELP ssqt5_first_byte_latency_seconds Time from a SOCKS request to the first byte of the response.\n# TYPE ssqt5_first_byte_latency_seconds histogram\n" + ttfb;
+    out += "# HELP ssqt5_session_duration_seconds Lifetime of relayed sessions.\n# TYPE ssqt5_session_duration_seconds histogram\n" + duration;
+    return out.toUtf8();
+}
@@ -0,0 +1,60 @@
+/*
+ * Metrics Collector Class
+ *
+ * Keeps per-profile figures of SS_Process and its relay and periodically
+ * renders them into a snapshot for the MetricsServer.
+ */
+#ifndef METRICSCOLLECTOR_H
+#define METRICSCOLLECTOR_H
+#include <QObject>
+#include <QHash>
+#include <QTimer>
+#include <QElapsedTimer>
+#include "connectioninfo.h"
+#include "latencyhistogram.h"
+
+class SS_Process;
+class MetricsServer;
+
+class MetricsCollector : public QObject
+{
+    Q_OBJECT
+
+public:
+    MetricsCollector(SS_Process *process, MetricsServer *server, QObject *parent = 0);
+    void setProfile(const QString &name);
+    QByteArray render() const;
+
+    static const int RefreshInterval;
+
+public slots:
+    void refresh();
+
+private:
+    struct ProfileMetrics
+    {
+        quint64 starts;
+        RelayTotals relay;//completed runs only
+        ProfileMetrics() : starts(0) {}
+    };
+
+    SS_Process *m_process;
+    MetricsServer *m_server;
+    QTimer m_timer;
+    QString m_profile;
+    QString m_running;
+    QElapsedTimer m_uptime;
+    RelayTotals m_baseline;
+    QHash<QString, ProfileMetrics> m_profiles;
+
+    static const qint64 BucketBoundsMs[];
+
+    static QString escape(const QString &label);
+    static QString histogram(const QString &name, const QString &label, const LatencyHistogram &h);
+
+private slots:
+    void onStarted();
+    void onStopped();
+};
+
+#endif // METRICSCOLLECTOR_H
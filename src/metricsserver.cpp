@@ -0,0 +1,112 @@
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QHostAddress>
+#include <QDebug>
+#include "metricsserver.h"
+
+MetricsServer::MetricsServer(QObject *parent) :
+    QObject(parent),
+    m_server(0)
+{}
+
+MetricsServer::~MetricsServer()
+{
+    stop();
+}
+
+bool MetricsServer::start(quint16 port)
+{
+    stop();
+
+    /*
+     * The listening socket is created here and then moved, so that a failure
+     * to bind can be reported synchronously.
+     */
+    m_server = new QTcpServer;
+    if (!m_server->listen(QHostAddress::LocalHost, port)) {
+        qWarning() << "Warning: metrics endpoint cannot listen on port" << port << m_server->errorString();
+        delete m_server;
+        m_server = 0;
+        return false;
+    }
+
+    MetricsListener *listener = new MetricsListener(this);
+    listener->moveToThread(&m_thread);
+    m_server->moveToThread(&m_thread);
+    connect(m_server, &QTcpServer::newConnection, listener, &MetricsListener::onNewConnection);
+    connect(&m_thread, &QThread::finished, m_server, &QObject::deleteLater);
+    connect(&m_thread, &QThread::finished, listener, &QObject::deleteLater);
+    m_thread.start();
+    return true;
+}
+
+void MetricsServer::stop()
+{
+    if (m_thread.isRunning()) {
+        m_thread.quit();
+        m_thread.wait();
+    }
+    m_server = 0;
+}
+
+void MetricsServer::publish(const QByteArray &snapshot)
+{
+    QMutexLocker locker(&m_mutex);
+    m_snapshot = snapshot;
+}
+
+QByteArray MetricsServer::snapshot() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_snapshot;//implicitly shared, the lock only covers a reference count bump
+}
+
+MetricsListener::MetricsListener(MetricsServer *owner, QObject *parent) :
+    QObject(parent),
+    m_owner(owner)
+{}
+
+void MetricsListener::onNewConnection()
+{
+    QTcpServer *server = qobject_cast<QTcpServer *>(sender());
+    while (QTcpSocket *socket = server->nextPendingConnection()) {
+        connect(socket, &QTcpSocket::readyRead, this, &MetricsListener::onReadyRead);
+        connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+    }
+}
+
+void MetricsListener::onReadyRead()
+{
+    QTcpSocket *socket = qobject_cast<QTcpSocket *>(sender());
+    if (!socket->canReadLine()) {
+        if (socket->bytesAvailable() > 8192) {
+            socket->abort();
+        }
+        return;
+    }
+
+    //only the request line matters, headers are ignored
+    QList<QByteArray> request = socket->readLine().trimmed().split(' ');
+    disconnect(socket, &QTcpSocket::readyRead, this, &MetricsListener::onReadyRead);
+
+    QByteArray status("200 OK");
+    QByteArray body;
+    if (request.size() < 2 || request.at(0) != "GET") {
+        status = "405 Method Not Allowed";
+    }
+    else if (request.at(1) != "/metrics" && request.at(1) != "/") {
+        status = "404 Not Found";
+    }
+    else {
+        body = m_owner->snapshot();
+    }
+
+    QByteArray response("HTTP/1.1 ");
+    response.append(status).append("\r\n");
+    response.append("Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n");
+    response.append("Content-Length: ").append(QByteArray::number(body.size())).append("\r\n");
+    response.append("Connection: close\r\n\r\n");
+    response.append(body);
+    socket->write(response);
+    socket->disconnectFromHost();
+}
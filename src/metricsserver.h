@@ -0,0 +1,53 @@
+/*
+ * Metrics Server Class
+ *
+ * A minimal HTTP endpoint on localhost serving Prometheus text format.
+ * It runs in its own thread and only ever serves the last published
+ * snapshot, so a scrape never waits for the GUI or the relay.
+ */
+#ifndef METRICSSERVER_H
+#define METRICSSERVER_H
+#include <QObject>
+#include <QByteArray>
+#include <QMutex>
+#include <QThread>
+
+class QTcpServer;
+
+class MetricsServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    MetricsServer(QObject *parent = 0);
+    ~MetricsServer();
+    bool start(quint16 port);
+    void stop();
+    void publish(const QByteArray &snapshot);
+    QByteArray snapshot() const;
+
+private:
+    QThread m_thread;
+    QTcpServer *m_server;
+    mutable QMutex m_mutex;
+    QByteArray m_snapshot;
+};
+
+class MetricsListener : public QObject
+{
+    Q_OBJECT
+
+public:
+    MetricsListener(MetricsServer *owner, QObject *parent = 0);
+
+public slots:
+    void onNewConnection();
+
+private:
+    MetricsServer *m_owner;
+
+private slots:
+    void onReadyRead();
+};
+
+#endif // METRICSSERVER_H
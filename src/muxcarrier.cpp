@@ -0,0 +1,313 @@
+#include <QDebug>
+#include "socksaddress.h"
+#include "muxframe.h"
+#include "muxcarrier.h"
+
+const qint64 MuxCarrier::HighWater = 256 * 1024;
+
+MuxCarrier::MuxCarrier(QTcpSocket *socket, SSCipher *cipher, bool serverSide, const SocketOptions *options, WorkerCounters *counters, QObject *parent) :
+    QObject(parent),
+    m_socket(socket),
+    m_cipher(cipher),
+    m_serverSide(serverSide),
+    m_options(options),
+    m_counters(counters),
+    m_next(0),
+    m_nextId(1),
+    m_lost(false)
+{
+    m_idle.start();
+    if (!serverSide) {
+        //the carrier header stands where a session's target address would
+        m_control.append(char(MuxFrame::CarrierType));
+        m_control.append(char(MuxFrame::Version));
+    }
+
+    connect(m_socket, &QTcpSocket::readyRead, this, &MuxCarrier::onReadyRead);
+    connect(m_socket, &QTcpSocket::connected, this, &MuxCarrier::onConnected);
+    connect(m_socket, &QTcpSocket::bytesWritten, this, &MuxCarrier::pump);
+    connect(m_socket, &QTcpSocket::disconnected, this, &MuxCarrier::onDisconnected);
+    connect(m_socket, static_cast<void (QAbstractSocket::*)(QAbstractSocket::SocketError)>(&QAbstractSocket::error), this, &MuxCarrier::onDisconnected);
+}
+
+MuxCarrier::~MuxCarrier()
+{
+    closeAll();
+}
+
+qint64 MuxCarrier::load() const
+{
+    //every stream may have a frame in flight, plus whatever is queued already
+    return qint64(m_streams.size()) * MuxFrame::MaxPayload + m_socket->bytesToWrite();
+}
+
+void MuxCarrier::openStream(QTcpSocket *local, const QByteArray &address)
+{
+    Stream *s = addStream(m_nextId++, local);
+    s->connected = true;
+    MuxFrame::append(m_control, MuxFrame::Open, s->id, address.constData(), address.size());
+    pump();
+}
+
+void MuxCarrier::feed(const QByteArray &plain)
+{
+    m_in.append(plain);
+    processFrames();
+}
+
+void MuxCarrier::closeAll()
+{
+    while (!m_order.isEmpty()) {
+        removeStream(m_order.first(), true);
+    }
+}
+
+MuxCarrier::Stream *MuxCarrier::addStream(quint32 id, QTcpSocket *socket)
+{
+    Stream *s = new Stream;
+    s->id = id;
+    s->socket = socket;
+    s->credit = MuxFrame::InitialWindow;
+    s->window = MuxFrame::InitialWindow;
+    s->unacked = 0;
+    s->connected = false;
+    s->eof = false;
+    m_streams.insert(id, s);
+    m_order.append(s);
+
+    //bounded, so that a stream without credit leaves its data in the kernel
+    socket->setParent(this);
+    socket->setReadBufferSize(4 * MuxFrame::MaxPayload);
+    connect(socket, &QTcpSocket::readyRead, this, &MuxCarrier::pump);
+    connect(socket, &QTcpSocket::bytesWritten, this, [this, s](qint64 bytes) { onStreamWritten(s, bytes); });
+    connect(socket, &QTcpSocket::connected, this, [this, s]() { onStreamConnected(s); });
+    connect(socket, &QTcpSocket::disconnected, this, [this, s]() { onStreamClosed(s); });
+    connect(socket, static_cast<void (QAbstractSocket::*)(QAbstractSocket::SocketError)>(&QAbstractSocket::error), this, [this, s]() { onStreamClosed(s); });
+    return s;
+}
+
+void MuxCarrier::removeStream(Stream *s, bool abort)
+{
+    int index = m_order.indexOf(s);
+    m_order.removeAt(index);
+    if (index < m_next) {
+        --m_next;
+    }
+    m_streams.remove(s->id);
+    if (m_serverSide && m_counters) {
+        m_counters->active.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    QTcpSocket *socket = s->socket;
+    delete s;
+    socket->disconnect(this);
+    if (!abort) {
+        socket->disconnectFromHost();//waits until the data received for it has been written
+    }
+    if (abort || socket->state() == QAbstractSocket::UnconnectedState) {
+        socket->abort();
+        socket->deleteLater();
+    }
+    else {
+        connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+    }
+}
+
+void MuxCarrier::onConnected()
+{
+    m_options->apply(m_socket);
+    pump();
+}
+
+void MuxCarrier::onReadyRead()
+{
+    QByteArray data = m_socket->readAll();
+    if (data.isEmpty()) {
+        return;
+    }
+    m_in.append(m_cipher->decrypt(data));
+    m_idle.restart();
+    processFrames();
+}
+
+void MuxCarrier::processFrames()
+{
+    MuxFrame frame;
+    int offset = 0;
+    while (!m_lost) {
+        int used = MuxFrame::parse(m_in.constData() + offset, m_in.size() - offset, &frame);
+        if (used == 0) {
+            break;
+        }
+        if (used < 0) {
+            qWarning() << "Invalid mux frame, dropping the carrier";
+            m_in.clear();
+            m_socket->abort();
+            onDisconnected();
+            return;
+        }
+        handleFrame(frame.type, frame.stream, frame.payload, frame.length);
+        offset += used;
+    }
+    m_in.remove(0, offset);
+    pump();//for the windows granted and the streams reset meanwhile
+}
+
+void MuxCarrier::handleFrame(quint8 type, quint32 id, const char *payload, int length)
+{
+    //frames for a stream closed on this side may still be in flight, they are dropped
+    Stream *s = m_streams.value(id);
+    switch (type) {
+    case MuxFrame::Open:
+    {
+        QString host;
+        quint16 port;
+        if (!m_serverSide || s) {
+            break;
+        }
+        if (SocksAddress::parse(payload, length, &host, &port) <= 0) {
+            MuxFrame::append(m_control, MuxFrame::Reset, id);
+            break;
+        }
+        if (m_counters) {
+            m_counters->sessions.fetch_add(1, std::memory_order_relaxed);
+            m_counters->active.fetch_add(1, std::memory_order_relaxed);
+        }
+        s = addStream(id, new QTcpSocket(this));
+        m_options->connectToHost(s->socket, host, port);
+        break;
+    }
+    case MuxFrame::Data:
+        if (!s || s->eof) {
+            break;
+        }
+        if (length > s->window) {//nothing else bounds what a stream buffers here
+            qWarning() << "Mux stream" << id << "sent beyond its window, resetting it";
+            MuxFrame::append(m_control, MuxFrame::Reset, id);
+            removeStream(s, true);
+            break;
+        }
+        s->window -= length;
+        if (s->connected) {
+            s->socket->write(payload, length);
+        }
+        else {
+            s->pending.append(payload, length);
+        }
+        break;
+    case MuxFrame::Window:
+        if (s) {
+            const uchar *p = reinterpret_cast<const uchar *>(payload);
+            s->credit += (qint64(p[0]) << 24) | (qint64(p[1]) << 16) | (qint64(p[2]) << 8) | p[3];
+        }
+        break;
+    case MuxFrame::Close:
+        if (s) {
+            removeStream(s, false);
+        }
+        break;
+    case MuxFrame::Reset:
+        if (s) {
+            removeStream(s, true);
+        }
+        break;
+    }
+}
+
+void MuxCarrier::onStreamWritten(Stream *s, qint64 bytes)
+{
+    if (m_serverSide && m_counters) {
+        m_counters->bytesUp.fetch_add(bytes, std::memory_order_relaxed);
+    }
+
+    //granted in batches, a Window frame per byte written would double the traffic
+    s->unacked += bytes;
+    if (s->unacked >= MuxFrame::InitialWindow / 2) {
+        MuxFrame::appendWindow(m_control, s->id, quint32(s->unacked));
+        s->window += s->unacked;
+        s->unacked = 0;
+        pump();
+    }
+}
+
+void MuxCarrier::onStreamConnected(Stream *s)
+{
+    s->connected = true;
+    m_options->apply(s->socket);
+    if (!s->pending.isEmpty()) {
+        s->socket->write(s->pending);
+        s->pending.clear();
+    }
+    pump();
+}
+
+void MuxCarrier::onStreamClosed(Stream *s)
+{
+    if (!s->connected) {//the target cannot be reached
+        MuxFrame::append(m_control, MuxFrame::Reset, s->id);
+        removeStream(s, true);
+    }
+    else {
+        s->eof = true;//Close goes out once what is left has been sent
+    }
+    pump();
+}
+
+void MuxCarrier::pump()
+{
+    if (m_lost || m_socket->state() != QAbstractSocket::ConnectedState) {
+        return;//the client queues until the carrier is connected
+    }
+
+    QByteArray out = m_control;
+    m_control.clear();
+    qint64 room = HighWater - m_socket->bytesToWrite() - out.size();
+
+    //a frame from each ready stream in turn, so that no stream holds up the others for long
+    bool progress = true;
+    while (room > 0 && progress) {
+        progress = false;
+        for (int i = 0, n = m_order.size(); i < n && room > 0; ++i) {
+            if (m_next >= m_order.size()) {
+                m_next = 0;
+            }
+            Stream *s = m_order.at(m_next++);
+            qint64 chunk = qMin(qMin(s->socket->bytesAvailable(), s->credit), qint64(MuxFrame::MaxPayload));
+            if (chunk <= 0) {
+                continue;
+            }
+            QByteArray data = s->socket->read(chunk);
+            MuxFrame::append(out, MuxFrame::Data, s->id, data.constData(), data.size());
+            s->credit -= data.size();
+            room -= MuxFrame::HeaderSize + data.size();
+            if (m_serverSide && m_counters) {
+                m_counters->bytesDown.fetch_add(data.size(), std::memory_order_relaxed);
+            }
+            progress = true;
+        }
+    }
+
+    //streams whose socket is closed and drained end after their last frame
+    for (int i = m_order.size() - 1; i >= 0; --i) {
+        Stream *s = m_order.at(i);
+        if (s->eof && s->socket->bytesAvailable() == 0) {
+            MuxFrame::append(out, MuxFrame::Close, s->id);
+            removeStream(s, false);
+        }
+    }
+
+    if (!out.isEmpty()) {
+        m_socket->write(m_cipher->encrypt(out));
+        m_idle.restart();
+    }
+}
+
+void MuxCarrier::onDisconnected()
+{
+    if (m_lost) {
+        return;
+    }
+    m_lost = true;
+    closeAll();
+    emit lost();
+}
@@ -0,0 +1,92 @@
+/*
+ * Mux Carrier Class
+ *
+ * One carrier connection of mux mode and the streams it carries, on either
+ * side: the client opens a stream for every local SOCKS session, the server
+ * connects every opened stream to its target.
+ * Each stream may only send as much as the peer has granted it, and the
+ * peer grants more once the data has been written to the stream's socket,
+ * so a slow stream stalls itself but not the carrier. The carrier takes at
+ * most MaxPayload bytes from each ready stream in turn and stops reading
+ * streams while more than HighWater bytes wait to be written to it.
+ * The carrier socket, cipher and options belong to the caller, who applies
+ * the options to the server side's carrier socket.
+ */
+#ifndef MUXCARRIER_H
+#define MUXCARRIER_H
+#include <QObject>
+#include <QTcpSocket>
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QElapsedTimer>
+#include "connectioninfo.h"
+#include "sscipher.h"
+#include "socketoptions.h"
+
+class MuxCarrier : public QObject
+{
+    Q_OBJECT
+
+public:
+    MuxCarrier(QTcpSocket *socket, SSCipher *cipher, bool serverSide, const SocketOptions *options, WorkerCounters *counters, QObject *parent = 0);
+    ~MuxCarrier();
+
+    //client side: carries local, whose target is address in the SOCKS5 format
+    void openStream(QTcpSocket *local, const QByteArray &address);
+    //server side: frames that were decrypted along with the carrier header
+    void feed(const QByteArray &plain);
+    void closeAll();
+
+    inline int streamCount() const { return m_streams.size(); }
+    inline qint64 idleMSecs() const { return m_idle.elapsed(); }
+    qint64 load() const;//for picking the least busy carrier
+
+    static const qint64 HighWater;
+
+signals:
+    void lost();//the carrier connection is gone and its streams are closed
+
+private:
+    struct Stream
+    {
+        quint32 id;
+        QTcpSocket *socket;
+        qint64 credit;//what may still be sent to the peer
+        qint64 window;//what the peer may still send, a stream sending more is reset
+        qint64 unacked;//received and written out, not granted back yet
+        QByteArray pending;//server side, received while the target is connecting
+        bool connected;
+        bool eof;//the socket is closed, Close is sent once it is drained
+    };
+
+    QTcpSocket *m_socket;
+    SSCipher *m_cipher;
+    bool m_serverSide;
+    const SocketOptions *m_options;
+    WorkerCounters *m_counters;
+    QHash<quint32, Stream *> m_streams;
+    QList<Stream *> m_order;//round-robin order of the streams
+    int m_next;
+    quint32 m_nextId;
+    QByteArray m_control;//frames sent ahead of any data
+    QByteArray m_in;//decrypted, waiting for the rest of a frame
+    QElapsedTimer m_idle;
+    bool m_lost;
+
+    void processFrames();
+    void handleFrame(quint8 type, quint32 id, const char *payload, int length);
+    Stream *addStream(quint32 id, QTcpSocket *socket);
+    void removeStream(Stream *s, bool abort);
+    void onStreamWritten(Stream *s, qint64 bytes);
+    void onStreamConnected(Stream *s);
+    void onStreamClosed(Stream *s);
+
+private slots:
+    void onConnected();
+    void onReadyRead();
+    void pump();
+    void onDisconnected();
+};
+
+#endif // MUXCARRIER_H
@@ -0,0 +1,59 @@
+#include <QThread>
+#include <QDebug>
+#include "sscipher.h"
+#include "ssvalidator.h"
+#include "muxworker.h"
+#include "muxclient.h"
+
+MuxClient::MuxClient(QObject *parent) :
+    QObject(parent),
+    m_server(this),
+    m_thread(0),
+    m_worker(0)
+{
+    qRegisterMetaType<qintptr>("qintptr");
+    connect(&m_server, &RelayServer::newDescriptor, this, &MuxClient::dispatch);
+}
+
+MuxClient::~MuxClient()
+{
+    stop();
+}
+
+bool MuxClient::start(const QHostAddress &address, quint16 port, const SSProfile &profile)
+{
+    stop();
+    if (!SSCipher::isSupported(profile.method)) {
+        qWarning() << tr("Mux mode doesn't support method") << profile.method
+                   << (SSValidator::isAead(profile.method) ? tr("(AEAD methods need a backend)") : QString());
+        return false;
+    }
+    if (!m_server.listen(address, port)) {
+        qWarning() << tr("Mux mode cannot listen on") << address.toString() << port << m_server.errorString();
+        return false;
+    }
+
+    m_thread = new QThread(this);
+    m_worker = new MuxWorker(profile.server, profile.server_port.toUShort(), profile.method, profile.password.toUtf8(), profile.mux, profile.socket_options.checked());
+    m_worker->moveToThread(m_thread);
+    connect(m_thread, &QThread::finished, m_worker, &QObject::deleteLater);
+    m_thread->start();
+    return true;
+}
+
+void MuxClient::stop()
+{
+    m_server.close();
+    if (m_thread) {
+        m_thread->quit();
+        m_thread->wait();
+        delete m_thread;
+        m_thread = 0;
+        m_worker = 0;
+    }
+}
+
+void MuxClient::dispatch(qintptr socketDescriptor)
+{
+    QMetaObject::invokeMethod(m_worker, "addConnection", Qt::QueuedConnection, Q_ARG(qintptr, socketDescriptor));
+}
@@ -0,0 +1,40 @@
+/*
+ * Mux Client Class
+ *
+ * Mux mode in place of a backend: a SOCKS5 server on the profile's local
+ * address whose sessions travel as streams over at most mux connections to
+ * the server, so that a burst of short sessions doesn't cost a handshake
+ * and a slow start each. The server must be ss-qt5 --server.
+ * The sessions run in a MuxWorker in a thread of their own.
+ */
+#ifndef MUXCLIENT_H
+#define MUXCLIENT_H
+#include <QObject>
+#include <QHostAddress>
+#include "socksrelay.h"
+#include "ssprofile.h"
+
+class QThread;
+class MuxWorker;
+
+class MuxClient : public QObject
+{
+    Q_OBJECT
+
+public:
+    MuxClient(QObject *parent = 0);
+    ~MuxClient();
+    bool start(const QHostAddress &address, quint16 port, const SSProfile &profile);
+    void stop();
+    inline bool isListening() const { return m_server.isListening(); }
+
+private:
+    RelayServer m_server;
+    QThread *m_thread;
+    MuxWorker *m_worker;
+
+private slots:
+    void dispatch(qintptr socketDescriptor);
+};
+
+#endif // MUXCLIENT_H
@@ -0,0 +1,50 @@
+#include "muxframe.h"
+
+void MuxFrame::append(QByteArray &out, quint8 type, quint32 stream, const char *payload, int length)
+{
+    char header[HeaderSize];
+    header[0] = char(type);
+    header[1] = char(stream >> 24);
+    header[2] = char(stream >> 16);
+    header[3] = char(stream >> 8);
+    header[4] = char(stream);
+    header[5] = char(length >> 8);
+    header[6] = char(length);
+    out.append(header, HeaderSize);
+    if (length > 0) {
+        out.append(payload, length);
+    }
+}
+
+void MuxFrame::appendWindow(QByteArray &out, quint32 stream, quint32 credit)
+{
+    char payload[4];
+    payload[0] = char(credit >> 24);
+    payload[1] = char(credit >> 16);
+    payload[2] = char(credit >> 8);
+    payload[3] = char(credit);
+    append(out, Window, stream, payload, 4);
+}
+
+int MuxFrame::parse(const char *data, int len, MuxFrame *frame)
+{
+    if (len < HeaderSize) {
+        return 0;
+    }
+    const uchar *p = reinterpret_cast<const uchar *>(data);
+    if (p[0] < Open || p[0] > Reset) {
+        return -1;
+    }
+    int length = (int(p[5]) << 8) | p[6];
+    if (length > MaxPayload || (p[0] == Window && length != 4)) {
+        return -1;
+    }
+    if (len < HeaderSize + length) {
+        return 0;
+    }
+    frame->type = p[0];
+    frame->stream = (quint32(p[1]) << 24) | (quint32(p[2]) << 16) | (quint32(p[3]) << 8) | p[4];
+    frame->payload = data + HeaderSize;
+    frame->length = length;
+    return HeaderSize + length;
+}
@@ -0,0 +1,46 @@
+/*
+ * Mux Frame
+ *
+ * The framing of mux mode, where many sessions share a few long-lived
+ * shadowsocks connections to the server, the carriers. A carrier is an
+ * ordinary encrypted connection whose target address type is CarrierType
+ * followed by the Version byte, which only ss-qt5 --server understands.
+ * After that, the encrypted stream is a sequence of
+ *   type:u8 stream:u32be length:u16be payload
+ * Open carries the target in the SOCKS5 address format, Window grants the
+ * peer more bytes to send on a stream (u32be), Close ends a stream and
+ * Reset ends it because the target could not be reached.
+ */
+#ifndef MUXFRAME_H
+#define MUXFRAME_H
+#include <QByteArray>
+
+struct MuxFrame
+{
+    enum Type {
+        Open = 1,
+        Data,
+        Window,
+        Close,
+        Reset
+    };
+
+    quint8 type;
+    quint32 stream;
+    const char *payload;//points into the parsed buffer
+    int length;
+
+    static const quint8 CarrierType = 0x7f;//in place of the SOCKS5 ATYP
+    static const quint8 Version = 1;
+    static const int HeaderSize = 7;
+    static const int MaxPayload = 16 * 1024;//bounds how long one frame holds up the others
+    static const quint32 InitialWindow = 256 * 1024;//what either side may send on a new stream
+
+    static void append(QByteArray &out, quint8 type, quint32 stream, const char *payload = 0, int length = 0);
+    static void appendWindow(QByteArray &out, quint32 stream, quint32 credit);
+
+    //parses the frame at the beginning of data, returns its size, 0 if incomplete or -1 if invalid
+    static int parse(const char *data, int len, MuxFrame *frame);
+};
+
+#endif // MUXFRAME_H
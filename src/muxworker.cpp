@@ -0,0 +1,134 @@
+#include <QTimer>
+#ifdef Q_OS_WIN
+#include <winsock2.h>
+#else
+#include <unistd.h>
+#endif
+#include "socksaddress.h"
+#include "sscipher.h"
+#include "muxcarrier.h"
+#include "muxworker.h"
+
+MuxWorker::MuxWorker(const QString &server, quint16 port, const QString &method, const QByteArray &password, int carriers, const SocketOptions &options, QObject *parent) :
+    QObject(parent),
+    m_server(server),
+    m_port(port),
+    m_method(method),
+    m_password(password),
+    m_socketOptions(options),
+    m_carriers(carriers, 0)
+{}
+
+void MuxWorker::addConnection(qintptr socketDescriptor)
+{
+    QTcpSocket *local = new QTcpSocket(this);
+    if (!local->setSocketDescriptor(socketDescriptor)) {
+        delete local;//the socket never adopted the descriptor, it's still ours to close
+#ifdef Q_OS_WIN
+        closesocket(socketDescriptor);
+#else
+        ::close(socketDescriptor);
+#endif
+        return;
+    }
+    m_handshakes.insert(local, false);
+    QTimer::singleShot(HandshakeTimeoutMSecs, local, [this, local]() {
+        if (m_handshakes.remove(local) > 0) {//still talking SOCKS, the carrier owns it otherwise
+            local->abort();
+            local->deleteLater();
+        }
+    });
+    connect(local, &QTcpSocket::readyRead, this, [this, local]() { handshake(local); });
+    connect(local, &QTcpSocket::disconnected, this, [this, local]() {
+        m_handshakes.remove(local);
+        local->deleteLater();
+    });
+}
+
+void MuxWorker::handshake(QTcpSocket *local)
+{
+    QByteArray data = local->peek(512);
+    const char *p = data.constData();
+
+    if (!m_handshakes.value(local)) {
+        //greeting: VER NMETHODS METHODS, answered with "no authentication" if it's offered
+        if (data.size() < 2 || data.size() < 2 + quint8(p[1])) {
+            return;
+        }
+        if (p[0] != 5) {
+            local->abort();
+            return;
+        }
+        if (!QByteArray::fromRawData(p + 2, quint8(p[1])).contains('\0')) {
+            local->write("\x05\xff", 2);
+            local->disconnectFromHost();
+            return;
+        }
+        local->read(2 + quint8(p[1]));
+        local->write("\x05\x00", 2);
+        m_handshakes.insert(local, true);
+        data = local->peek(512);
+        p = data.constData();
+    }
+
+    //request: VER CMD RSV followed by the target address
+    if (data.size() < 4) {
+        return;
+    }
+    if (p[0] != 5) {
+        local->abort();
+        return;
+    }
+    QString host;
+    quint16 port;
+    int len = SocksAddress::parse(p + 3, data.size() - 3, &host, &port);
+    if (len == 0) {
+        return;
+    }
+    if (len < 0 || p[1] != 1) {//only CONNECT is carried
+        local->write("\x05\x07\x00\x01\x00\x00\x00\x00\x00\x00", 10);
+        local->disconnectFromHost();
+        return;
+    }
+    QByteArray address(p + 3, len);
+    local->read(3 + len);
+
+    //the target is only reached through the carrier, so success is reported right away
+    local->write("\x05\x00\x00\x01\x00\x00\x00\x00\x00\x00", 10);
+    m_handshakes.remove(local);
+    local->disconnect(this);
+    pickCarrier()->openStream(local, address);
+}
+
+MuxCarrier *MuxWorker::pickCarrier()
+{
+    MuxCarrier *best = 0;
+    for (int i = 0; i < m_carriers.size(); ++i) {
+        if (!m_carriers.at(i)) {
+            return connectCarrier(i);
+        }
+        if (!best || m_carriers.at(i)->load() < best->load()) {
+            best = m_carriers.at(i);
+        }
+    }
+    return best;
+}
+
+MuxCarrier *MuxWorker::connectCarrier(int index)
+{
+    QTcpSocket *socket = new QTcpSocket;
+    SSCipher *cipher = new SSCipher(m_method, m_password);
+    MuxCarrier *carrier = new MuxCarrier(socket, cipher, false, &m_socketOptions, 0, this);
+    socket->setParent(carrier);
+    connect(carrier, &QObject::destroyed, [cipher]() { delete cipher; });
+    connect(carrier, &MuxCarrier::lost, this, [this, index, carrier]() {
+        if (m_carriers.at(index) == carrier) {
+            m_carriers[index] = 0;
+        }
+        carrier->deleteLater();
+    });
+
+    m_carriers[index] = carrier;
+    m_socketOptions.connectToHost(socket, m_server, m_port);
+    return carrier;
+}
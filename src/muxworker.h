@@ -0,0 +1,46 @@
+/*
+ * Mux Worker Class
+ *
+ * The client side of mux mode, in MuxClient's thread: it answers the SOCKS5
+ * handshake of every local connection itself and opens a stream for it on
+ * the least busy of its carriers. Carriers are connected when first needed
+ * and again after they are lost. Local connections
+ * that don't finish the handshake in time are dropped.
+ */
+#ifndef MUXWORKER_H
+#define MUXWORKER_H
+#include <QObject>
+#include <QHash>
+#include <QVector>
+#include <QTcpSocket>
+#include "socketoptions.h"
+
+class MuxCarrier;
+
+class MuxWorker : public QObject
+{
+    Q_OBJECT
+
+public:
+    MuxWorker(const QString &server, quint16 port, const QString &method, const QByteArray &password, int carriers, const SocketOptions &options, QObject *parent = 0);
+
+public slots:
+    void addConnection(qintptr socketDescriptor);
+
+private:
+    static const int HandshakeTimeoutMSecs = 10000;
+
+    QString m_server;
+    quint16 m_port;
+    QString m_method;
+    QByteArray m_password;
+    SocketOptions m_socketOptions;
+    QVector<MuxCarrier *> m_carriers;//null until connected
+    QHash<QTcpSocket *, bool> m_handshakes;//whether the greeting has been answered
+
+    void handshake(QTcpSocket *local);
+    MuxCarrier *pickCarrier();
+    MuxCarrier *connectCarrier(int index);
+};
+
+#endif // MUXWORKER_H
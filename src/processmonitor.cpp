@@ -0,0 +1,187 @@
+#include <QDir>
+#include <QList>
+#include "processmonitor.h"
+
+#ifdef Q_OS_LINUX
+#include <unistd.h>
+#endif
+
+const int ProcessMonitor::SampleInterval = 2000;
+const int ProcessMonitor::HistoryLength = 60;
+const double ProcessMonitor::CpuThreshold = 90.0;
+const qint64 ProcessMonitor::RssThresholdKiB = 512 * 1024;
+const double ProcessMonitor::FdThresholdRatio = 0.8;
+
+ProcessMonitor::ProcessMonitor(QObject *parent) :
+    QObject(parent),
+    m_pid(0),
+    m_timer(this),
+    m_clockTicks(100),
+    m_fdLimit(0),
+    m_lastTicks(0),
+    m_lastSwitches(0),
+    m_cpuHighSamples(0),
+    m_cpuAlerted(false),
+    m_rssAlerted(false),
+    m_fdAlerted(false)
+{
+#ifdef Q_OS_LINUX
+    m_clockTicks = sysconf(_SC_CLK_TCK);
+#endif
+    m_timer.setInterval(SampleInterval);
+    connect(&m_timer, &QTimer::timeout, this, &ProcessMonitor::sample);
+}
+
+void ProcessMonitor::start(qint64 pid)
+{
+    stop();
+#ifdef Q_OS_LINUX
+    m_pid = pid;
+    QString base = QString("/proc/%1/").arg(pid);
+    m_stat.setFileName(base + "stat");
+    m_status.setFileName(base + "status");
+    m_sched.setFileName(base + "sched");
+    m_fdDir = base + "fd";
+    if (!m_stat.open(QIODevice::ReadOnly | QIODevice::Unbuffered) || !m_status.open(QIODevice::ReadOnly | QIODevice::Unbuffered)) {
+        stop();
+        return;
+    }
+    m_sched.open(QIODevice::ReadOnly | QIODevice::Unbuffered);//absent without CONFIG_SCHED_DEBUG
+
+    //the limit doesn't change during the process's life, read it once
+    m_fdLimit = 0;
+    QFile limits(base + "limits");
+    if (limits.open(QIODevice::ReadOnly)) {
+        QList<QByteArray> lines = limits.readAll().split('\n');
+        for (QList<QByteArray>::const_iterator it = lines.constBegin(); it != lines.constEnd(); ++it) {
+            if (it->startsWith("Max open files")) {
+                m_fdLimit = it->mid(26).simplified().split(' ').first().toInt();
+            }
+        }
+    }
+
+    m_history.clear();
+    m_elapsed.invalidate();
+    m_lastTicks = 0;
+    m_lastSwitches = 0;
+    m_cpuHighSamples = 0;
+    m_cpuAlerted = m_rssAlerted = m_fdAlerted = false;
+    sample();
+    m_timer.start();
+#else
+    Q_UNUSED(pid);
+#endif
+}
+
+void ProcessMonitor::stop()
+{
+    m_timer.stop();
+    m_stat.close();
+    m_status.close();
+    m_sched.close();
+    m_pid = 0;
+}
+
+QByteArray ProcessMonitor::reread(QFile &file)
+{
+    if (!file.isOpen() || !file.seek(0)) {
+        return QByteArray();
+    }
+    return file.read(8192);
+}
+
+void ProcessMonitor::sample()
+{
+    QByteArray stat = reread(m_stat);
+    if (stat.isEmpty()) {//the process is gone
+        stop();
+        return;
+    }
+
+    ProcessSample s;
+    s.cpuPercent = 0;
+    s.rssKiB = 0;
+    s.switchesPerSec = 0;
+
+    //the command name may contain spaces, the fields start after its closing parenthesis
+    QList<QByteArray> fields = stat.mid(stat.lastIndexOf(')') + 2).split(' ');
+    quint64 ticks = 0;
+    if (fields.size() > 12) {
+        ticks = fields.at(11).toULongLong() + fields.at(12).toULongLong();//utime, stime
+    }
+
+    QByteArray status = reread(m_status);
+    quint64 switches = 0;
+    int rss = status.indexOf("VmRSS:");
+    if (rss != -1) {
+        s.rssKiB = status.mid(rss + 6, status.indexOf('\n', rss) - rss - 6).simplified().split(' ').first().toLongLong();
+    }
+
+    QByteArray sched = reread(m_sched);
+    int nr = sched.indexOf("nr_switches");
+    if (nr != -1) {
+        switches = sched.mid(nr, sched.indexOf('\n', nr) - nr).split(':').last().trimmed().toULongLong();
+    }
+    else {
+        QList<QByteArray> keys;
+        keys << "voluntary_ctxt_switches:" << "nonvoluntary_ctxt_switches:";
+        for (QList<QByteArray>::const_iterator it = keys.constBegin(); it != keys.constEnd(); ++it) {
+            int i = status.indexOf("\n" + *it);
+            if (i != -1) {
+                i += it->size() + 1;
+                switches += status.mid(i, status.indexOf('\n', i) - i).trimmed().toULongLong();
+            }
+        }
+    }
+
+    s.fds = QDir(m_fdDir).entryList(QDir::AllEntries | QDir::NoDotAndDotDot | QDir::System).size();
+
+    if (m_elapsed.isValid() && m_lastTicks > 0) {
+        double secs = m_elapsed.elapsed() / 1000.0;
+        if (secs > 0) {
+            s.cpuPercent = 100.0 * (ticks - m_lastTicks) / m_clockTicks / secs;
+            s.switchesPerSec = (switches - m_lastSwitches) / secs;
+        }
+    }
+    m_elapsed.start();
+    m_lastTicks = ticks;
+    m_lastSwitches = switches;
+
+    m_history.append(s);
+    if (m_history.size() > HistoryLength) {
+        m_history.remove(0);
+    }
+    checkThresholds(s);
+    emit sampled(s);
+}
+
+void ProcessMonitor::checkThresholds(const ProcessSample &s)
+{
+    //each alert fires once when crossed and re-arms after recovery
+    m_cpuHighSamples = s.cpuPercent >= CpuThreshold ? m_cpuHighSamples + 1 : 0;
+    if (m_cpuHighSamples >= 5 && !m_cpuAlerted) {
+        m_cpuAlerted = true;
+        emit thresholdCrossed(tr("Backend has been using %1% CPU for %2 seconds").arg(int(s.cpuPercent)).arg(5 * SampleInterval / 1000));
+    }
+    else if (m_cpuHighSamples == 0) {
+        m_cpuAlerted = false;
+    }
+
+    if (s.rssKiB >= RssThresholdKiB && !m_rssAlerted) {
+        m_rssAlerted = true;
+        emit thresholdCrossed(tr("Backend is using %1 MiB of memory").arg(s.rssKiB / 1024));
+    }
+    else if (s.rssKiB < RssThresholdKiB * 9 / 10) {
+        m_rssAlerted = false;
+    }
+
+    if (m_fdLimit > 0) {
+        if (s.fds >= m_fdLimit * FdThresholdRatio && !m_fdAlerted) {
+            m_fdAlerted = true;
+            emit thresholdCrossed(tr("Backend has %1 of %2 file descriptors open").arg(s.fds).arg(m_fdLimit));
+        }
+        else if (s.fds < m_fdLimit * FdThresholdRatio * 0.9) {
+            m_fdAlerted = false;
+        }
+    }
+}
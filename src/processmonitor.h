@@ -0,0 +1,70 @@
+/*
+ * Process Monitor Class
+ *
+ * Samples the backend's CPU usage, resident memory, open file descriptors
+ * and context switches from /proc at a fixed low rate.
+ * The /proc files are kept open and re-read from the start on every sample.
+ */
+#ifndef PROCESSMONITOR_H
+#define PROCESSMONITOR_H
+#include <QObject>
+#include <QFile>
+#include <QTimer>
+#include <QVector>
+#include <QElapsedTimer>
+
+struct ProcessSample
+{
+    double cpuPercent;
+    qint64 rssKiB;
+    int fds;
+    double switchesPerSec;
+};
+
+class ProcessMonitor : public QObject
+{
+    Q_OBJECT
+
+public:
+    ProcessMonitor(QObject *parent = 0);
+    void start(qint64 pid);
+    void stop();
+    inline bool isActive() const { return m_timer.isActive(); }
+    inline const QVector<ProcessSample> &history() const { return m_history; }
+
+    static const int SampleInterval;
+    static const int HistoryLength;
+    static const double CpuThreshold;
+    static const qint64 RssThresholdKiB;
+    static const double FdThresholdRatio;
+
+signals:
+    void sampled(const ProcessSample &sample);
+    void thresholdCrossed(const QString &message);
+
+private:
+    qint64 m_pid;
+    QTimer m_timer;
+    QFile m_stat;
+    QFile m_status;
+    QFile m_sched;
+    QString m_fdDir;
+    long m_clockTicks;
+    int m_fdLimit;
+    quint64 m_lastTicks;
+    quint64 m_lastSwitches;
+    QElapsedTimer m_elapsed;
+    QVector<ProcessSample> m_history;
+    int m_cpuHighSamples;
+    bool m_cpuAlerted;
+    bool m_rssAlerted;
+    bool m_fdAlerted;
+
+    QByteArray reread(QFile &file);
+    void checkThresholds(const ProcessSample &sample);
+
+private slots:
+    void sample();
+};
+
+#endif // PROCESSMONITOR_H
@@ -0,0 +1,121 @@
+#include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QSaveFile>
+#include <QDataStream>
+#include <QJsonDocument>
+#include <QJsonArray>
+#include <QCryptographicHash>
+#include <QDebug>
+#include "configuration.h"
+#include "profilecache.h"
+
+const quint32 ProfileCache::Magic = 0x53535143;//"SSQC"
+const quint32 ProfileCache::Version = 6;
+
+/*
+ * Within this distance of the cache being written, an edit of the JSON file
+ * may not have moved its modification time, so the contents are compared.
+ */
+static const qint64 MTimeSlackMSecs = 2000;
+
+QString ProfileCache::pathFor(const QString &jsonFile)
+{
+    return jsonFile + QString(".cache");
+}
+
+bool ProfileCache::write(const QString &jsonFile, const QJsonObject &root, const QByteArray &json)
+{
+    QFileInfo info(jsonFile);
+    if (!info.exists()) {
+        return false;
+    }
+
+    QByteArray bodies;
+    QDataStream bodyStream(&bodies, QIODevice::WriteOnly);
+    bodyStream.setVersion(QDataStream::Qt_5_0);
+
+    QByteArray data;
+    QDataStream s(&data, QIODevice::WriteOnly);
+    s.setVersion(QDataStream::Qt_5_0);
+    s << Magic << Version << qint64(info.size()) << qint64(info.lastModified().toMSecsSinceEpoch());
+    s << QCryptographicHash::hash(json, QCryptographicHash::Md5);
+
+    QJsonObject settings = root;
+    settings.remove("configs");
+    s << QJsonDocument(settings).toJson(QJsonDocument::Compact);
+
+    QJsonArray configs = root["configs"].toArray();
+    s << quint32(configs.size());
+    for (QJsonArray::const_iterator it = configs.constBegin(); it != configs.constEnd(); ++it) {
+        SSProfile p = Configuration::profileFromJson((*it).toObject());
+        s << p.profileName << p.server << p.server_port << p.tag << quint32(bodyStream.device()->pos());
+        bodyStream << p.backend << p.custom_arg << p.limits << p.local_addr << p.local_port << p.method << p.mux << p.password << p.plugin << p.plugin_opts << p.plugin_trusted << p.socket_options << p.timeout << p.type << p.fast_open;
+    }
+    s << bodies;
+
+    QSaveFile out(pathFor(jsonFile));
+    if (!out.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    out.write(data);
+    return out.commit();
+}
+
+bool ProfileCache::load(const QString &jsonFile, Snapshot *snapshot)
+{
+    QFile file(pathFor(jsonFile));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    QByteArray data = file.readAll();
+    QDataStream s(data);
+    s.setVersion(QDataStream::Qt_5_0);
+
+    quint32 magic, version;
+    qint64 size, mtime;
+    QByteArray hash;
+    s >> magic >> version;
+    if (s.status() != QDataStream::Ok || magic != Magic || version != Version) {
+        return false;
+    }
+    s >> size >> mtime >> hash;
+
+    QFileInfo info(jsonFile);
+    if (size != info.size() || mtime != info.lastModified().toMSecsSinceEpoch()) {
+        return false;
+    }
+    if (qAbs(QFileInfo(file).lastModified().toMSecsSinceEpoch() - mtime) < MTimeSlackMSecs) {
+        QFile json(jsonFile);
+        if (!json.open(QIODevice::ReadOnly | QIODevice::Text) || QCryptographicHash::hash(json.readAll(), QCryptographicHash::Md5) != hash) {
+            return false;
+        }
+    }
+
+    QByteArray settings;
+    quint32 count;
+    s >> settings >> count;
+    snapshot->settings = QJsonDocument::fromJson(settings).object();
+    snapshot->heads.resize(count);
+    snapshot->offsets.resize(count);
+    for (quint32 i = 0; i < count && s.status() == QDataStream::Ok; ++i) {
+        SSProfile &p = snapshot->heads[i];
+        s >> p.profileName >> p.server >> p.server_port >> p.tag >> snapshot->offsets[i];
+    }
+    s >> snapshot->bodies;
+    snapshot->hash = hash;
+
+    if (s.status() != QDataStream::Ok) {
+        qWarning() << "Warning: ignoring corrupt profile cache" << file.fileName();
+        return false;
+    }
+    return true;
+}
+
+void ProfileCache::decodeBody(const QByteArray &bodies, quint32 offset, SSProfile *p)
+{
+    QDataStream s(bodies);
+    s.setVersion(QDataStream::Qt_5_0);
+    s.skipRawData(offset);
+    s >> p->backend >> p->custom_arg >> p->limits >> p->local_addr >> p->local_port >> p->method >> p->mux >> p->password >> p->plugin >> p->plugin_opts >> p->plugin_trusted >> p->socket_options >> p->timeout >> p->type >> p->fast_open;
+}
@@ -0,0 +1,41 @@
+/*
+ * Profile Cache Class
+ *
+ * A binary snapshot of gui-config.json, kept next to it, that can be
+ * loaded without parsing any JSON.
+ * The names, servers and tags every view needs are decoded at once; the
+ * rest of each profile stays encoded until the profile is first used.
+ * gui-config.json remains the only source of truth: the snapshot records
+ * the size, modification time and MD5 of the file it was made from and is
+ * ignored as soon as they no longer match.
+ */
+#ifndef PROFILECACHE_H
+#define PROFILECACHE_H
+#include <QString>
+#include <QByteArray>
+#include <QVector>
+#include <QJsonObject>
+#include "ssprofile.h"
+
+class ProfileCache
+{
+public:
+    struct Snapshot
+    {
+        QJsonObject settings;//gui-config.json without "configs"
+        QVector<SSProfile> heads;//profileName, server, server_port and tag only
+        QVector<quint32> offsets;//of each profile's remaining fields in bodies
+        QByteArray bodies;
+        QByteArray hash;//MD5 of the JSON file
+    };
+
+    static QString pathFor(const QString &jsonFile);
+    static bool write(const QString &jsonFile, const QJsonObject &root, const QByteArray &json);
+    static bool load(const QString &jsonFile, Snapshot *snapshot);
+    static void decodeBody(const QByteArray &bodies, quint32 offset, SSProfile *p);
+
+    static const quint32 Magic;
+    static const quint32 Version;//bump whenever the layout changes
+};
+
+#endif // PROFILECACHE_H
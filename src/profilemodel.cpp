@@ -0,0 +1,145 @@
+#include "profilemodel.h"
+
+static QVariant profileData(const ProfileStore *store, ProfileId id, int role)
+{
+    const SSProfile *p = store->header(id);//a view must not decode every profile it shows
+    if (!p) {
+        return QVariant();
+    }
+
+    switch (role) {
+    case Qt::DisplayRole:
+    case Qt::EditRole:
+        return p->profileName;
+    case Qt::ToolTipRole:
+        if (p->tag.isEmpty()) {
+            return QString("%1:%2").arg(p->server).arg(p->server_port);
+        }
+        return QString("%1:%2 [%3]").arg(p->server).arg(p->server_port).arg(p->tag);
+    case ProfileModel::IdRole:
+        return id;
+    default:
+        return QVariant();
+    }
+}
+
+ProfileModel::ProfileModel(ProfileStore *store, QObject *parent) :
+    QAbstractListModel(parent),
+    m_store(store)
+{
+    connect(m_store, &ProfileStore::aboutToInsert, this, &ProfileModel::onAboutToInsert);
+    connect(m_store, &ProfileStore::inserted, this, &ProfileModel::onInserted);
+    connect(m_store, &ProfileStore::aboutToRemove, this, &ProfileModel::onAboutToRemove);
+    connect(m_store, &ProfileStore::removed, this, &ProfileModel::onRemoved);
+    connect(m_store, &ProfileStore::aboutToReset, this, &ProfileModel::onAboutToReset);
+    connect(m_store, &ProfileStore::wasReset, this, &ProfileModel::onWasReset);
+    connect(m_store, &ProfileStore::changed, this, &ProfileModel::onChanged);
+}
+
+int ProfileModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_store->count();
+}
+
+QVariant ProfileModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid()) {
+        return QVariant();
+    }
+    return profileData(m_store, m_store->idAt(index.row()), role);
+}
+
+void ProfileModel::onAboutToInsert(int row)
+{
+    beginInsertRows(QModelIndex(), row, row);
+}
+
+void ProfileModel::onInserted()
+{
+    endInsertRows();
+}
+
+void ProfileModel::onAboutToRemove(int row)
+{
+    beginRemoveRows(QModelIndex(), row, row);
+}
+
+void ProfileModel::onRemoved()
+{
+    endRemoveRows();
+}
+
+void ProfileModel::onAboutToReset()
+{
+    beginResetModel();
+}
+
+void ProfileModel::onWasReset()
+{
+    endResetModel();
+}
+
+void ProfileModel::onChanged(int row)
+{
+    QModelIndex i = index(row);
+    emit dataChanged(i, i);
+}
+
+ProfileSearchModel::ProfileSearchModel(const ProfileStore *store, QObject *parent) :
+    QAbstractListModel(parent),
+    m_store(store),
+    m_complete(false)
+{
+    //only new or edited profiles can add matches, deleted ones are dropped from the results
+    connect(m_store, &ProfileStore::aboutToRemove, this, &ProfileSearchModel::onAboutToRemove);
+    connect(m_store, &ProfileStore::inserted, this, &ProfileSearchModel::invalidate);
+    connect(m_store, &ProfileStore::changed, this, &ProfileSearchModel::invalidate);
+    connect(m_store, &ProfileStore::wasReset, this, &ProfileSearchModel::invalidate);
+}
+
+int ProfileSearchModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_results.size();
+}
+
+QVariant ProfileSearchModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= m_results.size()) {
+        return QVariant();
+    }
+    return profileData(m_store, m_results[index.row()], role);
+}
+
+void ProfileSearchModel::setQuery(const QString &text)
+{
+    beginResetModel();
+    if (m_complete && !m_query.isEmpty() && text.startsWith(m_query, Qt::CaseInsensitive)) {
+        m_results = m_store->search(text, MaxResults + 1, &m_results);
+    }
+    else {
+        m_results = m_store->search(text, MaxResults + 1);
+    }
+    //one extra match tells whether the list was cut short
+    m_complete = m_results.size() <= MaxResults;
+    if (!m_complete) {
+        m_results.resize(MaxResults);
+    }
+    m_query = text;
+    endResetModel();
+}
+
+void ProfileSearchModel::invalidate()
+{
+    m_complete = false;
+}
+
+void ProfileSearchModel::onAboutToRemove(int row)
+{
+    int i = m_results.indexOf(m_store->idAt(row));
+    if (i < 0) {
+        return;
+    }
+    beginRemoveRows(QModelIndex(), i, i);
+    m_results.remove(i);
+    endRemoveRows();
+}
@@ -0,0 +1,68 @@
+/*
+ * Profile Model Class
+ *
+ * Presents a ProfileStore to item views. Nothing is copied out of the
+ * store, every cell is produced on demand.
+ */
+#ifndef PROFILEMODEL_H
+#define PROFILEMODEL_H
+#include <QAbstractListModel>
+#include "profilestore.h"
+
+class ProfileModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+public:
+    enum Roles {
+        IdRole = Qt::UserRole
+    };
+
+    explicit ProfileModel(ProfileStore *store, QObject *parent = 0);
+    int rowCount(const QModelIndex &parent = QModelIndex()) const;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const;
+
+private:
+    ProfileStore *m_store;
+
+private slots:
+    void onAboutToInsert(int row);
+    void onInserted();
+    void onAboutToRemove(int row);
+    void onRemoved();
+    void onAboutToReset();
+    void onWasReset();
+    void onChanged(int row);
+};
+
+/*
+ * The profiles matching what has been typed into the picker so far.
+ * Typing more characters only filters the previous matches, instead of
+ * scanning the whole store again.
+ */
+class ProfileSearchModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+public:
+    explicit ProfileSearchModel(const ProfileStore *store, QObject *parent = 0);
+    int rowCount(const QModelIndex &parent = QModelIndex()) const;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const;
+
+    static const int MaxResults = 200;
+
+public slots:
+    void setQuery(const QString &text);
+    void invalidate();//the store changed, the next query starts over
+
+private:
+    const ProfileStore *m_store;
+    QString m_query;
+    QVector<ProfileId> m_results;
+    bool m_complete;//m_results holds every match of m_query, not just the first MaxResults
+
+private slots:
+    void onAboutToRemove(int row);
+};
+
+#endif // PROFILEMODEL_H
@@ -0,0 +1,232 @@
+#include "profilestore.h"
+#include "profilecache.h"
+
+ProfileStore::ProfileStore(QObject *parent) :
+    QObject(parent),
+    m_nextId(1),
+    m_rowsDirty(false)
+{}
+
+ProfileStore::~ProfileStore()
+{
+    qDeleteAll(m_entries);
+}
+
+QString ProfileStore::serverKey(const QString &server, const QString &port)
+{
+    return server.toLower() + QChar(':') + port;
+}
+
+ProfileStore::Entry *ProfileStore::entry(ProfileId id) const
+{
+    return m_entries.value(id, 0);
+}
+
+ProfileStore::Entry *ProfileStore::decoded(ProfileId id) const
+{
+    Entry *e = entry(id);
+    if (e && e->bodyOffset >= 0) {
+        ProfileCache::decodeBody(m_bodies, quint32(e->bodyOffset), &e->profile);
+        e->bodyOffset = -1;
+    }
+    return e;
+}
+
+void ProfileStore::index(ProfileId id, Entry *e)
+{
+    e->nameKey = e->profile.profileName.toLower();
+    e->serverKey = serverKey(e->profile.server, e->profile.server_port);
+    e->tagKey = e->profile.tag.toLower();
+    e->searchText = e->nameKey + QChar('\n') + e->profile.server.toLower() + QChar('\n') + e->tagKey;
+
+    m_byName.insert(e->nameKey, id);
+    m_byServer.insert(e->serverKey, id);
+    if (!e->tagKey.isEmpty()) {
+        m_byTag.insert(e->tagKey, id);
+    }
+}
+
+void ProfileStore::unindex(ProfileId id, Entry *e)
+{
+    m_byName.remove(e->nameKey, id);
+    m_byServer.remove(e->serverKey, id);
+    m_byTag.remove(e->tagKey, id);
+}
+
+ProfileId ProfileStore::append(const SSProfile &p)
+{
+    Entry *e = new Entry;
+    e->profile = p;
+    e->bodyOffset = -1;
+    ProfileId id = m_nextId++;
+    m_entries.insert(id, e);
+    index(id, e);
+
+    int row = m_order.size();
+    emit aboutToInsert(row);
+    m_order.append(id);
+    if (!m_rowsDirty) {
+        m_rows.insert(id, row);
+    }
+    emit inserted();
+    return id;
+}
+
+void ProfileStore::remove(ProfileId id)
+{
+    Entry *e = entry(id);
+    if (!e) {
+        return;
+    }
+
+    int row = rowOf(id);
+    emit aboutToRemove(row);
+    m_order.remove(row);
+    unindex(id, e);
+    m_entries.remove(id);
+    delete e;
+    m_rows.clear();
+    m_rowsDirty = true;
+    emit removed();
+}
+
+void ProfileStore::drop()
+{
+    qDeleteAll(m_entries);
+    m_entries.clear();
+    m_order.clear();
+    m_byName.clear();
+    m_byServer.clear();
+    m_byTag.clear();
+    m_rows.clear();
+    m_rowsDirty = false;
+    m_bodies.clear();
+}
+
+void ProfileStore::clear()
+{
+    emit aboutToReset();
+    drop();
+    emit wasReset();
+}
+
+void ProfileStore::replaceAll(const QVector<SSProfile> &list)
+{
+    emit aboutToReset();
+    drop();
+    m_order.reserve(list.size());
+    m_rows.reserve(list.size());
+    for (QVector<SSProfile>::const_iterator it = list.constBegin(); it != list.constEnd(); ++it) {
+        Entry *e = new Entry;
+        e->profile = *it;
+        e->bodyOffset = -1;
+        ProfileId id = m_nextId++;
+        m_entries.insert(id, e);
+        index(id, e);
+        m_rows.insert(id, m_order.size());
+        m_order.append(id);
+    }
+    emit wasReset();
+}
+
+void ProfileStore::replaceAll(const QVector<SSProfile> &heads, const QByteArray &bodies, const QVector<quint32> &offsets)
+{
+    emit aboutToReset();
+    drop();
+    m_bodies = bodies;
+    m_order.reserve(heads.size());
+    m_rows.reserve(heads.size());
+    for (int i = 0; i < heads.size(); ++i) {
+        Entry *e = new Entry;
+        e->profile = heads[i];
+        e->bodyOffset = offsets[i];
+        ProfileId id = m_nextId++;
+        m_entries.insert(id, e);
+        index(id, e);
+        m_rows.insert(id, m_order.size());
+        m_order.append(id);
+    }
+    emit wasReset();
+}
+
+void ProfileStore::update(ProfileId id)
+{
+    Entry *e = entry(id);
+    if (!e) {
+        return;
+    }
+    unindex(id, e);
+    index(id, e);
+    emit changed(rowOf(id));
+}
+
+int ProfileStore::rowOf(ProfileId id) const
+{
+    if (m_rowsDirty) {
+        m_rows.clear();
+        m_rows.reserve(m_order.size());
+        for (int row = 0; row < m_order.size(); ++row) {
+            m_rows.insert(m_order[row], row);
+        }
+        m_rowsDirty = false;
+    }
+    return m_rows.value(id, -1);
+}
+
+SSProfile *ProfileStore::profile(ProfileId id)
+{
+    Entry *e = decoded(id);
+    return e ? &e->profile : 0;
+}
+
+const SSProfile *ProfileStore::profile(ProfileId id) const
+{
+    Entry *e = decoded(id);
+    return e ? &e->profile : 0;
+}
+
+const SSProfile *ProfileStore::header(ProfileId id) const
+{
+    Entry *e = entry(id);
+    return e ? &e->profile : 0;
+}
+
+QVector<ProfileId> ProfileStore::findByName(const QString &name) const
+{
+    return m_byName.values(name.toLower()).toVector();
+}
+
+QVector<ProfileId> ProfileStore::findByServer(const QString &server, const QString &port) const
+{
+    return m_byServer.values(serverKey(server, port)).toVector();
+}
+
+QVector<ProfileId> ProfileStore::findByTag(const QString &tag) const
+{
+    return m_byTag.values(tag.toLower()).toVector();
+}
+
+QStringList ProfileStore::tags() const
+{
+    QStringList t;
+    QList<QString> keys = m_byTag.uniqueKeys();
+    for (QList<QString>::const_iterator it = keys.constBegin(); it != keys.constEnd(); ++it) {
+        t << header(m_byTag.value(*it))->tag;//spelled as in the first profile carrying it
+    }
+    return t;
+}
+
+QVector<ProfileId> ProfileStore::search(const QString &text, int limit, const QVector<ProfileId> *within) const
+{
+    const QVector<ProfileId> &candidates = within ? *within : m_order;
+    QVector<ProfileId> result;
+    QString needle = text.toLower();
+
+    for (QVector<ProfileId>::const_iterator it = candidates.constBegin(); it != candidates.constEnd() && result.size() < limit; ++it) {
+        Entry *e = entry(*it);
+        if (e && (needle.isEmpty() || e->searchText.contains(needle))) {
+            result.append(*it);
+        }
+    }
+    return result;
+}
@@ -0,0 +1,93 @@
+/*
+ * Profile Store Class
+ *
+ * Owns every profile under an ID that stays the same for the whole session,
+ * no matter how many profiles are added or deleted before it.
+ * Profiles are kept in display order and indexed by name, by server and
+ * by tag. Views follow the store through its signals.
+ */
+#ifndef PROFILESTORE_H
+#define PROFILESTORE_H
+#include <QObject>
+#include <QVector>
+#include <QHash>
+#include <QStringList>
+#include "ssprofile.h"
+
+typedef quint32 ProfileId;//0 is never a valid ID
+
+class ProfileStore : public QObject
+{
+    Q_OBJECT
+
+public:
+    ProfileStore(QObject *parent = 0);
+    ~ProfileStore();
+
+    ProfileId append(const SSProfile &p);
+    void remove(ProfileId id);
+    void clear();
+    void replaceAll(const QVector<SSProfile> &list);//one reset instead of a signal per profile
+    //heads carry the indexed fields only, the rest is decoded from bodies on first use
+    void replaceAll(const QVector<SSProfile> &heads, const QByteArray &bodies, const QVector<quint32> &offsets);
+    void update(ProfileId id);//call after editing a profile in place
+
+    inline int count() const { return m_order.size(); }
+    inline ProfileId idAt(int row) const { return row >= 0 && row < m_order.size() ? m_order[row] : 0; }
+    int rowOf(ProfileId id) const;
+    SSProfile *profile(ProfileId id);
+    const SSProfile *profile(ProfileId id) const;
+    const SSProfile *header(ProfileId id) const;//only name, server, port and tag are guaranteed
+
+    QVector<ProfileId> findByName(const QString &name) const;
+    QVector<ProfileId> findByServer(const QString &server, const QString &port) const;
+    QVector<ProfileId> findByTag(const QString &tag) const;
+    QStringList tags() const;
+
+    /*
+     * Returns at most limit profiles, in display order, whose name, server
+     * or tag contains text (case-insensitive).
+     * If within is given, only those profiles are considered, which is how
+     * the picker narrows its previous result while the user keeps typing.
+     */
+    QVector<ProfileId> search(const QString &text, int limit, const QVector<ProfileId> *within = 0) const;
+
+signals:
+    void aboutToInsert(int row);
+    void inserted();
+    void aboutToRemove(int row);
+    void removed();
+    void aboutToReset();
+    void wasReset();
+    void changed(int row);
+
+private:
+    struct Entry
+    {
+        SSProfile profile;
+        QString nameKey;
+        QString serverKey;
+        QString tagKey;
+        QString searchText;
+        qint64 bodyOffset;//into m_bodies, -1 once the whole profile is decoded
+    };
+
+    QHash<ProfileId, Entry *> m_entries;
+    ProfileId m_nextId;//IDs are never reused, not even after clear()
+    QVector<ProfileId> m_order;
+    QMultiHash<QString, ProfileId> m_byName;
+    QMultiHash<QString, ProfileId> m_byServer;
+    QMultiHash<QString, ProfileId> m_byTag;
+    mutable QHash<ProfileId, int> m_rows;
+    mutable bool m_rowsDirty;
+    QByteArray m_bodies;
+
+    Entry *entry(ProfileId id) const;
+    Entry *decoded(ProfileId id) const;
+    void index(ProfileId id, Entry *e);
+    void unindex(ProfileId id, Entry *e);
+    void drop();
+    static QString serverKey(const QString &server, const QString &port);
+};
+
+#endif // PROFILESTORE_H
@@ -0,0 +1,66 @@
+#-------------------------------------------------
+#
+#  The proxy engine: launching backends, the relay,
+#  the built-in server, mux mode and the ciphers.
+#  Shared by core.pri and the benchmark tools
+#
+#-------------------------------------------------
+
+INCLUDEPATH  += $$PWD
+
+SOURCES      += $$PWD/ss_process.cpp \
+                $$PWD/ssvalidator.cpp \
+                $$PWD/ssprofile.cpp \
+                $$PWD/ssuri.cpp \
+                $$PWD/socksaddress.cpp \
+                $$PWD/relaysession.cpp \
+                $$PWD/relayworker.cpp \
+                $$PWD/socksrelay.cpp \
+                $$PWD/latencyhistogram.cpp \
+                $$PWD/connectprobe.cpp \
+                $$PWD/tracer.cpp \
+                $$PWD/backendregistry.cpp \
+                $$PWD/sscipher.cpp \
+                $$PWD/serversession.cpp \
+                $$PWD/serverworker.cpp \
+                $$PWD/ssserver.cpp \
+                $$PWD/traffictrace.cpp \
+                $$PWD/muxframe.cpp \
+                $$PWD/muxcarrier.cpp \
+                $$PWD/muxworker.cpp \
+                $$PWD/muxclient.cpp \
+                $$PWD/socketoptions.cpp \
+                $$PWD/trafficlimits.cpp \
+                $$PWD/relayshaper.cpp
+
+HEADERS      += $$PWD/ss_process.h \
+                $$PWD/ssprofile.h \
+                $$PWD/ssuri.h \
+                $$PWD/ssvalidator.h \
+                $$PWD/connectioninfo.h \
+                $$PWD/socksaddress.h \
+                $$PWD/relaysession.h \
+                $$PWD/relayworker.h \
+                $$PWD/socksrelay.h \
+                $$PWD/latencyhistogram.h \
+                $$PWD/connectprobe.h \
+                $$PWD/tracer.h \
+                $$PWD/backendregistry.h \
+                $$PWD/sscipher.h \
+                $$PWD/serversession.h \
+                $$PWD/serverworker.h \
+                $$PWD/ssserver.h \
+                $$PWD/traffictrace.h \
+                $$PWD/muxframe.h \
+                $$PWD/muxcarrier.h \
+                $$PWD/muxworker.h \
+                $$PWD/muxclient.h \
+                $$PWD/socketoptions.h \
+                $$PWD/trafficlimits.h \
+                $$PWD/relayshaper.h
+
+win32: LIBS += -lcrypto -lws2_32
+unix: {
+    CONFIG    += link_pkgconfig
+    PKGCONFIG += libcrypto
+}
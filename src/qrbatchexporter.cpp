@@ -0,0 +1,232 @@
+#include <QtConcurrent>
+#include <QBuffer>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QPainter>
+#include <QFontMetrics>
+#include <QDebug>
+#include "qrbatchexporter.h"
+
+namespace {
+
+struct RenderJob
+{
+    typedef QRBatchExporter::Item result_type;
+
+    bool png;
+
+    QRBatchExporter::Item operator()(const QRBatchExporter::Item &in) const
+    {
+        QRBatchExporter::Item out = in;
+        out.matrix = QRMatrix::encode(in.uri);
+        if (png && !out.matrix.isNull()) {
+            QBuffer buf(&out.png);
+            buf.open(QIODevice::WriteOnly);
+            out.matrix.toImage(QRBatchExporter::FileModuleSize, QRMatrix::QuietZone).save(&buf, "PNG");
+        }
+        return out;
+    }
+};
+
+struct FileJob
+{
+    typedef QString result_type;
+
+    QDir dir;
+
+    QString operator()(const QRBatchExporter::Item &item) const
+    {
+        //keep the name readable, but drop what is not allowed in file names somewhere
+        QString name = item.name;
+        for (QString::iterator c = name.begin(); c != name.end(); ++c) {
+            if (c->unicode() < 0x20 || QString("/\\:*?\"<>|").contains(*c)) {
+                *c = QChar('_');
+            }
+        }
+        QFile file(dir.filePath(QString("%1-%2.png").arg(item.index + 1, 4, 10, QChar('0')).arg(name)));
+        if (!file.open(QIODevice::WriteOnly) || file.write(item.png) != item.png.size()) {
+            return file.fileName() + ": " + file.errorString();
+        }
+        return QString();
+    }
+};
+
+struct SheetJob
+{
+    typedef QString result_type;
+
+    const QVector<QRBatchExporter::Item> *items;
+    QString path;
+    int pages;
+
+    QString operator()(int page) const
+    {
+        const int cell = QRBatchExporter::SheetCellSize;
+        const int perPage = QRBatchExporter::SheetColumns * QRBatchExporter::SheetRows;
+        const int first = page * perPage;
+        const int count = qMin(perPage, items->size() - first);
+        const int rows = (count + QRBatchExporter::SheetColumns - 1) / QRBatchExporter::SheetColumns;
+
+        QFont font;
+        font.setPixelSize(12);
+        QFontMetrics fm(font);
+        const int caption = fm.height() + 4;
+
+        QImage img(QRBatchExporter::SheetColumns * cell, rows * (cell + caption), QImage::Format_RGB32);
+        img.fill(Qt::white);
+        QPainter painter(&img);
+        painter.setFont(font);
+        for (int i = 0; i < count; ++i) {
+            const QRBatchExporter::Item &item = items->at(first + i);
+            const int x = (i % QRBatchExporter::SheetColumns) * cell;
+            const int y = (i / QRBatchExporter::SheetColumns) * (cell + caption);
+            if (!item.matrix.isNull()) {
+                //the largest integer module size that fits, with the quiet zone
+                const int modules = item.matrix.size() + 2 * QRMatrix::QuietZone;
+                QImage code = item.matrix.toImage(qMax(1, cell / modules), QRMatrix::QuietZone);
+                painter.drawImage(x + (cell - code.width()) / 2, y + (cell - code.height()) / 2, code);
+            }
+            painter.drawText(QRect(x, y + cell, cell, caption), Qt::AlignCenter, fm.elidedText(item.name, Qt::ElideRight, cell - 8));
+        }
+        painter.end();
+
+        QString file = QRBatchExporter::pagePath(path, page, pages);
+        if (!img.save(file, "PNG")) {
+            return file + ": " + QObject::tr("Failed to save the image.");
+        }
+        return QString();
+    }
+};
+
+}
+
+QRBatchExporter::QRBatchExporter(QObject *parent) :
+    QObject(parent)
+{
+    connect(&m_render, &QFutureWatcher<Item>::progressValueChanged, this, [this](int value) {
+        emit progress(value, m_items.size());
+    });
+    connect(&m_render, &QFutureWatcher<Item>::finished, this, &QRBatchExporter::onRendered);
+    connect(&m_write, &QFutureWatcher<QString>::finished, this, &QRBatchExporter::onWritten);
+}
+
+QRBatchExporter::~QRBatchExporter()
+{
+    cancel();
+    m_render.waitForFinished();
+    m_write.waitForFinished();
+}
+
+void QRBatchExporter::start(const QVector<Item> &items, Format format, const QString &path)
+{
+    if (isRunning()) {
+        return;
+    }
+    m_items = items;
+    m_format = format;
+    m_path = path;
+
+    RenderJob job;
+    job.png = format != Sheet;//sheets draw straight from the matrix
+    m_render.setFuture(QtConcurrent::mapped(m_items, job));
+}
+
+void QRBatchExporter::cancel()
+{
+    m_render.cancel();
+    m_write.cancel();
+}
+
+QString QRBatchExporter::pagePath(const QString &path, int page, int pages)
+{
+    if (pages <= 1) {
+        return path;
+    }
+    QFileInfo info(path);
+    QString suffix = info.suffix().isEmpty() ? QString("png") : info.suffix();
+    return info.dir().filePath(QString("%1-%2.%3").arg(info.completeBaseName()).arg(page + 1).arg(suffix));
+}
+
+QString QRBatchExporter::writeHtml(const QVector<Item> &items, const QString &path)
+{
+    QByteArray html;
+    html.reserve(items.size() * 4096);
+    html += "<!DOCTYPE html>\n<html>\n<head>\n<meta charset=\"utf-8\">\n<title>Shadowsocks Profiles</title>\n";
+    html += "<style>figure{display:inline-block;margin:8px;text-align:center;width:200px}"
+            "img{width:200px;image-rendering:pixelated}figcaption{word-break:break-all;font:12px sans-serif}</style>\n";
+    html += "</head>\n<body>\n";
+    for (QVector<Item>::const_iterator it = items.constBegin(); it != items.constEnd(); ++it) {
+        html += "<figure><img alt=\"\" src=\"data:image/png;base64," + it->png.toBase64() + "\"><figcaption><b>"
+                + it->name.toHtmlEscaped().toUtf8() + "</b><br><a href=\"" + it->uri + "\">" + it->uri + "</a></figcaption></figure>\n";
+    }
+    html += "</body>\n</html>\n";
+
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly) || file.write(html) != html.size()) {
+        return path + ": " + file.errorString();
+    }
+    return QString();
+}
+
+void QRBatchExporter::onRendered()
+{
+    if (m_render.isCanceled()) {
+        m_items.clear();
+        emit finished(false, tr("Export cancelled."));
+        return;
+    }
+    m_items = m_render.future().results().toVector();
+
+    switch (m_format) {
+    case Sheet: {
+        const int perPage = SheetColumns * SheetRows;
+        const int pages = (m_items.size() + perPage - 1) / perPage;
+        QList<int> pageList;
+        for (int i = 0; i < pages; ++i) {
+            pageList << i;
+        }
+        SheetJob job;
+        job.items = &m_items;//not touched again until m_write is done
+        job.path = m_path;
+        job.pages = pages;
+        m_write.setFuture(QtConcurrent::mapped(pageList, job));
+        break;
+    }
+    case Files: {
+        FileJob job;
+        job.dir = QDir(m_path);
+        m_write.setFuture(QtConcurrent::mapped(m_items, job));
+        break;
+    }
+    case Html:
+        m_write.setFuture(QtConcurrent::run(&QRBatchExporter::writeHtml, m_items, m_path));
+        break;
+    }
+}
+
+void QRBatchExporter::onWritten()
+{
+    if (m_write.isCanceled()) {
+        m_items.clear();
+        emit finished(false, tr("Export cancelled."));
+        return;
+    }
+
+    QStringList errors;
+    QList<QString> results = m_write.future().results();
+    for (QList<QString>::const_iterator it = results.constBegin(); it != results.constEnd(); ++it) {
+        if (!it->isEmpty()) {
+            errors << *it;
+        }
+    }
+    int total = m_items.size();
+    m_items.clear();
+
+    if (!errors.isEmpty()) {
+        qWarning() << "QR export failed:" << errors;
+        emit finished(false, errors.first());
+    } else {
+        emit finished(true, tr("Exported %n profile(s).", "", total));
+    }
+}
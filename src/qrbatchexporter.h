@@ -0,0 +1,68 @@
+/*
+ * QR Batch Exporter Class
+ *
+ * Exports the share link and QR code of many profiles at once.
+ * Encoding and PNG compression run on the thread pool, first one job per
+ * profile, then one job per output file, so a thousand profiles take well
+ * under a second on a multi-core machine.
+ */
+#ifndef QRBATCHEXPORTER_H
+#define QRBATCHEXPORTER_H
+#include <QObject>
+#include <QFutureWatcher>
+#include <QVector>
+#include "qrmatrix.h"
+
+class QRBatchExporter : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Format {
+        Sheet,//printable PNG pages of SheetColumns x SheetRows codes
+        Files,//one PNG per profile in a directory
+        Html//a single page with the images inlined
+    };
+
+    struct Item
+    {
+        int index;
+        QString name;
+        QByteArray uri;
+        QRMatrix matrix;
+        QByteArray png;//only for Files and Html
+    };
+
+    QRBatchExporter(QObject *parent = 0);
+    ~QRBatchExporter();
+
+    //items only need index, name and uri filled in
+    void start(const QVector<Item> &items, Format format, const QString &path);
+    void cancel();
+    inline bool isRunning() const { return m_render.isRunning() || m_write.isRunning(); }
+    static QString pagePath(const QString &path, int page, int pages);//sheets past the first get a number
+
+    static const int SheetColumns = 10;
+    static const int SheetRows = 10;
+    static const int SheetCellSize = 160;
+    static const int FileModuleSize = 8;
+
+signals:
+    void progress(int done, int total);
+    void finished(bool ok, const QString &message);
+
+private:
+    Format m_format;
+    QString m_path;
+    QVector<Item> m_items;
+    QFutureWatcher<Item> m_render;
+    QFutureWatcher<QString> m_write;//each job returns an error, or an empty string
+
+    static QString writeHtml(const QVector<Item> &items, const QString &path);
+
+private slots:
+    void onRendered();
+    void onWritten();
+};
+
+#endif // QRBATCHEXPORTER_H
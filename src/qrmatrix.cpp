@@ -0,0 +1,93 @@
+#include <cstring>
+#include <QDebug>
+#include <qrencode.h>
+#include "qrmatrix.h"
+
+QRMatrix::QRMatrix() :
+    m_size(0)
+{}
+
+QRMatrix QRMatrix::encode(const QByteArray &data)
+{
+    QRMatrix m;
+    QRcode *qrcode = QRcode_encodeString(data.constData(), 1, QR_ECLEVEL_L, QR_MODE_8, 1);
+    if (qrcode == NULL) {
+        qWarning() << "Generating QR code failed.";
+        return m;
+    }
+
+    m.m_size = qrcode->width;
+    m.m_modules.resize(m.m_size * m.m_size);
+    char *out = m.m_modules.data();
+    for (int i = 0; i < m.m_modules.size(); ++i) {
+        out[i] = qrcode->data[i] & 0x01;
+    }
+    QRcode_free(qrcode);
+    return m;
+}
+
+QImage QRMatrix::toImage(int moduleSize, int margin) const
+{
+    if (isNull() || moduleSize < 1) {
+        return QImage();
+    }
+
+    const int side = (m_size + 2 * margin) * moduleSize;
+    QImage img(side, side, QImage::Format_RGB32);
+    img.fill(Qt::white);
+
+    const QRgb dark = qRgb(0, 0, 0);
+    const int offset = margin * moduleSize;
+    for (int y = 0; y < m_size; ++y) {
+        //draw the first pixel row of this module row, then copy it down
+        const int top = offset + y * moduleSize;
+        QRgb *line = reinterpret_cast<QRgb *>(img.scanLine(top));
+        const char *row = m_modules.constData() + y * m_size;
+        for (int x = 0; x < m_size; ++x) {
+            if (row[x]) {
+                QRgb *px = line + offset + x * moduleSize;
+                for (int i = 0; i < moduleSize; ++i) {
+                    px[i] = dark;
+                }
+            }
+        }
+        for (int i = 1; i < moduleSize; ++i) {
+            memcpy(img.scanLine(top + i), line, img.bytesPerLine());
+        }
+    }
+    return img;
+}
+
+QByteArray QRMatrix::toSvg(int margin) const
+{
+    if (isNull()) {
+        return QByteArray();
+    }
+
+    const int side = m_size + 2 * margin;
+    QByteArray svg;
+    svg.reserve(m_size * m_size * 4 + 256);
+    svg += "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
+    svg += "<svg xmlns=\"http://www.w3.org/2000/svg\" viewBox=\"0 0 " + QByteArray::number(side) + ' ' + QByteArray::number(side)
+            + "\" shape-rendering=\"crispEdges\">\n";
+    svg += "<rect width=\"100%\" height=\"100%\" fill=\"#fff\"/>\n<path fill=\"#000\" d=\"";
+    //one subpath per horizontal run of dark modules
+    for (int y = 0; y < m_size; ++y) {
+        const char *row = m_modules.constData() + y * m_size;
+        for (int x = 0; x < m_size; ) {
+            if (!row[x]) {
+                ++x;
+                continue;
+            }
+            int run = 1;
+            while (x + run < m_size && row[x + run]) {
+                ++run;
+            }
+            svg += 'M' + QByteArray::number(x + margin) + ',' + QByteArray::number(y + margin)
+                    + 'h' + QByteArray::number(run) + "v1h-" + QByteArray::number(run) + 'z';
+            x += run;
+        }
+    }
+    svg += "\"/>\n</svg>\n";
+    return svg;
+}
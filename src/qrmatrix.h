@@ -0,0 +1,36 @@
+/*
+ * QR Matrix Class
+ *
+ * The modules of an encoded QR code, kept apart from any widget so that
+ * the same code can be painted, exported or rendered on another thread.
+ */
+#ifndef QRMATRIX_H
+#define QRMATRIX_H
+#include <QByteArray>
+#include <QImage>
+
+class QRMatrix
+{
+public:
+    QRMatrix();
+    static QRMatrix encode(const QByteArray &data);
+
+    inline bool isNull() const { return m_size == 0; }
+    inline int size() const { return m_size; }
+    inline bool isDark(int x, int y) const { return m_modules.at(y * m_size + x); }
+
+    /*
+     * Renders each module as a moduleSize x moduleSize square, surrounded
+     * by margin modules of quiet zone. Safe to call from any thread.
+     */
+    QImage toImage(int moduleSize, int margin = 0) const;
+    QByteArray toSvg(int margin = 4) const;
+
+    static const int QuietZone = 4;
+
+private:
+    int m_size;
+    QByteArray m_modules;//one byte per module, row by row, 1 is dark
+};
+
+#endif // QRMATRIX_H
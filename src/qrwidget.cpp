@@ -1,50 +1,60 @@
 #include <QPainter>
+#include <QFile>
 #include <QDebug>
-#include <qrencode.h>
 #include "qrwidget.h"
 
 QRWidget::QRWidget(QWidget *parent) :
     QWidget(parent)
 {
-    data = "http://www.shadowsocks.org";
+    setQRData("http://www.shadowsocks.org");
 }
 
 void QRWidget::setQRData(const QByteArray &qrData)
 {
     data = qrData;
+    m_matrix = QRMatrix::encode(data);
+    m_image = QImage();
+    update();
+}
+
+bool QRWidget::exportTo(const QString &fileName) const
+{
+    if (m_matrix.isNull()) {
+        return false;
+    }
+    if (fileName.endsWith(".svg", Qt::CaseInsensitive)) {
+        QFile file(fileName);
+        if (!file.open(QIODevice::WriteOnly)) {
+            qWarning() << "Cannot write" << fileName << file.errorString();
+            return false;
+        }
+        return file.write(m_matrix.toSvg()) != -1;
+    }
+    //an integer module size keeps the edges sharp, 8 pixels scans fine when printed
+    return m_matrix.toImage(8, QRMatrix::QuietZone).save(fileName, "PNG");
+}
+
+void QRWidget::resizeEvent(QResizeEvent *)
+{
+    m_image = QImage();
 }
 
 void QRWidget::paintEvent(QPaintEvent *)
 {
     QPainter painter(this);
-    QRcode *qrcode = QRcode_encodeString(data.constData(), 1, QR_ECLEVEL_L, QR_MODE_8, 1);
-    if (qrcode != NULL) {
-        QColor fg(Qt::black);
-        QColor bg(Qt::white);
-        painter.setBrush(bg);
-        painter.setPen(Qt::NoPen);
-        const double w = width();
-        const double h = height();
-        painter.drawRect(0, 0, w, h);
-        painter.setBrush(fg);
-        const int s = qrcode->width > 0 ? qrcode->width : 1;
-        const double aspect = w / h;
-        const double scale = ((aspect > 1.0) ? h : w) / s;
-        for(int y = 0; y < s; y++){
-            const int yy = y * s;
-            for(int x = 0; x < s; x++){
-                const int xx = yy + x;
-                const unsigned char b = qrcode->data[xx];
-                if(b &0x01){
-                    const double rx1 = x * scale, ry1 = y * scale;
-                    QRectF r(rx1, ry1, scale, scale);
-                    painter.drawRects(&r,1);
-                }
-            }
-        }
-        QRcode_free(qrcode);
+    painter.fillRect(rect(), Qt::white);
+    if (m_matrix.isNull()) {
+        return;
     }
-    else {
-        qWarning() << tr("Generating QR code failed.");
+
+    if (m_image.isNull()) {
+        const int side = qMin(width(), height());
+        const int moduleSize = side / m_matrix.size();
+        if (moduleSize >= 1) {
+            m_image = m_matrix.toImage(moduleSize);
+        } else {//smaller than one pixel per module, it won't scan anyway
+            m_image = m_matrix.toImage(1).scaled(side, side);
+        }
     }
+    painter.drawImage((width() - m_image.width()) / 2, (height() - m_image.height()) / 2, m_image);
 }
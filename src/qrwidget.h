@@ -3,6 +3,8 @@
 
 #include <QWidget>
 #include <QPaintEvent>
+#include <QImage>
+#include "qrmatrix.h"
 
 class QRWidget : public QWidget
 {
@@ -10,12 +12,17 @@ class QRWidget : public QWidget
 public:
     explicit QRWidget(QWidget *parent = 0);
     void setQRData(const QByteArray &qrData);
+    inline const QRMatrix &matrix() const { return m_matrix; }
+    bool exportTo(const QString &fileName) const;//SVG or PNG, chosen by the suffix
 
 private:
     QByteArray data;
+    QRMatrix m_matrix;
+    QImage m_image;//rendered for the current widget size
 
 protected:
     void paintEvent(QPaintEvent *);
+    void resizeEvent(QResizeEvent *);
 };
 
 #endif // QRWIDGET_H
@@ -0,0 +1,323 @@
+#include <QDateTime>
+#include <QHostAddress>
+#include "socksaddress.h"
+#include "tracer.h"
+#include "relaysession.h"
+
+const qint64 RelaySession::HighWater = 256 * 1024;
+
+RelaySession::RelaySession(quint64 id, WorkerCounters *counters, LatencySet *latency, TraceBuffer *trace, RelayShaper *shaper, QObject *parent) :
+    QObject(parent),
+    m_id(id),
+    m_counters(counters),
+    m_latency(latency),
+    m_trace(trace),
+    m_shaper(shaper),
+    m_shapeClient(0),
+    m_client(this),
+    m_upstream(this),
+    m_upState(Greeting),
+    m_downState(Greeting),
+    m_bytesUp(0),
+    m_bytesDown(0),
+    m_startMSecs(QDateTime::currentMSecsSinceEpoch()),
+    m_finished(false)
+{
+    for (int i = 0; i < 4; ++i) {
+        m_traceMarks[i] = -1;
+    }
+    m_throttled[RelayShaper::Up] = m_throttled[RelayShaper::Down] = false;
+    m_lifeTimer.start();
+    m_client.setReadBufferSize(HighWater);
+    m_upstream.setReadBufferSize(HighWater);
+
+    connect(&m_client, &QTcpSocket::readyRead, this, &RelaySession::pumpUp);
+    connect(&m_upstream, &QTcpSocket::connected, this, &RelaySession::pumpUp);
+    connect(&m_upstream, &QTcpSocket::bytesWritten, this, &RelaySession::pumpUp);
+    connect(&m_upstream, &QTcpSocket::readyRead, this, &RelaySession::pumpDown);
+    connect(&m_client, &QTcpSocket::bytesWritten, this, &RelaySession::pumpDown);
+
+    connect(&m_client, &QTcpSocket::disconnected, this, &RelaySession::onDisconnected);
+    connect(&m_upstream, &QTcpSocket::disconnected, this, &RelaySession::onDisconnected);
+    connect(&m_client, static_cast<void (QAbstractSocket::*)(QAbstractSocket::SocketError)>(&QAbstractSocket::error), this, &RelaySession::onDisconnected);
+    connect(&m_upstream, static_cast<void (QAbstractSocket::*)(QAbstractSocket::SocketError)>(&QAbstractSocket::error), this, &RelaySession::onDisconnected);
+}
+
+RelaySession::~RelaySession()
+{
+    if (!m_finished) {
+        m_counters->active.fetch_sub(1, std::memory_order_relaxed);
+    }
+    if (m_shapeClient) {
+        m_shaper->detach(m_shapeClient);
+    }
+}
+
+bool RelaySession::start(qintptr socketDescriptor, quint16 upstreamPort)
+{
+    if (!m_client.setSocketDescriptor(socketDescriptor)) {
+        m_finished = true;//never counted, nothing for the destructor to take back
+        return false;
+    }
+    m_counters->sessions.fetch_add(1, std::memory_order_relaxed);
+    m_counters->active.fetch_add(1, std::memory_order_relaxed);
+    traceMark(0);
+    m_trace->record(TrafficTrace::Open, m_id);
+    m_clientAddr = SocksAddress::toString(m_client.peerAddress().toString(), m_client.peerPort());
+    if (m_shaper) {
+        m_shapeClient = m_shaper->attach(m_client.peerAddress());
+    }
+    m_upstream.connectToHost(QHostAddress::LocalHost, upstreamPort);
+    return true;
+}
+
+ConnectionInfo RelaySession::info() const
+{
+    ConnectionInfo i;
+    i.id = m_id;
+    i.client = m_clientAddr;
+    i.destination = m_destination;
+    i.bytesUp = m_bytesUp;
+    i.bytesDown = m_bytesDown;
+    i.rateUp = 0;
+    i.rateDown = 0;
+    i.startMSecs = m_startMSecs;
+    return i;
+}
+
+void RelaySession::pumpUp()
+{
+    if (m_upstream.state() != QAbstractSocket::ConnectedState) {
+        return;
+    }
+
+    bool drain = m_client.state() != QAbstractSocket::ConnectedState;
+    bool shaped = m_throttled[RelayShaper::Up];
+    m_throttled[RelayShaper::Up] = false;
+    while (m_client.bytesAvailable() > 0 && (drain || m_upstream.bytesToWrite() < HighWater)) {
+        qint64 chunk = shape(RelayShaper::Up, m_upState == Stream, qMin(m_client.bytesAvailable(), qint64(64 * 1024)), drain, shaped);
+        if (chunk == 0) {
+            break;
+        }
+        QByteArray data = m_client.read(chunk);
+        if (m_upState != Stream) {
+            sniffUp(data);
+        }
+        else {
+            m_trace->record(TrafficTrace::Up, m_id, data.size());
+        }
+        m_upstream.write(data);
+        m_bytesUp += data.size();
+        m_counters->bytesUp.fetch_add(data.size(), std::memory_order_relaxed);
+    }
+}
+
+void RelaySession::pumpDown()
+{
+    if (m_client.state() != QAbstractSocket::ConnectedState) {
+        return;
+    }
+
+    bool drain = m_upstream.state() != QAbstractSocket::ConnectedState;
+    bool shaped = m_throttled[RelayShaper::Down];
+    m_throttled[RelayShaper::Down] = false;
+    while (m_upstream.bytesAvailable() > 0 && (drain || m_client.bytesToWrite() < HighWater)) {
+        qint64 chunk = shape(RelayShaper::Down, m_downState == Stream, qMin(m_upstream.bytesAvailable(), qint64(64 * 1024)), drain, shaped);
+        if (chunk == 0) {
+            break;
+        }
+        QByteArray data = m_upstream.read(chunk);
+        if (m_downState != Stream) {
+            sniffDown(data);
+        }
+        else {
+            m_trace->record(TrafficTrace::Down, m_id, data.size());
+            if (m_requestTimer.isValid()) {
+                m_latency->ttfb.record(m_requestTimer.nsecsElapsed() / 1000);
+                m_requestTimer.invalidate();
+            }
+        }
+        m_client.write(data);
+        m_bytesDown += data.size();
+        m_counters->bytesDown.fetch_add(data.size(), std::memory_order_relaxed);
+    }
+}
+
+qint64 RelaySession::shape(RelayShaper::Direction d, bool streaming, qint64 wanted, bool drain, bool shaped)
+{
+    //the SOCKS handshake is never held back, nor what is left of a closing session
+    if (!m_shaper || !streaming) {
+        return wanted;
+    }
+    qint64 n = m_shaper->grant(d, m_shapeClient, wanted, drain);
+    if (n == 0) {
+        m_throttled[d] = true;
+    }
+    else if (shaped) {
+        m_counters->shaped.fetch_add(n, std::memory_order_relaxed);
+    }
+    return n;
+}
+
+qint64 RelaySession::waiting(RelayShaper::Direction d) const
+{
+    if (!m_throttled[d]) {
+        return 0;
+    }
+    return d == RelayShaper::Up ? m_client.bytesAvailable() : m_upstream.bytesAvailable();
+}
+
+void RelaySession::resume()
+{
+    if (m_throttled[RelayShaper::Up]) {
+        pumpUp();
+    }
+    if (m_throttled[RelayShaper::Down]) {
+        pumpDown();
+    }
+}
+
+void RelaySession::sniffUp(const QByteArray &data)
+{
+    m_upSniff.append(data);
+    const uchar *p = reinterpret_cast<const uchar *>(m_upSniff.constData());
+    int len = m_upSniff.size();
+
+    if (m_upState == Greeting) {
+        if (len < 2) {
+            return;
+        }
+        if (p[0] != 5) {//not SOCKS5, nothing to learn
+            m_upState = Stream;
+            m_upSniff.clear();
+            return;
+        }
+        int greeting = 2 + p[1];
+        if (len < greeting) {
+            return;
+        }
+        m_upSniff.remove(0, greeting);
+        m_upState = Request;
+        p = reinterpret_cast<const uchar *>(m_upSniff.constData());
+        len = m_upSniff.size();
+    }
+
+    //VER CMD RSV ATYP ADDR PORT
+    if (len < 4) {
+        return;
+    }
+    QString host;
+    quint16 port;
+    int addrLen = SocksAddress::parse(m_upSniff.constData() + 3, len - 3, &host, &port);
+    if (addrLen == 0) {
+        return;
+    }
+    if (addrLen > 0) {
+        m_destination = SocksAddress::toString(host, port);
+        m_requestTimer.start();
+        traceMark(1);
+    }
+    m_upState = Stream;
+    m_upSniff.clear();
+}
+
+void RelaySession::sniffDown(const QByteArray &data)
+{
+    m_downSniff.append(data);
+    int len = m_downSniff.size();
+
+    if (m_downState == Greeting) {
+        if (len < 2) {
+            return;
+        }
+        m_downSniff.remove(0, 2);
+        m_downState = Request;
+        len = m_downSniff.size();
+    }
+
+    //VER REP RSV ATYP BND.ADDR BND.PORT
+    if (len < 4) {
+        return;
+    }
+    int addrLen = SocksAddress::parse(m_downSniff.constData() + 3, len - 3, 0, 0);
+    if (addrLen == 0) {
+        return;
+    }
+    m_downState = Stream;
+    traceMark(2);
+    m_trace->record(TrafficTrace::Connected, m_id);
+    if (len > 3 + addrLen && addrLen > 0) {
+        m_trace->record(TrafficTrace::Down, m_id, len - 3 - addrLen);
+    }
+
+    //the reply may arrive together with the first bytes of the response
+    if (addrLen > 0 && len > 3 + addrLen && m_requestTimer.isValid()) {
+        m_latency->ttfb.record(m_requestTimer.nsecsElapsed() / 1000);
+        m_requestTimer.invalidate();
+    }
+    m_downSniff.clear();
+}
+
+void RelaySession::onDisconnected()
+{
+    pumpUp();
+    pumpDown();
+
+    if (m_client.state() == QAbstractSocket::UnconnectedState || m_upstream.state() == QAbstractSocket::UnconnectedState) {
+        if (m_traceMarks[3] < 0) {
+            traceMark(3);
+        }
+        //disconnectFromHost waits until pending data has been written
+        m_client.disconnectFromHost();
+        m_upstream.disconnectFromHost();
+    }
+
+    if (!m_finished && m_client.state() == QAbstractSocket::UnconnectedState && m_upstream.state() == QAbstractSocket::UnconnectedState) {
+        m_finished = true;
+        m_counters->active.fetch_sub(1, std::memory_order_relaxed);
+        m_latency->duration.record(m_lifeTimer.nsecsElapsed() / 1000);
+        traceFinish();
+        m_trace->record(TrafficTrace::Close, m_id);
+        if (m_shapeClient) {//a finished session may outlive the worker's shaper
+            m_shaper->detach(m_shapeClient);
+            m_shapeClient = 0;
+        }
+        emit finished(m_id);
+    }
+}
+
+void RelaySession::traceMark(int phase)
+{
+    if (Q_UNLIKELY(Tracer::isEnabled())) {
+        m_traceMarks[phase] = Tracer::now();
+    }
+}
+
+void RelaySession::traceFinish()
+{
+    if (Q_LIKELY(!Tracer::isEnabled()) || m_traceMarks[0] < 0) {
+        return;
+    }
+
+    /*
+     * A phase that was never reached (not SOCKS5, connection refused...)
+     * is folded into the next one, so the spans always cover the session.
+     */
+    static const char *const names[] = { "socks handshake", "socks connect", "relay", "close" };
+    qint64 end = Tracer::now();
+    qint64 begin = m_traceMarks[0];
+    for (int phase = 0; phase < 4; ++phase) {
+        qint64 next = end;
+        for (int k = phase + 1; k < 4; ++k) {
+            if (m_traceMarks[k] >= 0) {
+                next = m_traceMarks[k];
+                break;
+            }
+        }
+        if (phase > 0 && m_traceMarks[phase] < 0) {
+            continue;
+        }
+        Tracer::complete(names[phase], "session", begin, next - begin, m_id);
+        begin = next;
+    }
+}
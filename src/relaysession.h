@@ -0,0 +1,84 @@
+/*
+ * Relay Session Class
+ *
+ * One SOCKS5 session forwarded from a local client to the backend.
+ * The handshake is sniffed on the way through to learn the destination,
+ * everything else is copied verbatim, within the tokens of the shaper if
+ * the profile has rate limits.
+ */
+#ifndef RELAYSESSION_H
+#define RELAYSESSION_H
+#include <QObject>
+#include <QTcpSocket>
+#include <QByteArray>
+#include <QElapsedTimer>
+#include "connectioninfo.h"
+#include "latencyhistogram.h"
+#include "traffictrace.h"
+#include "relayshaper.h"
+
+class RelaySession : public QObject
+{
+    Q_OBJECT
+
+public:
+    RelaySession(quint64 id, WorkerCounters *counters, LatencySet *latency, TraceBuffer *trace, RelayShaper *shaper, QObject *parent = 0);
+    ~RelaySession();
+    bool start(qintptr socketDescriptor, quint16 upstreamPort);//on failure the descriptor is left to the caller
+    ConnectionInfo info() const;
+    inline quint64 id() const { return m_id; }
+    inline quint64 bytesUp() const { return m_bytesUp; }
+    inline quint64 bytesDown() const { return m_bytesDown; }
+    //bytes held back for want of tokens, to be moved by resume() after a refill
+    qint64 waiting(RelayShaper::Direction d) const;
+    void resume();
+
+    static const qint64 HighWater;
+
+signals:
+    void finished(quint64 id);
+
+private:
+    enum SniffState {
+        Greeting,
+        Request,
+        Stream
+    };
+
+    quint64 m_id;
+    WorkerCounters *m_counters;
+    LatencySet *m_latency;
+    TraceBuffer *m_trace;
+    RelayShaper *m_shaper;//null without rate limits
+    RelayShaper::Client *m_shapeClient;
+    bool m_throttled[2];
+    QTcpSocket m_client;
+    QTcpSocket m_upstream;
+    SniffState m_upState;
+    SniffState m_downState;
+    QByteArray m_upSniff;
+    QByteArray m_downSniff;
+    QString m_clientAddr;
+    QString m_destination;
+    quint64 m_bytesUp;
+    quint64 m_bytesDown;
+    qint64 m_startMSecs;
+    QElapsedTimer m_lifeTimer;
+    QElapsedTimer m_requestTimer;//from the SOCKS request to the first byte of the response
+    bool m_finished;
+    qint64 m_traceMarks[4];//accepted, request sent, reply received, close started; -1 if not reached
+
+    void traceMark(int phase);
+    void traceFinish();
+
+    qint64 shape(RelayShaper::Direction d, bool streaming, qint64 wanted, bool drain, bool shaped);
+    void sniffUp(const QByteArray &data);
+    void sniffDown(const QByteArray &data);
+
+private slots:
+    void pumpUp();
+    void pumpDown();
+    void onDisconnected();
+};
+
+#endif // RELAYSESSION_H
@@ -0,0 +1,150 @@
+#include "relayshaper.h"
+
+ProfileBucket::ProfileBucket() :
+    m_rate(0),
+    m_lastUs(0)
+{
+    m_tokens[0] = m_tokens[1] = 0;
+}
+
+void ProfileBucket::reset(qint64 rate, int workers)
+{
+    QMutexLocker lock(&m_lock);
+    m_rate = rate;
+    m_quota[0] = m_quota[1] = QVector<qint64>(qMax(1, workers), 0);
+    m_hungry[0] = m_hungry[1] = QVector<bool>(qMax(1, workers), false);
+    m_tokens[0] = m_tokens[1] = 0;
+    m_clock.start();
+    m_lastUs = 0;
+}
+
+void ProfileBucket::accrue()
+{
+    qint64 now = m_clock.nsecsElapsed() / 1000;
+    qint64 gained = (now - m_lastUs) * m_rate / 1000000;
+    if (gained > 0) {
+        qint64 cap = qMax(qint64(1), m_rate * RelayShaper::BurstMSecs / 1000);
+        m_tokens[0] = qMin(m_tokens[0] + gained, cap);
+        m_tokens[1] = qMin(m_tokens[1] + gained, cap);
+        m_lastUs = now;
+    }
+}
+
+qint64 ProfileBucket::take(int direction, int worker, qint64 wanted)
+{
+    QMutexLocker lock(&m_lock);
+    return takeQuota(direction, worker, wanted);
+}
+
+qint64 ProfileBucket::tickTake(int direction, int worker, qint64 wanted)
+{
+    QMutexLocker lock(&m_lock);
+    if (worker < 0 || worker >= m_quota[direction].size()) {
+        return 0;
+    }
+    //the workers tick at about the same time, an even split keeps the first one from taking it all
+    m_hungry[direction][worker] = wanted > 0;
+    int hungry = m_hungry[direction].count(true);
+    m_quota[direction][worker] = wanted > 0 ? qMax(qint64(1), m_rate * RelayShaper::TickInterval / 1000 / hungry) : 0;
+    return takeQuota(direction, worker, wanted);
+}
+
+qint64 ProfileBucket::takeQuota(int direction, int worker, qint64 wanted)
+{
+    if (worker < 0 || worker >= m_quota[direction].size()) {
+        return 0;
+    }
+    accrue();
+    qint64 &quota = m_quota[direction][worker];
+    qint64 n = qBound(qint64(0), qMin(wanted, quota), m_tokens[direction]);
+    m_tokens[direction] -= n;
+    quota -= n;
+    return n;
+}
+
+RelayShaper::RelayShaper(const TrafficLimits &limits, ProfileBucket *profile, int worker) :
+    m_limits(limits),
+    m_profile(profile),
+    m_worker(worker)
+{
+    m_tokens[Up] = m_tokens[Down] = 0;
+    m_topped[Up] = m_topped[Down] = false;
+    m_clock.start();
+}
+
+RelayShaper::~RelayShaper()
+{
+    qDeleteAll(m_clients);
+}
+
+RelayShaper::Client *RelayShaper::attach(const QHostAddress &address)
+{
+    Client *&c = m_clients[address];
+    if (!c) {
+        c = new Client;
+        c->address = address;
+        c->tokens[Up] = c->tokens[Down] = burst(m_limits.clientRate);//a new client starts with a full bucket
+        c->sessions = 0;
+    }
+    ++c->sessions;
+    return c;
+}
+
+void RelayShaper::detach(Client *client)
+{
+    if (--client->sessions == 0) {
+        m_clients.remove(client->address);
+        delete client;
+    }
+}
+
+qint64 RelayShaper::grant(Direction d, Client *client, qint64 wanted, bool force)
+{
+    qint64 n = wanted;
+    if (!force) {
+        if (m_limits.rate > 0) {
+            if (m_tokens[d] < wanted && !m_topped[d]) {
+                //ran dry between two ticks, one more take until the next
+                m_topped[d] = true;
+                m_tokens[d] += m_profile->take(d, m_worker, wanted - m_tokens[d]);
+            }
+            n = qMin(n, m_tokens[d]);
+        }
+        if (m_limits.clientRate > 0) {
+            n = qMin(n, client->tokens[d]);
+        }
+        n = qMax(qint64(0), n);
+    }
+
+    if (m_limits.rate > 0) {
+        m_tokens[d] -= n;
+    }
+    if (m_limits.clientRate > 0) {
+        client->tokens[d] -= n;
+    }
+    return n;
+}
+
+void RelayShaper::refill(qint64 demandUp, qint64 demandDown)
+{
+    qint64 elapsedUs = m_clock.nsecsElapsed() / 1000;
+    m_clock.restart();
+
+    if (m_limits.clientRate > 0) {
+        qint64 gained = elapsedUs * m_limits.clientRate / 1000000;
+        qint64 cap = burst(m_limits.clientRate);
+        for (QHash<QHostAddress, Client *>::iterator it = m_clients.begin(); it != m_clients.end(); ++it) {
+            (*it)->tokens[Up] = qMin((*it)->tokens[Up] + gained, cap);
+            (*it)->tokens[Down] = qMin((*it)->tokens[Down] + gained, cap);
+        }
+    }
+
+    if (m_limits.rate > 0) {
+        //only what is waiting, so that idle workers leave their share to the busy ones
+        const qint64 demand[2] = { demandUp, demandDown };
+        for (int d = Up; d <= Down; ++d) {
+            m_tokens[d] += m_profile->tickTake(d, m_worker, qMin(demand[d], burst(m_limits.rate)) - m_tokens[d]);
+            m_topped[d] = false;
+        }
+    }
+}
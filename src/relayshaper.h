@@ -0,0 +1,89 @@
+/*
+ * Relay Shaper Class
+ *
+ * Token buckets for TrafficLimits, two levels deep: a ProfileBucket shared
+ * by all relay workers and, in each worker, a bucket per client address.
+ * SocksRelay hands every client address to the same worker, so the client
+ * buckets need no locking, and a worker only takes from the ProfileBucket
+ * once per tick, or once more when it runs dry in between. A tick's worth
+ * is split among the workers that have bytes waiting, so a single busy
+ * worker gets the whole rate.
+ * Buckets hold up to BurstMSecs worth of their rate.
+ */
+#ifndef RELAYSHAPER_H
+#define RELAYSHAPER_H
+#include <QHash>
+#include <QVector>
+#include <QMutex>
+#include <QElapsedTimer>
+#include <QHostAddress>
+#include "trafficlimits.h"
+
+class ProfileBucket
+{
+public:
+    ProfileBucket();
+    void reset(qint64 rate, int workers);
+    //thread-safe; a tick grants the worker its quota, an even split of a tick's worth
+    //among the workers that want some, and take() draws on what is left of it
+    qint64 tickTake(int direction, int worker, qint64 wanted);
+    qint64 take(int direction, int worker, qint64 wanted);
+
+private:
+    QMutex m_lock;
+    qint64 m_rate;
+    QVector<qint64> m_quota[2];//per worker, what it may still take until its next tick
+    QVector<bool> m_hungry[2];//per worker, whether it wanted tokens on its last tick
+    qint64 m_tokens[2];
+    qint64 m_lastUs;
+    QElapsedTimer m_clock;
+
+    void accrue();
+    qint64 takeQuota(int direction, int worker, qint64 wanted);
+};
+
+class RelayShaper
+{
+public:
+    enum Direction {
+        Up,
+        Down
+    };
+
+    struct Client
+    {
+        QHostAddress address;
+        qint64 tokens[2];
+        int sessions;
+    };
+
+    RelayShaper(const TrafficLimits &limits, ProfileBucket *profile, int worker);
+    ~RelayShaper();
+    inline bool isShaping() const { return m_limits.isShaping(); }
+
+    Client *attach(const QHostAddress &address);
+    void detach(Client *client);
+
+    //how much of wanted may go now; forced grants are always whole and paid back later
+    qint64 grant(Direction d, Client *client, qint64 wanted, bool force = false);
+    //adds what has accrued since the last tick, demand being the bytes waiting for tokens
+    void refill(qint64 demandUp, qint64 demandDown);
+
+    static const int TickInterval = 50;
+    static const int BurstMSecs = 200;
+
+private:
+    Q_DISABLE_COPY(RelayShaper)
+
+    TrafficLimits m_limits;
+    ProfileBucket *m_profile;
+    int m_worker;
+    qint64 m_tokens[2];//taken from m_profile, not spent yet
+    bool m_topped[2];//whether the extra take of this tick is used up
+    QHash<QHostAddress, Client *> m_clients;
+    QElapsedTimer m_clock;
+
+    static inline qint64 burst(qint64 rate) { return qMax(qint64(1), rate * BurstMSecs / 1000); }
+};
+
+#endif // RELAYSHAPER_H
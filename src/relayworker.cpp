@@ -0,0 +1,142 @@
+#include <QtGlobal>
+#ifdef Q_OS_WIN
+#include <winsock2.h>
+#else
+#include <unistd.h>
+#endif
+#include "relaysession.h"
+#include "relayworker.h"
+
+const int RelayWorker::SnapshotInterval = 1000;
+
+RelayWorker::RelayWorker(int index, quint16 upstreamPort, LatencySet *sink, const TrafficLimits &limits, ProfileBucket *bucket, QObject *parent) :
+    QObject(parent),
+    m_sink(sink),
+    m_trace(index),
+    m_shaper(limits, bucket, index),
+    m_index(index),
+    m_upstreamPort(upstreamPort),
+    m_nextId(0),
+    m_shapeRound(0),
+    m_snapshotTimer(this),
+    m_shapeTimer(this)
+{
+    m_snapshotTimer.setInterval(SnapshotInterval);
+    connect(&m_snapshotTimer, &QTimer::timeout, this, &RelayWorker::publish);
+    m_shapeTimer.setInterval(RelayShaper::TickInterval);
+    connect(&m_shapeTimer, &QTimer::timeout, this, &RelayWorker::shape);
+}
+
+RelayWorker::~RelayWorker()
+{
+    //sessions touch m_counters when destroyed, so don't leave them to ~QObject
+    for (QHash<quint64, Tracked>::iterator it = m_sessions.begin(); it != m_sessions.end(); ++it) {
+        delete it->session;
+    }
+    if (m_sink) {
+        m_sink->merge(m_latency);
+    }
+}
+
+void RelayWorker::addConnection(qintptr socketDescriptor)
+{
+    if (!m_snapshotTimer.isActive()) {
+        m_snapshotTimer.start();//started lazily so the timer belongs to this thread
+        if (m_shaper.isShaping()) {
+            m_shapeTimer.start();
+        }
+    }
+
+    quint64 id = (quint64(m_index) << 48) | m_nextId++;
+    RelaySession *session = new RelaySession(id, &m_counters, &m_latency, &m_trace, m_shaper.isShaping() ? &m_shaper : 0, this);
+    connect(session, &RelaySession::finished, this, &RelayWorker::onSessionFinished);
+    if (!session->start(socketDescriptor, m_upstreamPort)) {
+        delete session;//the socket never adopted the descriptor, it's still ours to close
+#ifdef Q_OS_WIN
+        closesocket(socketDescriptor);
+#else
+        ::close(socketDescriptor);
+#endif
+        return;
+    }
+
+    Tracked t;
+    t.session = session;
+    t.lastUp = 0;
+    t.lastDown = 0;
+    t.lastRateUp = 0;
+    t.lastRateDown = 0;
+    t.reported = false;
+    m_sessions.insert(id, t);
+}
+
+void RelayWorker::onSessionFinished(quint64 id)
+{
+    QHash<quint64, Tracked>::iterator it = m_sessions.find(id);
+    if (it == m_sessions.end()) {
+        return;
+    }
+    if (it->reported) {
+        m_closed.append(id);
+    }
+    it->session->deleteLater();
+    m_sessions.erase(it);
+}
+
+void RelayWorker::publish()
+{
+    m_trace.flush();
+
+    ConnectionInfoList changed;
+    for (QHash<quint64, Tracked>::iterator it = m_sessions.begin(); it != m_sessions.end(); ++it) {
+        RelaySession *s = it->session;
+        quint32 rateUp = (s->bytesUp() - it->lastUp) * 1000 / SnapshotInterval;
+        quint32 rateDown = (s->bytesDown() - it->lastDown) * 1000 / SnapshotInterval;
+        if (it->reported && rateUp == 0 && rateDown == 0 && it->lastRateUp == 0 && it->lastRateDown == 0) {
+            continue;//idle and already reported
+        }
+
+        ConnectionInfo info = s->info();
+        info.rateUp = rateUp;
+        info.rateDown = rateDown;
+        changed.append(info);
+
+        it->lastUp = s->bytesUp();
+        it->lastDown = s->bytesDown();
+        it->lastRateUp = rateUp;
+        it->lastRateDown = rateDown;
+        it->reported = true;
+    }
+
+    if (!changed.isEmpty() || !m_closed.isEmpty()) {
+        emit sessionsUpdated(changed, m_closed);
+        m_closed.clear();
+    }
+}
+
+void RelayWorker::shape()
+{
+    //sessions may finish while resumed, which changes m_sessions
+    QList<RelaySession *> waiting;
+    qint64 demandUp = 0;
+    qint64 demandDown = 0;
+    for (QHash<quint64, Tracked>::const_iterator it = m_sessions.constBegin(); it != m_sessions.constEnd(); ++it) {
+        qint64 up = it->session->waiting(RelayShaper::Up);
+        qint64 down = it->session->waiting(RelayShaper::Down);
+        if (up > 0 || down > 0) {
+            waiting.append(it->session);
+            demandUp += up;
+            demandDown += down;
+        }
+    }
+    m_shaper.refill(demandUp, demandDown);
+    if (waiting.isEmpty()) {
+        return;
+    }
+
+    //starting with another session every tick, so that none gets the tokens first all the time
+    int start = int(m_shapeRound++ % uint(waiting.size()));
+    for (int i = 0; i < waiting.size(); ++i) {
+        waiting.at((start + i) % waiting.size())->resume();
+    }
+}
@@ -0,0 +1,70 @@
+/*
+ * Relay Worker Class
+ *
+ * Owns the sessions handed over by SocksRelay and runs them in its own thread.
+ * Per-session figures are published periodically as deltas.
+ * With rate limits, the shaper is refilled every RelayShaper::TickInterval
+ * and the sessions waiting for tokens are resumed.
+ */
+#ifndef RELAYWORKER_H
+#define RELAYWORKER_H
+#include <QObject>
+#include <QHash>
+#include <QTimer>
+#include "connectioninfo.h"
+#include "latencyhistogram.h"
+#include "traffictrace.h"
+#include "relayshaper.h"
+
+class RelaySession;
+
+class RelayWorker : public QObject
+{
+    Q_OBJECT
+
+public:
+    RelayWorker(int index, quint16 upstreamPort, LatencySet *sink, const TrafficLimits &limits, ProfileBucket *bucket, QObject *parent = 0);
+    ~RelayWorker();
+    inline const WorkerCounters &counters() const { return m_counters; }
+    inline const LatencySet &latency() const { return m_latency; }
+
+    static const int SnapshotInterval;
+
+signals:
+    void sessionsUpdated(const ConnectionInfoList &changed, const ConnectionIdList &closed);
+
+public slots:
+    void addConnection(qintptr socketDescriptor);
+
+private:
+    struct Tracked
+    {
+        RelaySession *session;
+        quint64 lastUp;
+        quint64 lastDown;
+        quint32 lastRateUp;
+        quint32 lastRateDown;
+        bool reported;
+    };
+
+    WorkerCounters m_counters;
+    LatencySet m_latency;
+    LatencySet *m_sink;//receives m_latency when the worker goes away
+    TraceBuffer m_trace;
+    RelayShaper m_shaper;
+    int m_index;
+    quint16 m_upstreamPort;
+    quint64 m_nextId;
+    uint m_shapeRound;
+    QHash<quint64, Tracked> m_sessions;
+    ConnectionIdList m_closed;
+    QTimer m_snapshotTimer;
+    QTimer m_shapeTimer;
+
+private slots:
+    void onSessionFinished(quint64 id);
+    void publish();
+    void shape();
+};
+
+#endif // RELAYWORKER_H
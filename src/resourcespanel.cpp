@@ -0,0 +1,41 @@
+#include "connectionmodel.h"
+#include "sparklinewidget.h"
+#include "resourcespanel.h"
+#include "ui_resourcespanel.h"
+
+ResourcesPanel::ResourcesPanel(QWidget *parent) :
+    QWidget(parent),
+    ui(new Ui::ResourcesPanel)
+{
+    ui->setupUi(this);
+}
+
+ResourcesPanel::~ResourcesPanel()
+{
+    delete ui;
+}
+
+void ResourcesPanel::setHistory(const QVector<ProcessSample> &history)
+{
+    if (history.isEmpty()) {
+        return;
+    }
+
+    QVector<double> cpu, rss, fds, switches;
+    for (QVector<ProcessSample>::const_iterator it = history.constBegin(); it != history.constEnd(); ++it) {
+        cpu << it->cpuPercent;
+        rss << it->rssKiB;
+        fds << it->fds;
+        switches << it->switchesPerSec;
+    }
+
+    const ProcessSample &s = history.last();
+    ui->cpuSparkline->setValues(cpu);
+    ui->rssSparkline->setValues(rss);
+    ui->fdSparkline->setValues(fds);
+    ui->switchSparkline->setValues(switches);
+    ui->cpuValueLabel->setText(QString("%1%").arg(s.cpuPercent, 0, 'f', 1));
+    ui->rssValueLabel->setText(ConnectionModel::formatBytes(quint64(s.rssKiB) * 1024));
+    ui->fdValueLabel->setText(QString::number(s.fds));
+    ui->switchValueLabel->setText(tr("%1/s").arg(s.switchesPerSec, 0, 'f', 0));
+}
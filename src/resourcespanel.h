@@ -0,0 +1,31 @@
+/*
+ * Resources Panel Class
+ *
+ * The contents of the Resources tab: a sparkline and the latest value of
+ * each figure ProcessMonitor samples. MainWindow builds it the first time
+ * the tab is opened.
+ */
+#ifndef RESOURCESPANEL_H
+#define RESOURCESPANEL_H
+#include <QWidget>
+#include <QVector>
+#include "processmonitor.h"
+
+namespace Ui {
+class ResourcesPanel;
+}
+
+class ResourcesPanel : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit ResourcesPanel(QWidget *parent = 0);
+    ~ResourcesPanel();
+    void setHistory(const QVector<ProcessSample> &history);//the last sample is the current one
+
+private:
+    Ui::ResourcesPanel *ui;
+};
+
+#endif // RESOURCESPANEL_H
@@ -0,0 +1,178 @@
+#include <QDebug>
+#include "socksaddress.h"
+#include "muxframe.h"
+#include "muxcarrier.h"
+#include "serversession.h"
+
+const qint64 ServerSession::HighWater = 256 * 1024;
+
+ServerSession::ServerSession(quint64 id, const QString &method, const QByteArray &password, const SocketOptions *options, WorkerCounters *counters, QObject *parent) :
+    QObject(parent),
+    m_id(id),
+    m_options(options),
+    m_counters(counters),
+    m_client(this),
+    m_target(this),
+    m_cipher(method, password),
+    m_state(Header),
+    m_carrier(0),
+    m_finished(false)
+{
+    m_idle.start();
+    m_client.setReadBufferSize(HighWater);
+    m_target.setReadBufferSize(HighWater);
+
+    connect(&m_client, &QTcpSocket::readyRead, this, &ServerSession::pumpUp);
+    connect(&m_target, &QTcpSocket::connected, this, &ServerSession::onTargetConnected);
+    connect(&m_target, &QTcpSocket::bytesWritten, this, &ServerSession::pumpUp);
+    connect(&m_target, &QTcpSocket::readyRead, this, &ServerSession::pumpDown);
+    connect(&m_client, &QTcpSocket::bytesWritten, this, &ServerSession::pumpDown);
+
+    connect(&m_client, &QTcpSocket::disconnected, this, &ServerSession::onDisconnected);
+    connect(&m_target, &QTcpSocket::disconnected, this, &ServerSession::onDisconnected);
+    connect(&m_client, static_cast<void (QAbstractSocket::*)(QAbstractSocket::SocketError)>(&QAbstractSocket::error), this, &ServerSession::onDisconnected);
+    connect(&m_target, static_cast<void (QAbstractSocket::*)(QAbstractSocket::SocketError)>(&QAbstractSocket::error), this, &ServerSession::onDisconnected);
+}
+
+ServerSession::~ServerSession()
+{
+    delete m_carrier;//before the socket and cipher it works on
+    if (!m_finished) {
+        m_counters->active.fetch_sub(1, std::memory_order_relaxed);
+    }
+}
+
+bool ServerSession::start(qintptr socketDescriptor)
+{
+    if (!m_cipher.isValid() || !m_client.setSocketDescriptor(socketDescriptor)) {
+        m_finished = true;//never counted, nothing for the destructor to take back
+        return false;
+    }
+    m_counters->sessions.fetch_add(1, std::memory_order_relaxed);
+    m_counters->active.fetch_add(1, std::memory_order_relaxed);
+    m_options->apply(&m_client);
+    return true;
+}
+
+qint64 ServerSession::idleMSecs() const
+{
+    return m_carrier ? m_carrier->idleMSecs() : m_idle.elapsed();
+}
+
+void ServerSession::close()
+{
+    m_client.abort();
+    m_target.abort();
+    onDisconnected();
+}
+
+void ServerSession::readHeader()
+{
+    QByteArray data = m_client.read(HighWater);
+    if (data.isEmpty()) {
+        return;
+    }
+    m_pending.append(m_cipher.decrypt(data));
+
+    if (!m_pending.isEmpty() && quint8(m_pending.at(0)) == MuxFrame::CarrierType) {
+        if (m_pending.size() < 2) {
+            return;
+        }
+        if (quint8(m_pending.at(1)) != MuxFrame::Version) {
+            qWarning() << "Unsupported mux version" << int(quint8(m_pending.at(1)));
+            m_pending.clear();
+            m_client.abort();
+            onDisconnected();
+            return;
+        }
+        m_state = Mux;
+        m_carrier = new MuxCarrier(&m_client, &m_cipher, true, m_options, m_counters, this);
+        m_carrier->feed(m_pending.mid(2));
+        m_pending.clear();
+        return;
+    }
+
+    //the target address leads the stream, in the SOCKS5 format
+    QString host;
+    quint16 port;
+    int len = SocksAddress::parse(m_pending.constData(), m_pending.size(), &host, &port);
+    if (len == 0) {
+        return;
+    }
+    if (len < 0) {//wrong method or password, or a probe
+        //hanging up right after a bad header is what active probing looks for, keep reading instead
+        m_pending.clear();
+        m_state = Rejected;
+        m_client.readAll();
+        return;
+    }
+    m_pending.remove(0, len);
+    m_state = Connecting;
+    m_options->connectToHost(&m_target, host, port);
+}
+
+void ServerSession::onTargetConnected()
+{
+    m_state = Stream;
+    m_options->apply(&m_target);
+    m_target.write(m_pending);
+    m_counters->bytesUp.fetch_add(m_pending.size(), std::memory_order_relaxed);
+    m_pending.clear();
+    pumpUp();
+}
+
+void ServerSession::pumpUp()
+{
+    if (m_state == Header) {
+        readHeader();
+        return;
+    }
+    if (m_state == Rejected) {
+        m_client.readAll();//without restarting m_idle, the worker's sweep closes it
+        return;
+    }
+    if (m_state != Stream) {
+        return;//the client is not read until the target is there, the carrier reads it in mux mode
+    }
+
+    bool drain = m_client.state() != QAbstractSocket::ConnectedState;
+    while (m_client.bytesAvailable() > 0 && (drain || m_target.bytesToWrite() < HighWater)) {
+        QByteArray data = m_cipher.decrypt(m_client.read(64 * 1024));
+        m_target.write(data);
+        m_counters->bytesUp.fetch_add(data.size(), std::memory_order_relaxed);
+        m_idle.restart();
+    }
+}
+
+void ServerSession::pumpDown()
+{
+    if (m_state == Mux || m_client.state() != QAbstractSocket::ConnectedState) {
+        return;
+    }
+
+    bool drain = m_target.state() != QAbstractSocket::ConnectedState;
+    while (m_target.bytesAvailable() > 0 && (drain || m_client.bytesToWrite() < HighWater)) {
+        QByteArray data = m_target.read(64 * 1024);
+        m_client.write(m_cipher.encrypt(data));
+        m_counters->bytesDown.fetch_add(data.size(), std::memory_order_relaxed);
+        m_idle.restart();
+    }
+}
+
+void ServerSession::onDisconnected()
+{
+    pumpUp();
+    pumpDown();
+
+    if (m_client.state() == QAbstractSocket::UnconnectedState || m_target.state() == QAbstractSocket::UnconnectedState) {
+        //disconnectFromHost waits until pending data has been written
+        m_client.disconnectFromHost();
+        m_target.disconnectFromHost();
+    }
+
+    if (!m_finished && m_client.state() == QAbstractSocket::UnconnectedState && m_target.state() == QAbstractSocket::UnconnectedState) {
+        m_finished = true;
+        m_counters->active.fetch_sub(1, std::memory_order_relaxed);
+        emit finished(m_id);
+    }
+}
@@ -0,0 +1,70 @@
+/*
+ * Server Session Class
+ *
+ * One shadowsocks session on the server side: the target address is read
+ * from the decrypted stream, then everything is relayed between the client
+ * and the target. Neither side is read while the other one has more than
+ * HighWater bytes waiting to be written.
+ * A mux mode client sends a carrier header instead of a target address, the
+ * session then hands the connection over to a MuxCarrier.
+ */
+#ifndef SERVERSESSION_H
+#define SERVERSESSION_H
+#include <QObject>
+#include <QTcpSocket>
+#include <QByteArray>
+#include <QElapsedTimer>
+#include "connectioninfo.h"
+#include "sscipher.h"
+#include "socketoptions.h"
+
+class MuxCarrier;
+
+class ServerSession : public QObject
+{
+    Q_OBJECT
+
+public:
+    ServerSession(quint64 id, const QString &method, const QByteArray &password, const SocketOptions *options, WorkerCounters *counters, QObject *parent = 0);
+    ~ServerSession();
+    bool start(qintptr socketDescriptor);//on failure the descriptor is left to the caller
+    void close();
+    inline quint64 id() const { return m_id; }
+    qint64 idleMSecs() const;
+
+    static const qint64 HighWater;
+
+signals:
+    void finished(quint64 id);
+
+private:
+    enum State {
+        Header,
+        Connecting,
+        Stream,
+        Mux,
+        Rejected//a bad header, read and dropped until the client gives up or times out
+    };
+
+    quint64 m_id;
+    const SocketOptions *m_options;//the worker's
+    WorkerCounters *m_counters;
+    QTcpSocket m_client;
+    QTcpSocket m_target;
+    SSCipher m_cipher;
+    State m_state;
+    QByteArray m_pending;//decrypted, waiting for the target address or connection
+    QElapsedTimer m_idle;
+    MuxCarrier *m_carrier;
+    bool m_finished;
+
+    void readHeader();
+
+private slots:
+    void pumpUp();
+    void pumpDown();
+    void onTargetConnected();
+    void onDisconnected();
+};
+
+#endif // SERVERSESSION_H
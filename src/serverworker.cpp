@@ -0,0 +1,71 @@
+#include <QtGlobal>
+#ifdef Q_OS_WIN
+#include <winsock2.h>
+#else
+#include <unistd.h>
+#endif
+#include "serversession.h"
+#include "serverworker.h"
+
+ServerWorker::ServerWorker(int index, const QString &method, const QByteArray &password, int timeoutSecs, const SocketOptions &options, QObject *parent) :
+    QObject(parent),
+    m_index(index),
+    m_method(method),
+    m_password(password),
+    m_timeoutMSecs(qint64(timeoutSecs) * 1000),
+    m_socketOptions(options),
+    m_nextId(0),
+    m_sweepTimer(this)
+{
+    m_sweepTimer.setInterval(SweepInterval);
+    connect(&m_sweepTimer, &QTimer::timeout, this, &ServerWorker::sweep);
+}
+
+ServerWorker::~ServerWorker()
+{
+    //sessions touch m_counters when destroyed, so don't leave them to ~QObject
+    qDeleteAll(m_sessions);
+}
+
+void ServerWorker::addConnection(qintptr socketDescriptor)
+{
+    if (!m_sweepTimer.isActive()) {
+        m_sweepTimer.start();//started lazily so the timer belongs to this thread
+    }
+
+    quint64 id = (quint64(m_index) << 48) | m_nextId++;
+    ServerSession *session = new ServerSession(id, m_method, m_password, &m_socketOptions, &m_counters, this);
+    connect(session, &ServerSession::finished, this, &ServerWorker::onSessionFinished);
+    if (!session->start(socketDescriptor)) {
+        delete session;//the socket never adopted the descriptor, it's still ours to close
+#ifdef Q_OS_WIN
+        closesocket(socketDescriptor);
+#else
+        ::close(socketDescriptor);
+#endif
+        return;
+    }
+    m_sessions.insert(id, session);
+}
+
+void ServerWorker::onSessionFinished(quint64 id)
+{
+    ServerSession *session = m_sessions.take(id);
+    if (session) {
+        session->deleteLater();
+    }
+}
+
+void ServerWorker::sweep()
+{
+    //close() finishes the session, which removes it from m_sessions
+    QList<ServerSession *> idle;
+    for (QHash<quint64, ServerSession *>::const_iterator it = m_sessions.constBegin(); it != m_sessions.constEnd(); ++it) {
+        if (it.value()->idleMSecs() > m_timeoutMSecs) {
+            idle.append(it.value());
+        }
+    }
+    for (QList<ServerSession *>::iterator it = idle.begin(); it != idle.end(); ++it) {
+        (*it)->close();
+    }
+}
@@ -0,0 +1,47 @@
+/*
+ * Server Worker Class
+ *
+ * Owns the sessions handed over by SSServer and runs them in its own thread.
+ * Sessions idle for longer than the profile's timeout are closed.
+ */
+#ifndef SERVERWORKER_H
+#define SERVERWORKER_H
+#include <QObject>
+#include <QHash>
+#include <QTimer>
+#include "connectioninfo.h"
+#include "socketoptions.h"
+
+class ServerSession;
+
+class ServerWorker : public QObject
+{
+    Q_OBJECT
+
+public:
+    ServerWorker(int index, const QString &method, const QByteArray &password, int timeoutSecs, const SocketOptions &options, QObject *parent = 0);
+    ~ServerWorker();
+    inline const WorkerCounters &counters() const { return m_counters; }
+
+    static const int SweepInterval = 1000;
+
+public slots:
+    void addConnection(qintptr socketDescriptor);
+
+private:
+    WorkerCounters m_counters;
+    int m_index;
+    QString m_method;
+    QByteArray m_password;
+    qint64 m_timeoutMSecs;
+    SocketOptions m_socketOptions;
+    quint64 m_nextId;
+    QHash<quint64, ServerSession *> m_sessions;
+    QTimer m_sweepTimer;
+
+private slots:
+    void onSessionFinished(quint64 id);
+    void sweep();
+};
+
+#endif // SERVERWORKER_H
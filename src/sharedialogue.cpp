@@ -1,3 +1,5 @@
+#include <QFileDialog>
+#include <QMessageBox>
 #include "qrwidget.h"
 #include "sharedialogue.h"
 #include "ui_sharedialogue.h"
@@ -9,9 +11,21 @@ ShareDialogue::ShareDialogue(const QByteArray &ssUrl, QWidget *parent) :
     ui->setupUi(this);
     ui->qrWidget->setQRData(ssUrl);
     ui->ssUrlEdit->setText(QString(ssUrl));
+    connect(ui->saveButton, &QPushButton::clicked, this, &ShareDialogue::onSaveButtonClicked);
 }
 
 ShareDialogue::~ShareDialogue()
 {
     delete ui;
 }
+
+void ShareDialogue::onSaveButtonClicked()
+{
+    QString file = QFileDialog::getSaveFileName(this, tr("Save QR Code"), QString("qrcode.png"), tr("PNG Image (*.png);;SVG Image (*.svg)"));
+    if (file.isEmpty()) {
+        return;
+    }
+    if (!ui->qrWidget->exportTo(file)) {
+        QMessageBox::warning(this, tr("Save QR Code"), tr("Failed to save %1").arg(file));
+    }
+}
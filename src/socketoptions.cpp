@@ -0,0 +1,309 @@
+#include <QAbstractSocket>
+#include <QTcpServer>
+#include <QHostAddress>
+#include <QHostInfo>
+#include <QFile>
+#include <QStringList>
+#include <QDebug>
+#ifdef Q_OS_UNIX
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#endif
+#include "socketoptions.h"
+
+SocketOptions::SocketOptions() :
+    sendBuffer(0),
+    receiveBuffer(0),
+    noDelay(false),
+    keepAliveIdle(0),
+    keepAliveInterval(0),
+    keepAliveCount(0),
+    notSentLowat(0)
+{}
+
+bool SocketOptions::isDefault() const
+{
+    return *this == SocketOptions();
+}
+
+bool SocketOptions::operator==(const SocketOptions &o) const
+{
+    return sendBuffer == o.sendBuffer && receiveBuffer == o.receiveBuffer && congestion == o.congestion && noDelay == o.noDelay
+            && keepAliveIdle == o.keepAliveIdle && keepAliveInterval == o.keepAliveInterval && keepAliveCount == o.keepAliveCount
+            && notSentLowat == o.notSentLowat;
+}
+
+SocketOptions SocketOptions::fromJson(const QJsonObject &json)
+{
+    SocketOptions o;
+    o.sendBuffer = qMax(0, json["send_buffer"].toInt());
+    o.receiveBuffer = qMax(0, json["receive_buffer"].toInt());
+    o.congestion = json["congestion"].toString();
+    o.noDelay = json["no_delay"].toBool();
+    o.keepAliveIdle = qMax(0, json["keepalive_idle"].toInt());
+    o.keepAliveInterval = qMax(0, json["keepalive_interval"].toInt());
+    o.keepAliveCount = qMax(0, json["keepalive_count"].toInt());
+    o.notSentLowat = qMax(0, json["notsent_lowat"].toInt());
+    return o;
+}
+
+QJsonObject SocketOptions::toJson() const
+{
+    //only what is set, the way it would be written by hand
+    QJsonObject json;
+    if (sendBuffer > 0) {
+        json["send_buffer"] = QJsonValue(sendBuffer);
+    }
+    if (receiveBuffer > 0) {
+        json["receive_buffer"] = QJsonValue(receiveBuffer);
+    }
+    if (!congestion.isEmpty()) {
+        json["congestion"] = QJsonValue(congestion);
+    }
+    if (noDelay) {
+        json["no_delay"] = QJsonValue(true);
+    }
+    if (keepAliveIdle > 0) {
+        json["keepalive_idle"] = QJsonValue(keepAliveIdle);
+    }
+    if (keepAliveInterval > 0) {
+        json["keepalive_interval"] = QJsonValue(keepAliveInterval);
+    }
+    if (keepAliveCount > 0) {
+        json["keepalive_count"] = QJsonValue(keepAliveCount);
+    }
+    if (notSentLowat > 0) {
+        json["notsent_lowat"] = QJsonValue(notSentLowat);
+    }
+    return json;
+}
+
+#ifdef Q_OS_LINUX
+static QStringList procList(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QStringList();
+    }
+    return QString::fromLatin1(file.readAll()).simplified().split(' ', QString::SkipEmptyParts);
+}
+#endif
+
+SocketOptions SocketOptions::checked() const
+{
+    SocketOptions o = *this;
+#ifdef Q_OS_LINUX
+    if (!o.congestion.isEmpty()) {
+        //without CAP_NET_ADMIN only the allowed algorithms can be picked
+        QStringList available = procList("/proc/sys/net/ipv4/tcp_available_congestion_control");
+        QStringList allowed = procList("/proc/sys/net/ipv4/tcp_allowed_congestion_control");
+        if (!available.contains(o.congestion)) {
+            qWarning() << "Congestion control" << o.congestion << "is not available, ignoring it";
+            o.congestion.clear();
+        }
+        else if (!allowed.contains(o.congestion) && geteuid() != 0) {
+            qWarning() << "Congestion control" << o.congestion << "is not in net.ipv4.tcp_allowed_congestion_control, ignoring it";
+            o.congestion.clear();
+        }
+    }
+#ifdef TCP_NOTSENT_LOWAT
+    bool lowat = QFile::exists("/proc/sys/net/ipv4/tcp_notsent_lowat");//since Linux 3.12
+#else
+    bool lowat = false;
+#endif
+    if (o.notSentLowat > 0 && !lowat) {
+        qWarning() << "TCP_NOTSENT_LOWAT is not supported by this kernel, ignoring it";
+        o.notSentLowat = 0;
+    }
+#else
+    if (!o.congestion.isEmpty() || o.notSentLowat > 0) {
+        qWarning() << "Congestion control and TCP_NOTSENT_LOWAT are only supported on Linux, ignoring them";
+        o.congestion.clear();
+        o.notSentLowat = 0;
+    }
+    if (o.keepAliveInterval > 0 || o.keepAliveCount > 0) {
+        qWarning() << "Keepalive timings are only supported on Linux, using the system's";
+        o.keepAliveInterval = o.keepAliveCount = 0;
+    }
+#endif
+    return o;
+}
+
+#ifdef Q_OS_UNIX
+static void setOption(int fd, int level, int name, const void *value, socklen_t size, const char *what)
+{
+    if (setsockopt(fd, level, name, value, size) != 0) {
+        qWarning() << "Cannot set" << what << "on the socket:" << strerror(errno);
+    }
+}
+#endif
+
+void SocketOptions::applyBuffers(qintptr fd) const
+{
+#ifdef Q_OS_UNIX
+    if (fd < 0) {
+        return;
+    }
+    if (sendBuffer > 0) {
+        setOption(int(fd), SOL_SOCKET, SO_SNDBUF, &sendBuffer, sizeof(sendBuffer), "SO_SNDBUF");
+    }
+    if (receiveBuffer > 0) {
+        setOption(int(fd), SOL_SOCKET, SO_RCVBUF, &receiveBuffer, sizeof(receiveBuffer), "SO_RCVBUF");
+    }
+#else
+    Q_UNUSED(fd);
+#endif
+}
+
+bool SocketOptions::listen(QTcpServer *server, const QHostAddress &address, quint16 port) const
+{
+#ifdef Q_OS_UNIX
+    if (sendBuffer == 0 && receiveBuffer == 0) {
+        return server->listen(address, port);
+    }
+
+    //accepted sockets inherit the buffers, which must be there before listen() to count for the window scale
+    sockaddr_storage storage;
+    memset(&storage, 0, sizeof(storage));
+    socklen_t length;
+    bool v4 = address.protocol() == QAbstractSocket::IPv4Protocol;
+    if (v4) {
+        sockaddr_in *in = reinterpret_cast<sockaddr_in *>(&storage);
+        in->sin_family = AF_INET;
+        in->sin_port = htons(port);
+        in->sin_addr.s_addr = htonl(address.toIPv4Address());
+        length = sizeof(sockaddr_in);
+    } else {
+        sockaddr_in6 *in6 = reinterpret_cast<sockaddr_in6 *>(&storage);
+        in6->sin6_family = AF_INET6;
+        in6->sin6_port = htons(port);
+        if (address != QHostAddress::Any) {
+            Q_IPV6ADDR ip = address.toIPv6Address();
+            memcpy(&in6->sin6_addr, &ip, sizeof(ip));
+        }
+        length = sizeof(sockaddr_in6);
+    }
+
+    int fd = socket(v4 ? AF_INET : AF_INET6, SOCK_STREAM, IPPROTO_TCP);
+    if (fd < 0) {
+        qWarning() << "Cannot create the listening socket:" << strerror(errno);
+        return false;
+    }
+    int on = 1, off = 0;
+    setOption(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on), "SO_REUSEADDR");
+    if (address == QHostAddress::Any) {//both protocols, like QTcpServer
+        setOption(fd, IPPROTO_IPV6, IPV6_V6ONLY, &off, sizeof(off), "IPV6_V6ONLY");
+    }
+    applyBuffers(fd);
+    if (bind(fd, reinterpret_cast<sockaddr *>(&storage), length) != 0 || ::listen(fd, 50) != 0) {
+        qWarning() << "Cannot listen on" << address.toString() << port << strerror(errno);
+        ::close(fd);
+        return false;
+    }
+    if (!server->setSocketDescriptor(fd)) {
+        ::close(fd);
+        return false;
+    }
+    return true;
+#else
+    return server->listen(address, port);
+#endif
+}
+
+static void connectPrepared(const SocketOptions &options, QAbstractSocket *socket, const QHostAddress &address, quint16 port)
+{
+    //a bound socket keeps its descriptor for the connection, so the buffers are there before the SYN
+    QHostAddress any = address.protocol() == QAbstractSocket::IPv6Protocol ? QHostAddress::AnyIPv6 : QHostAddress::AnyIPv4;
+    if (socket->bind(any, 0)) {
+        options.applyBuffers(socket->socketDescriptor());
+    } else {
+        qWarning() << "Cannot prepare the socket, connecting with the default buffers:" << socket->errorString();
+    }
+    socket->connectToHost(address, port);
+}
+
+void SocketOptions::connectToHost(QAbstractSocket *socket, const QString &host, quint16 port) const
+{
+#ifdef Q_OS_UNIX
+    if (sendBuffer > 0 || receiveBuffer > 0) {
+        QHostAddress address;
+        if (address.setAddress(host)) {
+            connectPrepared(*this, socket, address, port);
+            return;
+        }
+#if QT_VERSION >= QT_VERSION_CHECK(5, 9, 0)
+        //the descriptor is made for the protocol of the address, so that is looked up first
+        SocketOptions options = *this;
+        QHostInfo::lookupHost(host, socket, [socket, host, port, options](const QHostInfo &info) {
+            if (info.error() != QHostInfo::NoError || info.addresses().isEmpty()) {
+                socket->connectToHost(host, port);//fails again and reports it the usual way
+            } else {
+                connectPrepared(options, socket, info.addresses().first(), port);
+            }
+        });
+        return;
+#endif
+    }
+#endif
+    socket->connectToHost(host, port);
+}
+
+void SocketOptions::apply(QAbstractSocket *socket) const
+{
+    //the portable ones through Qt
+#ifndef Q_OS_UNIX
+    //no descriptor of our own here, so the buffers come late and autotuning is off for them
+    if (sendBuffer > 0) {
+        socket->setSocketOption(QAbstractSocket::SendBufferSizeSocketOption, sendBuffer);
+    }
+    if (receiveBuffer > 0) {
+        socket->setSocketOption(QAbstractSocket::ReceiveBufferSizeSocketOption, receiveBuffer);
+    }
+#endif
+    if (noDelay) {
+        socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+    }
+    if (keepAliveIdle > 0) {
+        socket->setSocketOption(QAbstractSocket::KeepAliveOption, 1);
+    }
+
+#ifdef Q_OS_LINUX
+    int fd = int(socket->socketDescriptor());
+    if (fd < 0) {
+        return;
+    }
+    if (!congestion.isEmpty()) {
+        QByteArray name = congestion.toLatin1();
+        setOption(fd, IPPROTO_TCP, TCP_CONGESTION, name.constData(), socklen_t(name.size()), "TCP_CONGESTION");
+    }
+    if (keepAliveIdle > 0) {
+        setOption(fd, IPPROTO_TCP, TCP_KEEPIDLE, &keepAliveIdle, sizeof(keepAliveIdle), "TCP_KEEPIDLE");
+        if (keepAliveInterval > 0) {
+            setOption(fd, IPPROTO_TCP, TCP_KEEPINTVL, &keepAliveInterval, sizeof(keepAliveInterval), "TCP_KEEPINTVL");
+        }
+        if (keepAliveCount > 0) {
+            setOption(fd, IPPROTO_TCP, TCP_KEEPCNT, &keepAliveCount, sizeof(keepAliveCount), "TCP_KEEPCNT");
+        }
+    }
+#ifdef TCP_NOTSENT_LOWAT
+    if (notSentLowat > 0) {
+        setOption(fd, IPPROTO_TCP, TCP_NOTSENT_LOWAT, &notSentLowat, sizeof(notSentLowat), "TCP_NOTSENT_LOWAT");
+    }
+#endif
+#endif
+}
+
+QDataStream &operator<<(QDataStream &s, const SocketOptions &o)
+{
+    return s << o.sendBuffer << o.receiveBuffer << o.congestion << o.noDelay << o.keepAliveIdle << o.keepAliveInterval << o.keepAliveCount << o.notSentLowat;
+}
+
+QDataStream &operator>>(QDataStream &s, SocketOptions &o)
+{
+    return s >> o.sendBuffer >> o.receiveBuffer >> o.congestion >> o.noDelay >> o.keepAliveIdle >> o.keepAliveInterval >> o.keepAliveCount >> o.notSentLowat;
+}
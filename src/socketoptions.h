@@ -0,0 +1,57 @@
+/*
+ * Socket Options Class
+ *
+ * The per-profile TCP tuning of gui-config.json's "socket_options": buffer
+ * sizes, congestion control, TCP_NODELAY, keepalive timings and
+ * TCP_NOTSENT_LOWAT. Zero or empty means the system default.
+ * They are applied to the sockets ss-qt5 opens to the network itself, in
+ * mux and server mode, and to the server's listening socket. Backends only
+ * get what they have a flag for.
+ */
+#ifndef SOCKETOPTIONS_H
+#define SOCKETOPTIONS_H
+#include <QString>
+#include <QJsonObject>
+#include <QDataStream>
+
+class QAbstractSocket;
+class QTcpServer;
+class QHostAddress;
+
+struct SocketOptions
+{
+    int sendBuffer;//bytes
+    int receiveBuffer;
+    QString congestion;//e.g. bbr or cubic
+    bool noDelay;
+    int keepAliveIdle;//seconds, switches keepalive on
+    int keepAliveInterval;
+    int keepAliveCount;
+    int notSentLowat;//bytes
+
+    SocketOptions();
+    bool isDefault() const;
+    bool operator==(const SocketOptions &o) const;
+    inline bool operator!=(const SocketOptions &o) const { return !(*this == o); }
+
+    static SocketOptions fromJson(const QJsonObject &json);
+    QJsonObject toJson() const;
+
+    //a copy without what this kernel doesn't support, with a warning for each
+    SocketOptions checked() const;
+    /*
+     * The buffer sizes have to be set before the connection is made, the
+     * SYN carries the window scale they allow for. Sockets ss-qt5 accepts
+     * get them from listen(), the ones it opens from connectToHost().
+     * Everything else is set by apply() once the socket is connected.
+     */
+    void applyBuffers(qintptr fd) const;
+    bool listen(QTcpServer *server, const QHostAddress &address, quint16 port) const;
+    void connectToHost(QAbstractSocket *socket, const QString &host, quint16 port) const;
+    void apply(QAbstractSocket *socket) const;
+};
+
+QDataStream &operator<<(QDataStream &s, const SocketOptions &o);
+QDataStream &operator>>(QDataStream &s, SocketOptions &o);
+
+#endif // SOCKETOPTIONS_H
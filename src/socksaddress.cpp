@@ -0,0 +1,85 @@
+#include <QHostAddress>
+#include <cstring>
+#include "socksaddress.h"
+
+int SocksAddress::parse(const char *data, int len, QString *host, quint16 *port)
+{
+    if (len < 1) {
+        return 0;
+    }
+
+    const uchar *p = reinterpret_cast<const uchar *>(data);
+    int addrLen;
+    switch (p[0]) {
+    case 1://IPv4
+        addrLen = 4;
+        break;
+    case 3://domain name
+        if (len < 2) {
+            return 0;
+        }
+        addrLen = 1 + p[1];
+        break;
+    case 4://IPv6
+        addrLen = 16;
+        break;
+    default:
+        return -1;
+    }
+
+    int total = 1 + addrLen + 2;
+    if (len < total) {
+        return 0;
+    }
+
+    if (host) {
+        switch (p[0]) {
+        case 1:
+            *host = QHostAddress((quint32(p[1]) << 24) | (quint32(p[2]) << 16) | (quint32(p[3]) << 8) | p[4]).toString();
+            break;
+        case 3:
+            *host = QString::fromLatin1(data + 2, p[1]);
+            break;
+        default:
+            Q_IPV6ADDR ip6;
+            memcpy(ip6.c, p + 1, 16);
+            *host = QHostAddress(ip6).toString();
+        }
+    }
+    if (port) {
+        *port = (quint16(p[total - 2]) << 8) | p[total - 1];
+    }
+    return total;
+}
+
+QByteArray SocksAddress::encode(const QString &host, quint16 port)
+{
+    QByteArray out;
+    QHostAddress addr;
+    if (addr.setAddress(host) && addr.protocol() == QAbstractSocket::IPv4Protocol) {
+        quint32 ip = addr.toIPv4Address();
+        out.append(char(1));
+        out.append(char(ip >> 24)).append(char(ip >> 16)).append(char(ip >> 8)).append(char(ip));
+    }
+    else if (!addr.isNull() && addr.protocol() == QAbstractSocket::IPv6Protocol) {
+        Q_IPV6ADDR ip6 = addr.toIPv6Address();
+        out.append(char(4));
+        out.append(reinterpret_cast<const char *>(ip6.c), 16);
+    }
+    else {
+        QByteArray name = host.toLatin1().left(255);
+        out.append(char(3));
+        out.append(char(name.size()));
+        out.append(name);
+    }
+    out.append(char(port >> 8)).append(char(port & 0xff));
+    return out;
+}
+
+QString SocksAddress::toString(const QString &host, quint16 port)
+{
+    if (host.contains(':')) {
+        return QString("[%1]:%2").arg(host).arg(port);
+    }
+    return QString("%1:%2").arg(host).arg(port);
+}
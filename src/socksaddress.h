@@ -0,0 +1,23 @@
+/*
+ * Helpers for the SOCKS5 address format (ATYP, address, port), which is
+ * also the target header of the shadowsocks protocol.
+ */
+#ifndef SOCKSADDRESS_H
+#define SOCKSADDRESS_H
+#include <QString>
+#include <QByteArray>
+
+class SocksAddress
+{
+public:
+    /*
+     * Parses an address at the beginning of data.
+     * Returns the number of bytes it occupies, 0 if data is incomplete,
+     * or -1 if the address type is unknown.
+     */
+    static int parse(const char *data, int len, QString *host, quint16 *port);
+    static QByteArray encode(const QString &host, quint16 port);
+    static QString toString(const QString &host, quint16 port);
+};
+
+#endif // SOCKSADDRESS_H
@@ -0,0 +1,167 @@
+#include <QThread>
+#include <QTcpSocket>
+#include <QDebug>
+#ifdef Q_OS_WIN
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <sys/socket.h>
+#include <netinet/in.h>
+#endif
+#include "relayworker.h"
+#include "socksrelay.h"
+
+SocksRelay::SocksRelay(QObject *parent) :
+    QObject(parent),
+    m_server(this),
+    m_next(0),
+    m_dispatched(0),
+    m_rejected(0)
+{
+    qRegisterMetaType<qintptr>("qintptr");
+    qRegisterMetaType<ConnectionInfoList>("ConnectionInfoList");
+    qRegisterMetaType<ConnectionIdList>("ConnectionIdList");
+    connect(&m_server, &RelayServer::newDescriptor, this, &SocksRelay::dispatch);
+}
+
+SocksRelay::~SocksRelay()
+{
+    stop();
+}
+
+quint16 SocksRelay::pickFreePort()
+{
+    QTcpServer probe;
+    if (!probe.listen(QHostAddress::LocalHost, 0)) {
+        return 0;
+    }
+    quint16 port = probe.serverPort();
+    probe.close();
+    return port;
+}
+
+bool SocksRelay::start(const QHostAddress &address, quint16 port, quint16 upstreamPort, LatencySet *latencySink, const TrafficLimits &limits)
+{
+    stop();
+    if (!m_server.listen(address, port)) {
+        qWarning() << tr("Relay cannot listen on") << address.toString() << port << m_server.errorString();
+        return false;
+    }
+
+    m_limits = limits;
+    m_dispatched = 0;
+    int n = qBound(1, QThread::idealThreadCount(), 4);
+    m_bucket.reset(limits.rate, n);
+    for (int i = 0; i < n; ++i) {
+        QThread *thread = new QThread(this);
+        RelayWorker *worker = new RelayWorker(i, upstreamPort, latencySink, limits, &m_bucket);
+        worker->moveToThread(thread);
+        connect(thread, &QThread::finished, worker, &QObject::deleteLater);
+        connect(worker, &RelayWorker::sessionsUpdated, this, &SocksRelay::sessionsUpdated);
+        thread->start();
+        m_threads.append(thread);
+        m_workers.append(worker);
+    }
+    return true;
+}
+
+void SocksRelay::stop()
+{
+    m_server.close();
+
+    //keep the figures of this run, the workers are about to go away
+    m_retired = totals();
+    m_retired.active = 0;
+    m_rejected = 0;
+
+    for (QVector<QThread *>::iterator it = m_threads.begin(); it != m_threads.end(); ++it) {
+        (*it)->quit();
+        (*it)->wait();
+        delete *it;
+    }
+    m_threads.clear();
+    m_workers.clear();
+}
+
+uint SocksRelay::clientHash(qintptr socketDescriptor)
+{
+    sockaddr_storage addr;
+    socklen_t len = sizeof(addr);
+    if (getpeername(socketDescriptor, reinterpret_cast<sockaddr *>(&addr), &len) != 0) {
+        return 0;
+    }
+    if (addr.ss_family == AF_INET) {
+        return qHash(reinterpret_cast<sockaddr_in *>(&addr)->sin_addr.s_addr);
+    }
+    if (addr.ss_family == AF_INET6) {
+        const sockaddr_in6 *in6 = reinterpret_cast<sockaddr_in6 *>(&addr);
+        return qHash(QByteArray::fromRawData(reinterpret_cast<const char *>(&in6->sin6_addr), sizeof(in6->sin6_addr)));
+    }
+    return 0;
+}
+
+void SocksRelay::dispatch(qintptr socketDescriptor)
+{
+    if (m_limits.maxSessions > 0) {
+        //open ones plus those still on their way to a worker
+        RelayTotals live;
+        for (QVector<RelayWorker *>::const_iterator it = m_workers.constBegin(); it != m_workers.constEnd(); ++it) {
+            (*it)->counters().addTo(live);
+        }
+        if (live.active + (m_dispatched - live.sessions) >= quint64(m_limits.maxSessions)) {
+            QTcpSocket refused;
+            refused.setSocketDescriptor(socketDescriptor);
+            refused.abort();
+            ++m_rejected;
+            return;
+        }
+    }
+    ++m_dispatched;
+
+    RelayWorker *worker;
+    if (m_limits.clientRate > 0) {
+        worker = m_workers.at(clientHash(socketDescriptor) % uint(m_workers.size()));
+    }
+    else {
+        worker = m_workers.at(m_next);
+        m_next = (m_next + 1) % m_workers.size();
+    }
+    QMetaObject::invokeMethod(worker, "addConnection", Qt::QueuedConnection, Q_ARG(qintptr, socketDescriptor));
+}
+
+RelayTotals SocksRelay::totals() const
+{
+    RelayTotals t = m_retired;
+    t.rejected += m_rejected;
+    for (QVector<RelayWorker *>::const_iterator it = m_workers.constBegin(); it != m_workers.constEnd(); ++it) {
+        (*it)->counters().addTo(t);
+    }
+    return t;
+}
+
+void SocksRelay::addLiveLatency(LatencySet &out) const
+{
+    for (QVector<RelayWorker *>::const_iterator it = m_workers.constBegin(); it != m_workers.constEnd(); ++it) {
+        out.merge((*it)->latency());
+    }
+}
+
+quint64 SocksRelay::totalBytesUp() const
+{
+    return totals().bytesUp;
+}
+
+quint64 SocksRelay::totalBytesDown() const
+{
+    return totals().bytesDown;
+}
+
+quint64 SocksRelay::totalSessions() const
+{
+    return totals().sessions;
+}
+
+quint32 SocksRelay::activeSessions() const
+{
+    return totals().active;
+}
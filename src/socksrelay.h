@@ -0,0 +1,79 @@
+/*
+ * SOCKS Relay Class
+ *
+ * Listens on the profile's local address and hands every accepted client to
+ * one of a few RelayWorker threads, which forward it to the backend.
+ * This is what lets ss-qt5 see the individual sessions of a running profile,
+ * and enforce its TrafficLimits: sessions over the limit are refused here,
+ * and with a per-client rate all sessions of a client address go to the same
+ * worker, which keeps the client's bucket.
+ */
+#ifndef SOCKSRELAY_H
+#define SOCKSRELAY_H
+#include <QObject>
+#include <QTcpServer>
+#include <QHostAddress>
+#include <QVector>
+#include "connectioninfo.h"
+#include "latencyhistogram.h"
+#include "relayshaper.h"
+
+class QThread;
+class RelayWorker;
+
+class RelayServer : public QTcpServer
+{
+    Q_OBJECT
+
+public:
+    RelayServer(QObject *parent = 0) : QTcpServer(parent) {}
+
+signals:
+    void newDescriptor(qintptr socketDescriptor);
+
+protected:
+    void incomingConnection(qintptr socketDescriptor) { emit newDescriptor(socketDescriptor); }
+};
+
+class SocksRelay : public QObject
+{
+    Q_OBJECT
+
+public:
+    SocksRelay(QObject *parent = 0);
+    ~SocksRelay();
+    bool start(const QHostAddress &address, quint16 port, quint16 upstreamPort, LatencySet *latencySink = 0, const TrafficLimits &limits = TrafficLimits());
+    void stop();
+    inline void stopAccepting() { m_server.close(); }//sessions already accepted carry on, to drain before stop()
+    inline bool isListening() const { return m_server.isListening(); }
+
+    quint64 totalBytesUp() const;
+    quint64 totalBytesDown() const;
+    quint64 totalSessions() const;
+    quint32 activeSessions() const;
+    RelayTotals totals() const;
+    void addLiveLatency(LatencySet &out) const;
+
+    static quint16 pickFreePort();
+
+signals:
+    void sessionsUpdated(const ConnectionInfoList &changed, const ConnectionIdList &closed);
+
+private:
+    RelayServer m_server;
+    QVector<QThread *> m_threads;
+    QVector<RelayWorker *> m_workers;
+    int m_next;
+    RelayTotals m_retired;
+    TrafficLimits m_limits;
+    ProfileBucket m_bucket;
+    quint64 m_dispatched;//sessions handed to the workers in this run
+    quint64 m_rejected;//in this run
+
+    static uint clientHash(qintptr socketDescriptor);
+
+private slots:
+    void dispatch(qintptr socketDescriptor);
+};
+
+#endif // SOCKSRELAY_H
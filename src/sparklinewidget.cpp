@@ -0,0 +1,63 @@
+#include <QPainter>
+#include <QPolygonF>
+#include "sparklinewidget.h"
+
+SparklineWidget::SparklineWidget(QWidget *parent) :
+    QWidget(parent)
+{}
+
+void SparklineWidget::setValues(const QVector<double> &values)
+{
+    m_values = values;
+    update();
+}
+
+QSize SparklineWidget::sizeHint() const
+{
+    return QSize(120, 24);
+}
+
+QString SparklineWidget::toText(const QVector<double> &values, int width)
+{
+    //unicode block elements, for places that can only show text such as tooltips
+    static const QString blocks = QString::fromUtf8("▁▂▃▄▅▆▇█");
+    QVector<double> tail = values.mid(qMax(0, values.size() - width));
+    double top = 0;
+    for (QVector<double>::const_iterator it = tail.constBegin(); it != tail.constEnd(); ++it) {
+        top = qMax(top, *it);
+    }
+
+    QString text;
+    for (QVector<double>::const_iterator it = tail.constBegin(); it != tail.constEnd(); ++it) {
+        int level = top > 0 ? qBound(0, int(*it / top * (blocks.size() - 1) + 0.5), blocks.size() - 1) : 0;
+        text.append(blocks.at(level));
+    }
+    return text;
+}
+
+void SparklineWidget::paintEvent(QPaintEvent *)
+{
+    QPainter painter(this);
+    painter.setRenderHint(QPainter::Antialiasing);
+    if (m_values.size() < 2) {
+        return;
+    }
+
+    double top = 0;
+    for (QVector<double>::const_iterator it = m_values.constBegin(); it != m_values.constEnd(); ++it) {
+        top = qMax(top, *it);
+    }
+    if (top <= 0) {
+        top = 1;
+    }
+
+    const double w = width() - 1;
+    const double h = height() - 2;
+    const double step = w / (m_values.size() - 1);
+    QPolygonF line;
+    for (int i = 0; i < m_values.size(); ++i) {
+        line << QPointF(i * step, 1 + h - m_values[i] / top * h);
+    }
+    painter.setPen(QPen(palette().color(QPalette::Highlight), 1.5));
+    painter.drawPolyline(line);
+}
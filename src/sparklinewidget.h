@@ -0,0 +1,25 @@
+#ifndef SPARKLINEWIDGET_H
+#define SPARKLINEWIDGET_H
+
+#include <QWidget>
+#include <QVector>
+#include <QPaintEvent>
+
+class SparklineWidget : public QWidget
+{
+    Q_OBJECT
+public:
+    explicit SparklineWidget(QWidget *parent = 0);
+    void setValues(const QVector<double> &values);
+    QSize sizeHint() const;
+
+    static QString toText(const QVector<double> &values, int width = 12);
+
+private:
+    QVector<double> m_values;
+
+protected:
+    void paintEvent(QPaintEvent *);
+};
+
+#endif // SPARKLINEWIDGET_H
@@ -1,29 +1,66 @@
-SOURCES      += src/main.cpp\
+include($$PWD/core.pri)
+
+SOURCES      += src/main.cpp \
                 src/mainwindow.cpp \
-                src/ss_process.cpp \
                 src/ip4validator.cpp \
                 src/portvalidator.cpp \
                 src/addprofiledialogue.cpp \
-                src/ssvalidator.cpp \
-                src/ssprofile.cpp \
-                src/configuration.cpp \
                 src/qrwidget.cpp \
-                src/sharedialogue.cpp
+                src/qrmatrix.cpp \
+                src/qrbatchexporter.cpp \
+                src/batchexportdialogue.cpp \
+                src/sharedialogue.cpp \
+                src/logeventstore.cpp \
+                src/logparser.cpp \
+                src/logeventmodel.cpp \
+                src/loglinemodel.cpp \
+                src/logviewer.cpp \
+                src/connectionmodel.cpp \
+                src/metricsserver.cpp \
+                src/metricscollector.cpp \
+                src/processmonitor.cpp \
+                src/sparklinewidget.cpp \
+                src/connectionspanel.cpp \
+                src/resourcespanel.cpp \
+                src/profilemodel.cpp \
+                src/subscriptionmanager.cpp \
+                src/subscriptiondialogue.cpp \
+                src/daemonlink.cpp
 
 HEADERS      += src/mainwindow.h \
-                src/ss_process.h \
-                src/ssprofile.h \
                 src/ip4validator.h \
                 src/portvalidator.h \
                 src/addprofiledialogue.h \
-                src/ssvalidator.h \
-                src/configuration.h \
                 src/qrwidget.h \
-                src/sharedialogue.h
+                src/qrmatrix.h \
+                src/qrbatchexporter.h \
+                src/batchexportdialogue.h \
+                src/sharedialogue.h \
+                src/logeventstore.h \
+                src/logparser.h \
+                src/logeventmodel.h \
+                src/loglinemodel.h \
+                src/logviewer.h \
+                src/connectionmodel.h \
+                src/metricsserver.h \
+                src/metricscollector.h \
+                src/processmonitor.h \
+                src/sparklinewidget.h \
+                src/connectionspanel.h \
+                src/resourcespanel.h \
+                src/profilemodel.h \
+                src/subscriptionmanager.h \
+                src/subscriptiondialogue.h \
+                src/daemonlink.h
 
 FORMS        += src/mainwindow.ui \
                 src/addprofiledialogue.ui \
-                src/sharedialogue.ui
+                src/sharedialogue.ui \
+                src/logviewer.ui \
+                src/subscriptiondialogue.ui \
+                src/batchexportdialogue.ui \
+                src/connectionspanel.ui \
+                src/resourcespanel.ui
 
 RESOURCES    += src/icons.qrc
 
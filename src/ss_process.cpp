@@ -2,9 +2,17 @@
 #include <QFileInfo>
 #include <QDir>
 #include "ss_process.h"
+#include "ssvalidator.h"
+#include "tracer.h"
+#include "traffictrace.h"
 
 SS_Process::SS_Process(QObject *parent) :
-    QObject(parent)
+    QObject(parent),
+    running(false),
+    relayMode(false),
+    connectProbe(false),
+    traceSpawn(-1),
+    traceStarted(-1)
 {
     proc.setReadChannelMode(QProcess::MergedChannels);
     connect(&proc, &QProcess::readyRead, this, &SS_Process::autoemitreadReadyProcess);
@@ -13,87 +21,206 @@ SS_Process::SS_Process(QObject *parent) :
 }
 
 SS_Process::~SS_Process()
-{}
+{
+    //the relay workers hand their histograms over when they are destroyed
+    probe.stop();
+    socksRelay.stop();
+    qDeleteAll(profileLatency);
+}
 
-bool SS_Process::isRunning()
+bool SS_Process::isRunning() const
 {
     return running;
 }
 
 void SS_Process::start(SSProfile * const p, bool debug)
 {
+    stop();
+    if (!p->plugin.isEmpty() && !p->plugin_trusted) {
+        qCritical() << tr("Aborted: the plugin hasn't been confirmed yet.") << p->plugin;
+        return;
+    }
     app_path = p->backend;
     backendTypeID = p->getBackendTypeID();
-    start(p->server, p->password, p->server_port, p->local_addr, p->local_port, p->method, p->timeout, p->custom_arg, debug, p->fast_open);
+    profileName = p->profileName;
+    if (!profileLatency.contains(profileName)) {
+        profileLatency.insert(profileName, new LatencySet);
+    }
+    LatencySet *latencySink = profileLatency.value(profileName);
+
+    /*
+     * In relay mode, ss-qt5 takes over the local address and the backend
+     * listens on a loopback port only the relay talks to.
+     * The relay is what enforces traffic limits, so they switch it on.
+     */
+    QString l_addr = p->local_addr;
+    QString l_port = p->local_port;
+    if (relayMode || !p->limits.isDefault()) {
+        quint16 upstream = SocksRelay::pickFreePort();
+        if (upstream != 0 && socksRelay.start(QHostAddress(p->local_addr), p->local_port.toUShort(), upstream, latencySink, p->limits)) {
+            l_addr = "127.0.0.1";
+            l_port = QString::number(upstream);
+        }
+        else {
+            qWarning() << tr("Relay unavailable, starting backend without it.");
+        }
+    }
+    else if (TrafficTrace::isEnabled()) {
+        qWarning() << tr("Traffic is only recorded in relay mode.");
+    }
+    if (connectProbe) {
+        probe.start(p->server, p->server_port.toUShort(), &latencySink->connect);
+    }
+    if (p->mux > 0) {
+        if (!muxClient.start(QHostAddress(l_addr), l_port.toUShort(), *p)) {
+            probe.stop();
+            socksRelay.stop();
+            return;
+        }
+        running = true;
+        qDebug() << tr("Multiplexing over") << p->mux << tr("connections to") << p->server;
+        emit sigstart();
+        return;
+    }
+    if (SSValidator::isAead(p->method) && (backendTypeID == 1 || backendTypeID == 2)) {
+        qWarning() << tr("The nodejs and go backends don't support AEAD methods, the backend is likely to refuse") << p->method;
+    }
+    QStringList extra_args;
+    if (!p->plugin.isEmpty()) {
+        if (backendTypeID == 0) {//only libev supports SIP003 plugins
+            extra_args << "--plugin" << p->plugin << "--plugin-opts" << p->plugin_opts;
+        } else {
+            qWarning() << tr("The backend doesn't support plugins, ignoring") << p->plugin;
+        }
+    }
+    //backends have no flags for the other socket options, mux mode applies them all
+    SocketOptions ignored = p->socket_options;
+    if (ignored.noDelay && backendTypeID == 0) {//libev
+        extra_args << "--no-delay";
+        ignored.noDelay = false;
+    }
+    if (!ignored.isDefault()) {
+        qWarning() << tr("The backend doesn't support these socket options, ignoring") << ignored.toJson();
+    }
+    extra_args << splitArguments(p->custom_arg);
+    start(p->server, p->password, p->server_port, l_addr, l_port, p->method, p->timeout, extra_args, debug, p->fast_open);
 }
 
-void SS_Process::start(QString &args)
+QStringList SS_Process::splitArguments(const QString &command)
 {
-    stop();
+    //the same rules as QProcess: blanks separate, double quotes group and "" is a literal quote
+    QStringList args;
+    QString arg;
+    bool quoted = false, pending = false;
+    for (int i = 0; i < command.size(); ++i) {
+        QChar c = command.at(i);
+        if (c == QChar('"')) {
+            if (quoted && i + 1 < command.size() && command.at(i + 1) == QChar('"')) {
+                arg.append(c);
+                ++i;
+            } else {
+                quoted = !quoted;
+            }
+            pending = true;
+        } else if (!quoted && c.isSpace()) {
+            if (pending) {
+                args << arg;
+                arg.clear();
+                pending = false;
+            }
+        } else {
+            arg.append(c);
+            pending = true;
+        }
+    }
+    if (pending) {
+        args << arg;
+    }
+    return args;
+}
+
+LatencySet SS_Process::latency(const QString &name) const
+{
+    LatencySet set;
+    LatencySet *recorded = profileLatency.value(name);
+    if (recorded) {
+        set.merge(*recorded);
+    }
+    if (name == profileName) {
+        socksRelay.addLiveLatency(set);
+    }
+    return set;
+}
+
+void SS_Process::start(QStringList &args)
+{
+    if (proc.isOpen()) {
+        proc.close();
+    }
+    traceSpawn = Q_UNLIKELY(Tracer::isEnabled()) ? Tracer::now() : -1;
+    traceStarted = -1;
+    //every value is its own argument, nothing from a profile is parsed by a shell or split again
 #ifdef Q_OS_WIN
     QString sslocalbin = QFileInfo(app_path).dir().canonicalPath();
     sslocalbin.append("/node_modules/shadowsocks/bin/sslocal");
-    sslocalbin = QString("\"") + QDir::toNativeSeparators(sslocalbin) + QString("\"");
     switch (backendTypeID) {
     case 0://libev
-        args.append(" -u");
+        args << "-u";
     case 2://go
         proc.setProgram(app_path);
         break;
     case 1://nodejs
         proc.setProgram("node");
-        args.prepend(sslocalbin);
+        args.prepend(QDir::toNativeSeparators(sslocalbin));
         break;
     case 3://python
         proc.setProgram("python");
-        args.prepend(QString("\""));
         args.prepend(app_path);
-        args.prepend(QString("\""));
         break;
     default:
         qWarning() << tr("Aborted: Invalid Backend Type.") << backendTypeID;
         return;
     }
-    proc.setNativeArguments(args);
-    proc.start();
 #else
-    proc.start(app_path + QString(" ") + args);
+    proc.setProgram(app_path);
 #endif
+    proc.setArguments(args);
+    proc.start();
     qDebug() << tr("Backend arguments are ") << args;
     proc.waitForStarted(1000);//wait for at most 1 second
 }
 
-void SS_Process::start(const QString &server, const QString &pwd, const QString &s_port, const QString &l_addr, const QString &l_port, const QString &method, const QString &timeout, const QString &custom_arg, bool debug, bool tfo)
+void SS_Process::start(const QString &server, const QString &pwd, const QString &s_port, const QString &l_addr, const QString &l_port, const QString &method, const QString &timeout, const QStringList &extra_args, bool debug, bool tfo)
 {
-    QString args;
-    args.append(QString(" -s ") + server);
-    args.append(QString(" -p ") + s_port);
-    args.append(QString(" -b ") + l_addr);
-    args.append(QString(" -l ") + l_port);
-    args.append(QString(" -k \"") + pwd + QString("\""));
-    args.append(QString(" -m ") + method.toLower());
+    QStringList args;
+    args << "-s" << server;
+    args << "-p" << s_port;
+    args << "-b" << l_addr;
+    args << "-l" << l_port;
+    args << "-k" << pwd;
+    args << "-m" << method.toLower();
     if (backendTypeID != 2) {//go port doesn't support this argument
-        args.append(QString(" -t ") + timeout);
+        args << "-t" << timeout;
     }
 
     if (debug) {
         if(backendTypeID == 2) {
-            args.append("-d=true");//shadowsocks-go
+            args << "-d=true";//shadowsocks-go
         }
         else {
-            args.append(" -v");
+            args << "-v";
         }
     }
 
 #ifdef Q_OS_LINUX
     if ((backendTypeID == 3 || backendTypeID == 0) && tfo) {//only python and libev ports support tfo
-        args.append(" --fast-open");
+        args << "--fast-open";
     }
 #else
     Q_UNUSED(tfo);
 #endif
 
-    args.append(" ").append(custom_arg);
+    args << extra_args;
     start(args);
 }
 
@@ -102,16 +229,33 @@ void SS_Process::stop()
     if (proc.isOpen()) {
         proc.close();
     }
+    probe.stop();
+    socksRelay.stop();
+    if (muxClient.isListening()) {
+        muxClient.stop();
+        running = false;
+        emit sigstop();
+    }
 }
 
 void SS_Process::autoemitreadReadyProcess()
 {
+    //the first output line is the backend announcing it listens
+    if (Q_UNLIKELY(traceStarted >= 0)) {
+        Tracer::complete("backend ready", "backend", traceStarted, Tracer::now() - traceStarted);
+        traceStarted = -1;
+    }
     emit readReadyProcess(proc.readAll());
 }
 
 void SS_Process::started()
 {
     running = true;
+    if (Q_UNLIKELY(traceSpawn >= 0)) {
+        traceStarted = Tracer::now();
+        Tracer::complete("backend spawn", "backend", traceSpawn, traceStarted - traceSpawn);
+        traceSpawn = -1;
+    }
     qDebug() << tr("Backend started. PID: ") <<proc.pid();
     emit sigstart();
 }
@@ -120,5 +264,7 @@ void SS_Process::exited(int e)
 {
     qDebug() << tr("Backend exited. Exit Code: ") << e;
     running = false;
+    probe.stop();
+    socksRelay.stop();
     emit sigstop();
 }
@@ -9,8 +9,14 @@
 #define SS_PROCESS_H
 #include <QObject>
 #include <QString>
+#include <QStringList>
 #include <QProcess>
+#include <QHash>
 #include "ssprofile.h"
+#include "socksrelay.h"
+#include "muxclient.h"
+#include "connectprobe.h"
+#include "latencyhistogram.h"
 
 class SS_Process : public QObject
 {
@@ -21,7 +27,13 @@ public:
     ~SS_Process();
     void start(SSProfile * const, bool debug = false);
     void stop();
-    bool isRunning();
+    bool isRunning() const;
+    inline qint64 pid() const { return proc.processId(); }
+    inline void setRelayMode(bool r) { relayMode = r; }
+    inline void setConnectProbe(bool p) { connectProbe = p; }
+    inline SocksRelay *relay() { return &socksRelay; }
+    inline const SocksRelay *relay() const { return &socksRelay; }
+    LatencySet latency(const QString &profileName) const;
 
 signals:
     void readReadyProcess(const QByteArray &o);
@@ -33,9 +45,19 @@ private:
     int backendTypeID;
     QString app_path;
     QProcess proc;
+    bool relayMode;
+    bool connectProbe;
+    SocksRelay socksRelay;
+    MuxClient muxClient;//runs instead of the backend when the profile multiplexes
+    ConnectProbe probe;
+    QString profileName;
+    QHash<QString, LatencySet *> profileLatency;
+    qint64 traceSpawn;//trace timestamps of the spawn request and of started(), -1 when not tracing
+    qint64 traceStarted;
 
-    void start(const QString&, const QString&, const QString&, const QString&, const QString&, const QString&, const QString&, const QString&, bool debug = false, bool tfo = false);
-    void start(QString &args);
+    void start(const QString&, const QString&, const QString&, const QString&, const QString&, const QString&, const QString&, const QStringList&, bool debug = false, bool tfo = false);
+    void start(QStringList &args);
+    static QStringList splitArguments(const QString &command);
 
 private slots:
     void autoemitreadReadyProcess();
@@ -0,0 +1,187 @@
+#include <QCryptographicHash>
+#include <QDebug>
+#include <openssl/evp.h>
+#include <openssl/rand.h>
+#include <openssl/opensslv.h>
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+#include <openssl/provider.h>
+#endif
+#include "sscipher.h"
+
+//the sizes are the ones every port uses, whatever the cipher allows
+const SSCipher::MethodInfo SSCipher::Methods[] = {
+    { "rc4", "rc4", 16, 0 },
+    { "rc4-md5", "rc4", 16, 16 },
+    { "aes-128-cfb", "aes-128-cfb", 16, 16 },
+    { "aes-192-cfb", "aes-192-cfb", 24, 16 },
+    { "aes-256-cfb", "aes-256-cfb", 32, 16 },
+    { "bf-cfb", "bf-cfb", 16, 8 },
+    { "camellia-128-cfb", "camellia-128-cfb", 16, 16 },
+    { "camellia-192-cfb", "camellia-192-cfb", 24, 16 },
+    { "camellia-256-cfb", "camellia-256-cfb", 32, 16 },
+    { "cast5-cfb", "cast5-cfb", 16, 8 },
+    { "des-cfb", "des-cfb", 8, 8 },
+    { "idea-cfb", "idea-cfb", 16, 8 },
+    { "rc2-cfb", "rc2-cfb", 16, 8 },
+    { "seed-cfb", "seed-cfb", 16, 16 },
+    { 0, 0, 0, 0 }
+};
+
+static void loadProviders()
+{
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+    //RC4, Blowfish, CAST5, DES, IDEA, RC2 and SEED live in the legacy provider since OpenSSL 3
+    static bool loaded = OSSL_PROVIDER_load(0, "legacy") != 0 && OSSL_PROVIDER_load(0, "default") != 0;
+    Q_UNUSED(loaded);
+#endif
+}
+
+SSCipher::SSCipher(const QString &method, const QByteArray &password) :
+    m_info(find(method)),
+    m_encCtx(0),
+    m_decCtx(0),
+    m_encReady(false),
+    m_decReady(false)
+{
+    if (!m_info) {
+        qWarning() << "Unsupported method" << method;
+        return;
+    }
+    loadProviders();
+    m_key = deriveKey(password, m_info->keySize);
+    m_encCtx = EVP_CIPHER_CTX_new();
+    m_decCtx = EVP_CIPHER_CTX_new();
+}
+
+SSCipher::~SSCipher()
+{
+    EVP_CIPHER_CTX_free(m_encCtx);
+    EVP_CIPHER_CTX_free(m_decCtx);
+}
+
+int SSCipher::ivSize() const
+{
+    return m_info ? m_info->ivSize : 0;
+}
+
+const SSCipher::MethodInfo *SSCipher::find(const QString &method)
+{
+    QByteArray m = method.toLatin1().toLower();
+    for (const MethodInfo *it = Methods; it->name; ++it) {
+        if (m == it->name) {
+            return it;
+        }
+    }
+    return 0;
+}
+
+QByteArray SSCipher::deriveKey(const QByteArray &password, int keySize)
+{
+    //EVP_BytesToKey with MD5, one iteration and no salt
+    QByteArray key, block;
+    while (key.size() < keySize) {
+        block = QCryptographicHash::hash(block + password, QCryptographicHash::Md5);
+        key.append(block);
+    }
+    key.truncate(keySize);
+    return key;
+}
+
+bool SSCipher::initContext(evp_cipher_ctx_st *ctx, const QByteArray &iv, bool encrypt)
+{
+    const EVP_CIPHER *cipher = EVP_get_cipherbyname(m_info->evpName);
+    if (!cipher) {
+        return false;
+    }
+
+    QByteArray key = m_key;
+    if (qstrcmp(m_info->name, "rc4-md5") == 0) {
+        key = QCryptographicHash::hash(m_key + iv, QCryptographicHash::Md5);
+    }
+
+    //RC4, Blowfish, CAST5 and RC2 take keys of any length, which must be set first
+    int enc = encrypt ? 1 : 0;
+    if (EVP_CipherInit_ex(ctx, cipher, 0, 0, 0, enc) != 1 || EVP_CIPHER_CTX_set_key_length(ctx, key.size()) != 1) {
+        return false;
+    }
+    const unsigned char *ivData = m_info->ivSize > 0 && EVP_CIPHER_iv_length(cipher) > 0 ? reinterpret_cast<const unsigned char *>(iv.constData()) : 0;
+    return EVP_CipherInit_ex(ctx, 0, 0, reinterpret_cast<const unsigned char *>(key.constData()), ivData, enc) == 1;
+}
+
+QByteArray SSCipher::encrypt(const char *data, int len)
+{
+    if (!isValid()) {
+        return QByteArray();
+    }
+
+    QByteArray out;
+    int offset = 0;
+    if (!m_encReady) {
+        QByteArray iv(m_info->ivSize, Qt::Uninitialized);
+        if ((iv.size() > 0 && RAND_bytes(reinterpret_cast<unsigned char *>(iv.data()), iv.size()) != 1) || !initContext(m_encCtx, iv, true)) {
+            qWarning() << "Cannot initialise" << m_info->name;
+            return QByteArray();
+        }
+        m_encReady = true;
+        out = iv;
+        offset = iv.size();
+    }
+
+    //every supported mode is a stream mode, the output is as long as the input
+    out.resize(offset + len);
+    int outLen = 0;
+    if (len > 0 && EVP_CipherUpdate(m_encCtx, reinterpret_cast<unsigned char *>(out.data()) + offset, &outLen, reinterpret_cast<const unsigned char *>(data), len) != 1) {
+        return QByteArray();
+    }
+    return out;
+}
+
+QByteArray SSCipher::decrypt(const char *data, int len)
+{
+    if (!isValid()) {
+        return QByteArray();
+    }
+
+    if (!m_decReady) {
+        int need = qMin(m_info->ivSize - m_decIv.size(), len);
+        m_decIv.append(data, need);
+        data += need;
+        len -= need;
+        if (m_decIv.size() < m_info->ivSize) {
+            return QByteArray();
+        }
+        if (!initContext(m_decCtx, m_decIv, false)) {
+            qWarning() << "Cannot initialise" << m_info->name;
+            return QByteArray();
+        }
+        m_decReady = true;
+    }
+
+    QByteArray out(len, Qt::Uninitialized);
+    int outLen = 0;
+    if (len > 0 && EVP_CipherUpdate(m_decCtx, reinterpret_cast<unsigned char *>(out.data()), &outLen, reinterpret_cast<const unsigned char *>(data), len) != 1) {
+        return QByteArray();
+    }
+    return out;
+}
+
+bool SSCipher::isSupported(const QString &method)
+{
+    const MethodInfo *info = find(method);
+    if (!info) {
+        return false;
+    }
+    SSCipher probe(method, QByteArray("probe"));
+    return probe.isValid() && !probe.encrypt("x", 1).isEmpty();
+}
+
+QStringList SSCipher::supportedMethods()
+{
+    QStringList list;
+    for (const MethodInfo *it = Methods; it->name; ++it) {
+        if (isSupported(QString::fromLatin1(it->name))) {
+            list << QString::fromLatin1(it->name);
+        }
+    }
+    return list;
+}
@@ -0,0 +1,62 @@
+/*
+ * Shadowsocks Cipher Class
+ *
+ * The stream ciphers of the shadowsocks protocol, on top of OpenSSL's
+ * libcrypto: the key is derived from the password as EVP_BytesToKey with MD5
+ * does, and each direction starts with its own random IV.
+ * One object holds both directions of a connection.
+ */
+#ifndef SSCIPHER_H
+#define SSCIPHER_H
+#include <QString>
+#include <QByteArray>
+#include <QStringList>
+
+struct evp_cipher_ctx_st;
+
+class SSCipher
+{
+public:
+    SSCipher(const QString &method, const QByteArray &password);
+    ~SSCipher();
+    inline bool isValid() const { return m_info != 0 && m_encCtx != 0 && m_decCtx != 0; }
+    int ivSize() const;
+
+    //the first call prepends the IV
+    QByteArray encrypt(const char *data, int len);
+    inline QByteArray encrypt(const QByteArray &plain) { return encrypt(plain.constData(), plain.size()); }
+
+    //the IV is read from the beginning of the stream, so the first calls may return nothing
+    QByteArray decrypt(const char *data, int len);
+    inline QByteArray decrypt(const QByteArray &cipher) { return decrypt(cipher.constData(), cipher.size()); }
+
+    static bool isSupported(const QString &method);
+    static QStringList supportedMethods();//by the linked libcrypto
+
+private:
+    Q_DISABLE_COPY(SSCipher)
+
+    struct MethodInfo
+    {
+        const char *name;
+        const char *evpName;
+        int keySize;
+        int ivSize;
+    };
+
+    const MethodInfo *m_info;
+    QByteArray m_key;
+    evp_cipher_ctx_st *m_encCtx;
+    evp_cipher_ctx_st *m_decCtx;
+    bool m_encReady;
+    bool m_decReady;
+    QByteArray m_decIv;//collected until it is complete
+
+    bool initContext(evp_cipher_ctx_st *ctx, const QByteArray &iv, bool encrypt);
+
+    static const MethodInfo Methods[];
+    static const MethodInfo *find(const QString &method);
+    static QByteArray deriveKey(const QByteArray &password, int keySize);
+};
+
+#endif // SSCIPHER_H
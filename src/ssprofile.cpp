@@ -1,10 +1,10 @@
 #include <QDir>
 #include <QFile>
 #include <QStringList>
-#include <QStandardPaths>
-#include <QCoreApplication>
 #include <QDebug>
 #include "ssvalidator.h"
+#include "ssuri.h"
+#include "backendregistry.h"
 #include "ssprofile.h"
 
 SSProfile::SSProfile() :
@@ -13,24 +13,52 @@ SSProfile::SSProfile() :
     fast_open(false),
     local_addr("127.0.0.1"),
     local_port("1080"),
+    limits(),
     method("aes-256-cfb"),
+    mux(0),
     password(),
+    plugin(),
+    plugin_opts(),
+    plugin_trusted(true),
     profileName(),
     server(),
     server_port("8388"),
+    socket_options(),
+    tag(),
     timeout("600"),
     type("Shadowsocks-libev")
 { }
 
-QByteArray SSProfile::getSsUrl()
+bool SSProfile::fromSsUrl(const QString &url, SSProfile *p)
+{
+    return fromSsUrl(url.toUtf8(), p);
+}
+
+bool SSProfile::fromSsUrl(const QByteArray &url, SSProfile *p)
 {
     /*
-     * cook a ss:// url
+     * Accepts both the legacy and the SIP002 format. A #remark, as
+     * published by subscriptions, becomes the name.
      */
-    QString ssurl = QString("%1:%2@%3:%4").arg(method.toLower()).arg(password).arg(server).arg(server_port);
-    QByteArray ba = QByteArray(ssurl.toStdString().c_str()).toBase64();
-    ba.prepend("ss://");
-    return ba;
+    SSUri uri;
+    if (!uri.parse(url) || !SSValidator::validateMethod(uri.method.data, uri.method.size)) {
+        return false;
+    }
+
+    p->method = uri.method.toString().toUpper();
+    p->password = uri.password.toString();
+    p->server = uri.host.toString();
+    p->server_port = uri.port.toString();
+    p->plugin = uri.plugin.toString();
+    p->plugin_opts = uri.pluginOpts.toString();
+    p->profileName = uri.remark.isEmpty() ? QString("%1:%2").arg(p->server).arg(p->server_port) : uri.remark.toString();
+    return true;
+}
+
+QByteArray SSProfile::getSsUrl() const
+{
+    //the legacy format is understood by every client, unless a plugin needs SIP002
+    return SSUri::build(SSUri::Legacy, method, password, server, server_port, plugin, plugin_opts, profileName);
 }
 
 void SSProfile::setBackend(bool relativePath)
@@ -54,15 +82,7 @@ void SSProfile::setBackend(bool relativePath)
         execName = "ss-local";
     }
 
-#ifdef Q_OS_WIN
-    QStringList findPathsList(QCoreApplication::applicationDirPath());
-#else
-    QStringList findPathsList(QDir::homePath() + "/.config/shadowsocks/bin");
-#endif
-    sslocal = QStandardPaths::findExecutable(execName, findPathsList);//search ss-qt5 directory first
-    if(sslocal.isEmpty()) {//if not found then search system's PATH
-        sslocal = QStandardPaths::findExecutable(execName);
-    }
+    sslocal = BackendRegistry::instance()->find(execName);
     this->setBackend(sslocal, relativePath);
 }
 
@@ -118,42 +138,19 @@ int SSProfile::getBackendTypeID()
 
 bool SSProfile::isBackendMatchType()
 {
-    QFile file(backend);
-    if (!file.exists()) {
+    BackendInfo info = BackendRegistry::instance()->info(backend);
+    if (info.typeID < 0) {
         qWarning() << "Backend does not exist.";
         return false;
     }
-
-    file.open(QIODevice::ReadOnly | QIODevice::Text);
-    if (!file.isReadable() || !file.isOpen()) {
-        qWarning() << "Cannot read from backend.";
-        return false;
-    }
-
-    int rType = 0;
-    QString ident(file.readLine());
-    if (ident.contains("node")) {
-        rType = 1;
-    }
-    else if (ident.contains("python")) {
-        rType = 3;
-    }
-    else {
-        if (backend.contains("ss-local")) {
-            rType = 0;//libev
-        }
-        else
-            rType = 2;//Go
-    }
-
-    return (rType == this->getBackendTypeID());
+    return (info.typeID == this->getBackendTypeID());
 }
 
 bool SSProfile::isValid() const
 {
     bool valid;
     QFile backendFile(backend);
-    valid = SSValidator::validatePort(server_port) && SSValidator::validatePort(local_port) && SSValidator::validateMethod(method) && backendFile.exists();
+    valid = SSValidator::validatePort(server_port) && SSValidator::validatePort(local_port) && SSValidator::validateMethod(method) && (mux > 0 || backendFile.exists());//mux mode needs no backend
 
     //TODO: more accurate
     if (server.isEmpty() || local_addr.isEmpty() || timeout.toInt() < 1 || !valid) {
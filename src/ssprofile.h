@@ -2,12 +2,16 @@
 #define SSPROFILE_H
 
 #include <QString>
+#include "socketoptions.h"
+#include "trafficlimits.h"
 
 class SSProfile
 {
 public:
     SSProfile();
-    QByteArray getSsUrl();
+    static bool fromSsUrl(const QString &url, SSProfile *p);
+    static bool fromSsUrl(const QByteArray &url, SSProfile *p);
+    QByteArray getSsUrl() const;
     bool isBackendMatchType();
     bool isValid() const;
     int getBackendTypeID();
@@ -20,11 +24,18 @@ public:
     bool fast_open;
     QString local_addr;
     QString local_port;
+    TrafficLimits limits;
     QString method;
+    int mux;//carrier connections when multiplexing, 0 for a connection per session
     QString password;
+    QString plugin;
+    QString plugin_opts;
+    bool plugin_trusted;//false until the user confirms a plugin a subscription brought in
     QString profileName;
     QString server;
     QString server_port;
+    SocketOptions socket_options;
+    QString tag;
     QString timeout;
     QString type;
 };
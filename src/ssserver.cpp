@@ -0,0 +1,99 @@
+#include <QThread>
+#include <QNetworkInterface>
+#include <QDebug>
+#include "sscipher.h"
+#include "ssvalidator.h"
+#include "serverworker.h"
+#include "ssserver.h"
+
+SSServer::SSServer(QObject *parent) :
+    QObject(parent),
+    m_server(this),
+    m_next(0)
+{
+    qRegisterMetaType<qintptr>("qintptr");
+    connect(&m_server, &RelayServer::newDescriptor, this, &SSServer::dispatch);
+}
+
+SSServer::~SSServer()
+{
+    stop();
+}
+
+QHostAddress SSServer::listenAddress(const QString &server, bool publicListen)
+{
+    if (!publicListen) {
+        return QHostAddress::LocalHost;
+    }
+    //the profile's server is where clients connect to, bind to it only if it is ours
+    QHostAddress addr;
+    if (addr.setAddress(server) && QNetworkInterface::allAddresses().contains(addr)) {
+        return addr;
+    }
+    return QHostAddress::Any;
+}
+
+bool SSServer::start(const SSProfile &profile, bool publicListen)
+{
+    return start(listenAddress(profile.server, publicListen), profile.server_port.toUShort(), profile.method, profile.password.toUtf8(), profile.timeout.toInt(), profile.socket_options.checked());
+}
+
+bool SSServer::start(const QHostAddress &address, quint16 port, const QString &method, const QByteArray &password, int timeoutSecs, const SocketOptions &options)
+{
+    stop();
+    if (!SSCipher::isSupported(method)) {
+        qWarning() << tr("Server doesn't support method") << method
+                   << (SSValidator::isAead(method) ? tr("(AEAD methods are not implemented by the built-in server)") : QString());
+        return false;
+    }
+    if (!options.listen(&m_server, address, port)) {
+        qWarning() << tr("Server cannot listen on") << address.toString() << port << m_server.errorString();
+        return false;
+    }
+
+    m_next = 0;
+    int n = qBound(1, QThread::idealThreadCount(), 8);
+    for (int i = 0; i < n; ++i) {
+        QThread *thread = new QThread(this);
+        ServerWorker *worker = new ServerWorker(i, method, password, qMax(1, timeoutSecs), options);
+        worker->moveToThread(thread);
+        connect(thread, &QThread::finished, worker, &QObject::deleteLater);
+        thread->start();
+        m_threads.append(thread);
+        m_workers.append(worker);
+    }
+    return true;
+}
+
+void SSServer::stop()
+{
+    m_server.close();
+
+    //keep the figures of this run, the workers are about to go away
+    m_retired = totals();
+    m_retired.active = 0;
+
+    for (QVector<QThread *>::iterator it = m_threads.begin(); it != m_threads.end(); ++it) {
+        (*it)->quit();
+        (*it)->wait();
+        delete *it;
+    }
+    m_threads.clear();
+    m_workers.clear();
+}
+
+void SSServer::dispatch(qintptr socketDescriptor)
+{
+    ServerWorker *worker = m_workers.at(m_next);
+    m_next = (m_next + 1) % m_workers.size();
+    QMetaObject::invokeMethod(worker, "addConnection", Qt::QueuedConnection, Q_ARG(qintptr, socketDescriptor));
+}
+
+RelayTotals SSServer::totals() const
+{
+    RelayTotals t = m_retired;
+    for (QVector<ServerWorker *>::const_iterator it = m_workers.constBegin(); it != m_workers.constEnd(); ++it) {
+        (*it)->counters().addTo(t);
+    }
+    return t;
+}
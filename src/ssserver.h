@@ -0,0 +1,50 @@
+/*
+ * Shadowsocks Server Class
+ *
+ * The server side of the protocol, for testing and lab setups: it listens on
+ * the profile's server_port, decrypts with its method and password, and
+ * relays every session to its target. Only the unauthenticated stream
+ * ciphers are implemented, so it listens on loopback unless told otherwise.
+ * Like SocksRelay, it hands every accepted socket to one of a few worker
+ * threads, each running its sessions non-blocking on its own event loop.
+ */
+#ifndef SSSERVER_H
+#define SSSERVER_H
+#include <QObject>
+#include <QHostAddress>
+#include <QVector>
+#include "socksrelay.h"
+#include "ssprofile.h"
+
+class QThread;
+class ServerWorker;
+
+class SSServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    SSServer(QObject *parent = 0);
+    ~SSServer();
+    bool start(const SSProfile &profile, bool publicListen = false);
+    bool start(const QHostAddress &address, quint16 port, const QString &method, const QByteArray &password, int timeoutSecs, const SocketOptions &options = SocketOptions());
+    void stop();
+    inline void stopAccepting() { m_server.close(); }//sessions already accepted carry on, to drain before stop()
+    inline bool isListening() const { return m_server.isListening(); }
+    inline quint16 serverPort() const { return m_server.serverPort(); }
+    RelayTotals totals() const;
+
+    static QHostAddress listenAddress(const QString &server, bool publicListen);
+
+private:
+    RelayServer m_server;
+    QVector<QThread *> m_threads;
+    QVector<ServerWorker *> m_workers;
+    int m_next;
+    RelayTotals m_retired;
+
+private slots:
+    void dispatch(qintptr socketDescriptor);
+};
+
+#endif // SSSERVER_H
@@ -0,0 +1,275 @@
+#include <cstring>
+#include "ssuri.h"
+
+namespace {
+
+inline bool isSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+inline int hexValue(char c)
+{
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+inline int base64Value(char c)
+{
+    if (c >= 'A' && c <= 'Z') {
+        return c - 'A';
+    }
+    if (c >= 'a' && c <= 'z') {
+        return c - 'a' + 26;
+    }
+    if (c >= '0' && c <= '9') {
+        return c - '0' + 52;
+    }
+    if (c == '+' || c == '-') {
+        return 62;
+    }
+    if (c == '/' || c == '_') {
+        return 63;
+    }
+    return -1;
+}
+
+}
+
+SSUri::SSUri() :
+    format(Legacy),
+    portNumber(0),
+    m_out(m_inline)
+{}
+
+bool SSUri::parse(const char *b, const char *e)
+{
+    format = Legacy;
+    method = password = host = port = plugin = pluginOpts = remark = Span();
+    portNumber = 0;
+
+    while (b < e && isSpace(*b)) {
+        ++b;
+    }
+    while (e > b && isSpace(e[-1])) {
+        --e;
+    }
+    //must begin with ss:// to distinguish from random base64 encoded strings
+    if (e - b < 5 || qstrnicmp(b, "ss://", 5) != 0) {
+        return false;
+    }
+    b += 5;
+
+    //decoding never grows the data, so the input length is enough for every field
+    if (e - b <= InlineSize) {
+        m_out = m_inline;
+    } else {
+        m_heap.resize(e - b);
+        m_out = m_heap.data();
+    }
+
+    const char *hash = e;
+    const char *query = 0;
+    const char *at = 0;//the last one, the password may contain '@'
+    for (const char *p = b; p < e; ++p) {
+        if (*p == '#') {
+            hash = p;
+            break;
+        } else if (*p == '?') {
+            query = query ? query : p;
+        } else if (*p == '@' && !query) {
+            at = p;
+        }
+    }
+
+    if (hash < e) {
+        remark = percentDecode(hash + 1, e);
+    }
+    const char *stop = query ? query : hash;
+    if (query && !parseQuery(query + 1, hash)) {
+        return false;
+    }
+
+    if (at) {
+        //SIP002: the user info is base64url, or percent-encoded plain text
+        format = Sip002;
+        if (stop > at && stop[-1] == '/') {
+            --stop;
+        }
+        Span info = memchr(b, ':', at - b) ? percentDecode(b, at) : base64Decode(b, at);
+        return info.data && splitUserInfo(info) && splitHostPort(at + 1, stop);
+    }
+
+    //legacy: everything but the remark is encoded
+    Span plain = base64Decode(b, stop);
+    if (!plain.data) {
+        return false;
+    }
+    const char *plainEnd = plain.data + plain.size;
+    const char *plainAt = 0;
+    for (const char *p = plain.data; p < plainEnd; ++p) {
+        if (*p == '@') {
+            plainAt = p;
+        }
+    }
+    return plainAt && splitUserInfo(Span(plain.data, plainAt - plain.data)) && splitHostPort(plainAt + 1, plainEnd);
+}
+
+SSUri::Span SSUri::percentDecode(const char *b, const char *e)
+{
+    //a malformed escape is kept as it is, remarks come from all kinds of tools
+    Span s(m_out, 0);
+    while (b < e) {
+        int hi, lo;
+        if (*b == '%' && e - b >= 3 && (hi = hexValue(b[1])) >= 0 && (lo = hexValue(b[2])) >= 0) {
+            *m_out++ = char(hi << 4 | lo);
+            b += 3;
+        } else {
+            *m_out++ = *b++;
+        }
+    }
+    s.size = m_out - s.data;
+    return s;
+}
+
+SSUri::Span SSUri::base64Decode(const char *b, const char *e)
+{
+    for (int i = 0; i < 2 && e > b && e[-1] == '='; ++i) {
+        --e;
+    }
+    if ((e - b) % 4 == 1) {
+        return Span();
+    }
+
+    Span s(m_out, 0);
+    quint32 bits = 0;
+    int count = 0;
+    for (; b < e; ++b) {
+        int v = base64Value(*b);
+        if (v < 0) {
+            m_out = const_cast<char *>(s.data);
+            return Span();
+        }
+        bits = bits << 6 | v;
+        count += 6;
+        if (count >= 8) {
+            count -= 8;
+            *m_out++ = char(bits >> count);
+        }
+    }
+    s.size = m_out - s.data;
+    return s;
+}
+
+bool SSUri::splitUserInfo(Span info)
+{
+    //the method never contains ':', the password may
+    const char *colon = static_cast<const char *>(memchr(info.data, ':', info.size));
+    if (!colon || colon == info.data) {
+        return false;
+    }
+    method = Span(info.data, colon - info.data);
+    password = Span(colon + 1, info.data + info.size - colon - 1);
+    return true;
+}
+
+bool SSUri::splitHostPort(const char *b, const char *e)
+{
+    const char *portStart;
+    if (b < e && *b == '[') {
+        const char *close = static_cast<const char *>(memchr(b, ']', e - b));
+        if (!close || close + 1 >= e || close[1] != ':') {
+            return false;
+        }
+        host = Span(b + 1, close - b - 1);
+        portStart = close + 2;
+    } else {
+        const char *colon = 0;
+        for (const char *p = b; p < e; ++p) {
+            if (*p == ':') {
+                colon = p;
+            }
+        }
+        if (!colon) {
+            return false;
+        }
+        host = Span(b, colon - b);
+        portStart = colon + 1;
+    }
+
+    port = Span(portStart, e - portStart);
+    if (host.isEmpty() || port.isEmpty() || port.size > 5) {
+        return false;
+    }
+    quint32 n = 0;
+    for (const char *p = portStart; p < e; ++p) {
+        if (*p < '0' || *p > '9') {
+            return false;
+        }
+        n = n * 10 + (*p - '0');
+    }
+    if (n == 0 || n > 65535) {
+        return false;
+    }
+    portNumber = quint16(n);
+    return true;
+}
+
+bool SSUri::parseQuery(const char *b, const char *e)
+{
+    while (b < e) {
+        const char *amp = static_cast<const char *>(memchr(b, '&', e - b));
+        const char *paramEnd = amp ? amp : e;
+        const char *eq = static_cast<const char *>(memchr(b, '=', paramEnd - b));
+        if (eq && eq - b == 6 && memcmp(b, "plugin", 6) == 0) {
+            Span value = percentDecode(eq + 1, paramEnd);
+            const char *semicolon = static_cast<const char *>(memchr(value.data, ';', value.size));
+            if (semicolon) {
+                plugin = Span(value.data, semicolon - value.data);
+                pluginOpts = Span(semicolon + 1, value.data + value.size - semicolon - 1);
+            } else {
+                plugin = value;
+            }
+            if (plugin.isEmpty()) {
+                return false;
+            }
+        }
+        b = paramEnd + 1;
+    }
+    return true;
+}
+
+QByteArray SSUri::build(Format format, const QString &method, const QString &password, const QString &host, const QString &port,
+                        const QString &plugin, const QString &pluginOpts, const QString &remark)
+{
+    QByteArray uri("ss://");
+    uri.reserve(64 + 2 * (method.size() + password.size() + host.size() + plugin.size() + pluginOpts.size() + remark.size()));
+    if (format == Legacy && plugin.isEmpty()) {
+        uri += (method.toLower() + QChar(':') + password + QChar('@') + host + QChar(':') + port).toUtf8().toBase64();
+    } else {
+        uri += (method.toLower() + QChar(':') + password).toUtf8().toBase64(QByteArray::Base64UrlEncoding | QByteArray::OmitTrailingEquals);
+        uri += '@';
+        if (host.contains(QChar(':'))) {
+            uri += '[' + host.toUtf8() + ']';
+        } else {
+            uri += host.toUtf8();
+        }
+        uri += ':' + port.toUtf8();
+        if (!plugin.isEmpty()) {
+            QString value = pluginOpts.isEmpty() ? plugin : plugin + QChar(';') + pluginOpts;
+            uri += "/?plugin=" + value.toUtf8().toPercentEncoding();
+        }
+    }
+    if (!remark.isEmpty()) {
+        uri += '#' + remark.toUtf8().toPercentEncoding();
+    }
+    return uri;
+}
@@ -0,0 +1,72 @@
+/*
+ * SS URI Class
+ *
+ * Parses and builds ss:// URIs in both formats:
+ *   legacy  ss://BASE64(method:password@host:port)#remark
+ *   SIP002  ss://BASE64URL(method:password)@host:port/?plugin=name%3Bopts#remark
+ * Parsing is a single pass over the bytes. The fields are spans into the
+ * input, or into a decode buffer inside the object that only goes to the
+ * heap for URIs longer than InlineSize, so validating costs no allocation.
+ */
+#ifndef SSURI_H
+#define SSURI_H
+#include <QByteArray>
+#include <QString>
+
+class SSUri
+{
+public:
+    struct Span
+    {
+        const char *data;
+        int size;
+
+        Span() : data(0), size(0) {}
+        Span(const char *d, int s) : data(d), size(s) {}
+        inline bool isEmpty() const { return size == 0; }
+        inline QString toString() const { return QString::fromUtf8(data, size); }
+    };
+
+    enum Format {
+        Legacy,
+        Sip002
+    };
+
+    SSUri();
+    bool parse(const char *begin, const char *end);
+    inline bool parse(const QByteArray &uri) { return parse(uri.constData(), uri.constData() + uri.size()); }
+
+    Format format;
+    Span method;
+    Span password;
+    Span host;//without the brackets of an IPv6 literal
+    Span port;
+    Span plugin;
+    Span pluginOpts;
+    Span remark;
+    quint16 portNumber;
+
+    /*
+     * Legacy can't carry a plugin, so a plugin forces SIP002.
+     * An empty remark is left out.
+     */
+    static QByteArray build(Format format, const QString &method, const QString &password, const QString &host, const QString &port,
+                            const QString &plugin = QString(), const QString &pluginOpts = QString(), const QString &remark = QString());
+
+    static const int InlineSize = 512;
+
+private:
+    Q_DISABLE_COPY(SSUri)
+
+    char m_inline[InlineSize];
+    QByteArray m_heap;
+    char *m_out;//next free byte of the decode buffer
+
+    Span percentDecode(const char *b, const char *e);
+    Span base64Decode(const char *b, const char *e);//both alphabets, padding optional
+    bool splitUserInfo(Span info);
+    bool splitHostPort(const char *b, const char *e);
+    bool parseQuery(const char *b, const char *e);
+};
+
+#endif // SSURI_H
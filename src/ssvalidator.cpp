@@ -1,45 +1,17 @@
 #include "ssvalidator.h"
+#include "ssuri.h"
 
-const QStringList SSValidator::supportedMethod = QStringList() << "Table" << "RC4" << "RC4-MD5" << "AES-128-CFB" << "AES-192-CFB" << "AES-256-CFB" << "BF-CFB" << "CAMELLIA-128-CFB" << "CAMELLIA-192-CFB" << "CAMELLIA-256-CFB" << "CAST5-CFB" << "DES-CFB" << "IDEA-CFB" << "RC2-CFB" << "SEED-CFB";
+//only backends run these, the built-in server and mux mode know the stream ciphers alone
+const QStringList SSValidator::aeadMethod = QStringList() << "AES-128-GCM" << "AES-192-GCM" << "AES-256-GCM" << "CHACHA20-IETF-POLY1305" << "XCHACHA20-IETF-POLY1305";
+const QStringList SSValidator::supportedMethod = QStringList() << "Table" << "RC4" << "RC4-MD5" << "AES-128-CFB" << "AES-192-CFB" << "AES-256-CFB" << "BF-CFB" << "CAMELLIA-128-CFB" << "CAMELLIA-192-CFB" << "CAMELLIA-256-CFB" << "CAST5-CFB" << "DES-CFB" << "IDEA-CFB" << "RC2-CFB" << "SEED-CFB" << aeadMethod;
 
 SSValidator::SSValidator()
 {}
 
-bool SSValidator::validate(QString input)
+bool SSValidator::validate(const QByteArray &uri)
 {
-    //must begin with ss:// to distinguish from random base64 encoded strings
-    if (input.startsWith("ss://")) {
-        input.remove(0, 5);
-        QString decode(QByteArray::fromBase64(QByteArray(input.toStdString().c_str())));
-        QStringList decList = decode.split(':');
-        if (decList.size() < 3) {
-            return false;
-        }
-
-        //Validate Method
-        QString method = decList.first();
-        if (!validateMethod(method)) {
-            return false;
-        }
-
-        //Validate Port
-        QString port = decList.last();
-        if (!validatePort(port)) {
-            return false;
-        }
-
-        //Validate whether server and password exist
-        QStringList pwdServer = decList.at(1).split('@');
-        if (pwdServer.size() < 2) {
-            return false;
-        }
-
-        //it seems acceptable now
-        return true;
-    }
-    else {
-        return false;
-    }
+    SSUri parsed;
+    return parsed.parse(uri) && validateMethod(parsed.method.data, parsed.method.size);
 }
 
 bool SSValidator::validatePort(const QString &port)
@@ -57,3 +29,19 @@ bool SSValidator::validateMethod(const QString &method)
 {
     return supportedMethod.contains(method, Qt::CaseInsensitive);
 }
+
+bool SSValidator::isAead(const QString &method)
+{
+    return aeadMethod.contains(method, Qt::CaseInsensitive);
+}
+
+bool SSValidator::validateMethod(const char *method, int size)
+{
+    QLatin1String m(method, size);
+    for (QStringList::const_iterator it = supportedMethod.constBegin(); it != supportedMethod.constEnd(); ++it) {
+        if (it->compare(m, Qt::CaseInsensitive) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
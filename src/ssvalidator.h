@@ -12,9 +12,12 @@ class SSValidator
 {
 public:
     SSValidator();
-    static bool validate(QString input);
+    static bool validate(const QByteArray &uri);//no allocation, the caller converts to UTF-8 once
     static bool validatePort(const QString &port);
     static bool validateMethod(const QString &method);
+    static bool validateMethod(const char *method, int size);//no allocation, for SSUri spans
+    static bool isAead(const QString &method);
+    static const QStringList aeadMethod;
     static const QStringList supportedMethod;
 };
 
@@ -0,0 +1,36 @@
+#include <QDebug>
+#include "tracer.h"
+#include "startuptimer.h"
+
+QElapsedTimer StartupTimer::s_timer;
+qint64 StartupTimer::s_lastUs = 0;
+bool StartupTimer::s_verbose = false;
+
+void StartupTimer::start()
+{
+    s_timer.start();
+    s_lastUs = 0;
+}
+
+void StartupTimer::setVerbose(bool verbose)
+{
+    s_verbose = verbose;
+}
+
+void StartupTimer::mark(const char *phase)
+{
+    if (!s_timer.isValid()) {
+        return;
+    }
+    qint64 nowUs = s_timer.nsecsElapsed() / 1000;
+    qint64 durationUs = nowUs - s_lastUs;
+    s_lastUs = nowUs;
+
+    if (s_verbose) {
+        qDebug("startup: %-22s %7.2f ms (%.2f ms since exec)", phase, durationUs / 1000.0, nowUs / 1000.0);
+    }
+    if (Q_UNLIKELY(Tracer::isEnabled())) {//phases before --trace was parsed start at 0
+        qint64 end = Tracer::now();
+        Tracer::complete(phase, "startup", qMax(Q_INT64_C(0), end - durationUs), qMin(durationUs, end));
+    }
+}
@@ -0,0 +1,26 @@
+/*
+ * Startup Timer Class
+ *
+ * Measures the phases of a cold start. With -v, every phase is printed as
+ * it ends; with --trace, it is recorded as a span as well.
+ * Phase names must be string literals, like the tracer's.
+ */
+#ifndef STARTUPTIMER_H
+#define STARTUPTIMER_H
+#include <QElapsedTimer>
+
+class StartupTimer
+{
+public:
+    static void start();//first thing in main()
+    static void setVerbose(bool verbose);
+    static void mark(const char *phase);
+    static inline qint64 elapsed() { return s_timer.elapsed(); }
+
+private:
+    static QElapsedTimer s_timer;
+    static qint64 s_lastUs;
+    static bool s_verbose;
+};
+
+#endif // STARTUPTIMER_H
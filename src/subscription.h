@@ -0,0 +1,23 @@
+/*
+ * A server list published by a provider, either at an http(s) URL or in a
+ * local file: ss:// URIs one per line, usually base64 encoded as a whole.
+ * Profiles imported from it carry its name as their tag.
+ */
+#ifndef SUBSCRIPTION_H
+#define SUBSCRIPTION_H
+#include <QString>
+#include <QList>
+
+struct Subscription
+{
+    QString name;
+    QString url;
+    int intervalHours;//0 refreshes on demand only
+    qint64 lastUpdateMSecs;//since epoch, 0 if never
+
+    Subscription() : intervalHours(24), lastUpdateMSecs(0) {}
+};
+
+typedef QList<Subscription> SubscriptionList;
+
+#endif // SUBSCRIPTION_H
@@ -0,0 +1,108 @@
+#include <QDateTime>
+#include "subscriptiondialogue.h"
+#include "ui_subscriptiondialogue.h"
+
+SubscriptionDialogue::SubscriptionDialogue(Configuration *conf, SubscriptionManager *manager, QWidget *parent) :
+    QDialog(parent),
+    ui(new Ui::SubscriptionDialogue),
+    m_conf(conf),
+    m_manager(manager)
+{
+    ui->setupUi(this);
+    ui->addButton->setEnabled(false);
+    reloadTable();
+
+    connect(ui->nameEdit, &QLineEdit::textChanged, this, &SubscriptionDialogue::onInputChanged);
+    connect(ui->urlEdit, &QLineEdit::textChanged, this, &SubscriptionDialogue::onInputChanged);
+    connect(ui->addButton, &QPushButton::clicked, this, &SubscriptionDialogue::onAddButtonClicked);
+    connect(ui->removeButton, &QPushButton::clicked, this, &SubscriptionDialogue::onRemoveButtonClicked);
+    connect(ui->refreshButton, &QPushButton::clicked, this, &SubscriptionDialogue::onRefreshButtonClicked);
+    connect(ui->buttonBox, &QDialogButtonBox::rejected, this, &SubscriptionDialogue::reject);
+    connect(m_manager, &SubscriptionManager::refreshed, this, &SubscriptionDialogue::onRefreshed);
+    connect(m_manager, &SubscriptionManager::failed, this, &SubscriptionDialogue::onFailed);
+}
+
+SubscriptionDialogue::~SubscriptionDialogue()
+{
+    delete ui;
+}
+
+void SubscriptionDialogue::reloadTable()
+{
+    const SubscriptionList &list = m_conf->subscriptionList();
+    ui->subscriptionTable->setRowCount(list.size());
+    for (int row = 0; row < list.size(); ++row) {
+        const Subscription &sub = list.at(row);
+        QString interval = sub.intervalHours > 0 ? tr("%1 h").arg(sub.intervalHours) : tr("Manual");
+        QString last = sub.lastUpdateMSecs > 0 ? QDateTime::fromMSecsSinceEpoch(sub.lastUpdateMSecs).toString(Qt::SystemLocaleShortDate) : tr("Never");
+        if (m_manager->isRefreshing(sub.name)) {
+            last = tr("Updating...");
+        }
+        ui->subscriptionTable->setItem(row, 0, new QTableWidgetItem(sub.name));
+        ui->subscriptionTable->setItem(row, 1, new QTableWidgetItem(sub.url));
+        ui->subscriptionTable->setItem(row, 2, new QTableWidgetItem(interval));
+        ui->subscriptionTable->setItem(row, 3, new QTableWidgetItem(last));
+    }
+}
+
+void SubscriptionDialogue::onInputChanged()
+{
+    QString name = ui->nameEdit->text().trimmed();
+    bool taken = false;
+    const SubscriptionList &list = m_conf->subscriptionList();
+    for (SubscriptionList::const_iterator it = list.constBegin(); it != list.constEnd(); ++it) {
+        taken = taken || it->name == name;
+    }
+    ui->addButton->setEnabled(!name.isEmpty() && !taken && !ui->urlEdit->text().trimmed().isEmpty());
+}
+
+void SubscriptionDialogue::onAddButtonClicked()
+{
+    Subscription sub;
+    sub.name = ui->nameEdit->text().trimmed();
+    sub.url = ui->urlEdit->text().trimmed();
+    sub.intervalHours = ui->intervalSpinBox->value();
+    m_conf->subscriptionList().append(sub);
+    ui->nameEdit->clear();
+    ui->urlEdit->clear();
+
+    m_manager->refresh(sub.name);
+    reloadTable();
+    emit subscriptionsEdited();
+}
+
+void SubscriptionDialogue::onRemoveButtonClicked()
+{
+    int row = ui->subscriptionTable->currentRow();
+    if (row < 0 || row >= m_conf->subscriptionList().size()) {
+        return;
+    }
+    //the imported profiles stay, they simply won't be refreshed any more
+    m_conf->subscriptionList().removeAt(row);
+    reloadTable();
+    emit subscriptionsEdited();
+}
+
+void SubscriptionDialogue::onRefreshButtonClicked()
+{
+    int row = ui->subscriptionTable->currentRow();
+    const SubscriptionList &list = m_conf->subscriptionList();
+    for (int i = 0; i < list.size(); ++i) {
+        if (row < 0 || row == i) {//nothing selected means all of them
+            m_manager->refresh(list.at(i).name);
+        }
+    }
+    reloadTable();
+}
+
+void SubscriptionDialogue::onRefreshed(const QString &name, int added, int updated, int removed, int invalid)
+{
+    ui->statusLabel->setText(tr("%1: %2 added, %3 updated, %4 removed, %5 invalid").arg(name).arg(added).arg(updated).arg(removed).arg(invalid));
+    reloadTable();
+}
+
+void SubscriptionDialogue::onFailed(const QString &name, const QString &error)
+{
+    ui->statusLabel->setText(tr("%1: %2").arg(name).arg(error));
+    reloadTable();
+}
@@ -0,0 +1,39 @@
+#ifndef SUBSCRIPTIONDIALOGUE_H
+#define SUBSCRIPTIONDIALOGUE_H
+
+#include <QDialog>
+#include "configuration.h"
+#include "subscriptionmanager.h"
+
+namespace Ui {
+class SubscriptionDialogue;
+}
+
+class SubscriptionDialogue : public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit SubscriptionDialogue(Configuration *conf, SubscriptionManager *manager, QWidget *parent = 0);
+    ~SubscriptionDialogue();
+
+signals:
+    void subscriptionsEdited();
+
+private:
+    Ui::SubscriptionDialogue *ui;
+    Configuration *m_conf;
+    SubscriptionManager *m_manager;
+
+    void reloadTable();
+
+private slots:
+    void onAddButtonClicked();
+    void onRemoveButtonClicked();
+    void onRefreshButtonClicked();
+    void onInputChanged();
+    void onRefreshed(const QString &name, int added, int updated, int removed, int invalid);
+    void onFailed(const QString &name, const QString &error);
+};
+
+#endif // SUBSCRIPTIONDIALOGUE_H
@@ -0,0 +1,204 @@
+#include <QFile>
+#include <QUrl>
+#include <QDateTime>
+#include <QHash>
+#include <QNetworkRequest>
+#include <QNetworkReply>
+#include <QFutureWatcher>
+#include <QtConcurrent>
+#include <algorithm>
+#include "subscriptionmanager.h"
+
+const int SubscriptionManager::ScheduleCheckMSecs = 60 * 1000;
+
+SubscriptionManager::SubscriptionManager(Configuration *conf, QObject *parent) :
+    QObject(parent),
+    m_conf(conf)
+{
+    connect(&m_nam, &QNetworkAccessManager::finished, this, &SubscriptionManager::onReplyFinished);
+    connect(&m_schedule, &QTimer::timeout, this, &SubscriptionManager::refreshDue);
+    m_schedule.start(ScheduleCheckMSecs);
+    QTimer::singleShot(0, this, SLOT(refreshDue()));//whatever fell due while ss-qt5 wasn't running
+}
+
+Subscription *SubscriptionManager::find(const QString &name)
+{
+    SubscriptionList &list = m_conf->subscriptionList();
+    for (SubscriptionList::iterator it = list.begin(); it != list.end(); ++it) {
+        if (it->name == name) {
+            return &(*it);
+        }
+    }
+    return 0;
+}
+
+void SubscriptionManager::refreshDue()
+{
+    qint64 now = QDateTime::currentMSecsSinceEpoch();
+    const SubscriptionList &list = m_conf->subscriptionList();
+    for (SubscriptionList::const_iterator it = list.constBegin(); it != list.constEnd(); ++it) {
+        if (it->intervalHours > 0 && now - it->lastUpdateMSecs >= qint64(it->intervalHours) * 3600 * 1000) {
+            refresh(it->name);
+        }
+    }
+}
+
+void SubscriptionManager::refresh(const QString &name)
+{
+    Subscription *sub = find(name);
+    if (!sub || m_pending.contains(name)) {
+        return;
+    }
+
+    QUrl url = QUrl::fromUserInput(sub->url);
+    if (url.isLocalFile()) {
+        QFile file(url.toLocalFile());
+        if (!file.open(QIODevice::ReadOnly)) {
+            emit failed(name, file.errorString());
+            return;
+        }
+        m_pending.insert(name);
+        decodeAll(name, file.readAll());
+        return;
+    }
+
+    m_pending.insert(name);
+    QNetworkRequest request(url);
+#if QT_VERSION >= QT_VERSION_CHECK(5, 6, 0)
+    request.setAttribute(QNetworkRequest::FollowRedirectsAttribute, true);
+#endif
+    QNetworkReply *reply = m_nam.get(request);
+    reply->setProperty("subscription", name);
+}
+
+void SubscriptionManager::onReplyFinished(QNetworkReply *reply)
+{
+    reply->deleteLater();
+    QString name = reply->property("subscription").toString();
+    if (reply->error() != QNetworkReply::NoError) {
+        m_pending.remove(name);
+        emit failed(name, reply->errorString());
+        return;
+    }
+    decodeAll(name, reply->readAll());
+}
+
+QVector<QByteArray> SubscriptionManager::splitBody(const QByteArray &body)
+{
+    QByteArray text = body.trimmed();
+    if (!text.contains("://")) {//the whole list is base64 encoded, often the URL-safe way
+        text.replace('-', '+').replace('_', '/');
+        text = QByteArray::fromBase64(text);
+    }
+
+    QVector<QByteArray> lines;
+    QList<QByteArray> raw = text.split('\n');
+    lines.reserve(raw.size());
+    for (QList<QByteArray>::const_iterator it = raw.constBegin(); it != raw.constEnd(); ++it) {
+        QByteArray line = it->trimmed();
+        if (!line.isEmpty()) {
+            lines.append(line);
+        }
+    }
+    return lines;
+}
+
+SubscriptionManager::Entry SubscriptionManager::decode(const QByteArray &line)
+{
+    Entry e;
+    e.valid = SSProfile::fromSsUrl(line, &e.profile);
+    //a plugin is a program to run, so the provider's choice waits for the user's
+    e.profile.plugin_trusted = e.profile.plugin.isEmpty();
+    return e;
+}
+
+void SubscriptionManager::decodeAll(const QString &name, const QByteArray &body)
+{
+    QFutureWatcher<Entry> *watcher = new QFutureWatcher<Entry>(this);
+    connect(watcher, &QFutureWatcher<Entry>::finished, [this, watcher, name] {
+        watcher->deleteLater();
+        merge(name, watcher->future().results().toVector());
+    });
+    //splitting is cheap, decoding and validating is what runs in parallel
+    watcher->setFuture(QtConcurrent::mapped(splitBody(body), &SubscriptionManager::decode));
+}
+
+void SubscriptionManager::merge(const QString &name, const QVector<Entry> &entries)
+{
+    m_pending.remove(name);
+    Subscription *sub = find(name);
+    if (!sub) {//deleted while we were fetching
+        return;
+    }
+
+    ProfileStore *store = m_conf->profileStore();
+    //a provider may list one server:port more than once, duplicates are matched in order
+    QHash<QString, ProfileId> previous;//find() returns the last inserted, so walk backwards
+    QVector<ProfileId> tagged = store->findByTag(name);
+    std::sort(tagged.begin(), tagged.end(), [store](ProfileId a, ProfileId b) { return store->rowOf(a) < store->rowOf(b); });
+    for (int i = tagged.size() - 1; i >= 0; --i) {
+        const SSProfile *p = store->header(tagged.at(i));
+        previous.insertMulti(p->server.toLower() + QChar(':') + p->server_port, tagged.at(i));
+    }
+
+    int valid = 0, invalid = 0;
+    for (QVector<Entry>::const_iterator it = entries.constBegin(); it != entries.constEnd(); ++it) {
+        it->valid ? ++valid : ++invalid;
+    }
+    //a captive portal or an error page decodes to (almost) nothing, that mustn't empty the subscription
+    if (valid == 0) {
+        emit failed(name, tr("No valid server in the subscription"));
+        return;
+    }
+    if (invalid > valid) {
+        emit failed(name, tr("Most entries are invalid (%1 of %2), the subscription was left unchanged").arg(invalid).arg(entries.size()));
+        return;
+    }
+
+    int added = 0, updated = 0, removed = 0;
+    for (QVector<Entry>::const_iterator it = entries.constBegin(); it != entries.constEnd(); ++it) {
+        if (!it->valid) {
+            continue;
+        }
+        const SSProfile &fresh = it->profile;
+        QString key = fresh.server.toLower() + QChar(':') + fresh.server_port;
+        QHash<QString, ProfileId>::iterator match = previous.find(key);
+        if (match == previous.end()) {
+            SSProfile p = fresh;
+            p.tag = name;
+            store->append(p);
+            ++added;
+            continue;
+        }
+        ProfileId id = match.value();
+        previous.erase(match);
+
+        //take everything the provider describes, local settings stay ours
+        SSProfile *p = store->profile(id);
+        bool pluginChanged = p->plugin != fresh.plugin || p->plugin_opts != fresh.plugin_opts;
+        if (pluginChanged || p->password != fresh.password || p->method != fresh.method || p->profileName != fresh.profileName || p->server != fresh.server) {
+            p->password = fresh.password;
+            p->method = fresh.method;
+            p->profileName = fresh.profileName;
+            p->server = fresh.server;
+            if (pluginChanged) {//a different program needs a new confirmation
+                p->plugin = fresh.plugin;
+                p->plugin_opts = fresh.plugin_opts;
+                p->plugin_trusted = fresh.plugin_trusted;
+            }
+            store->update(id);
+            ++updated;
+        }
+    }
+
+    //whatever the provider no longer lists goes, except the profile in use
+    for (QHash<QString, ProfileId>::const_iterator it = previous.constBegin(); it != previous.constEnd(); ++it) {
+        if (it.value() != m_conf->currentId()) {
+            store->remove(it.value());
+            ++removed;
+        }
+    }
+
+    sub->lastUpdateMSecs = QDateTime::currentMSecsSinceEpoch();
+    emit refreshed(name, added, updated, removed, invalid);
+}
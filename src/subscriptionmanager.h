@@ -0,0 +1,63 @@
+/*
+ * Subscription Manager Class
+ *
+ * Downloads subscriptions, decodes and validates their entries on the
+ * thread pool, and merges the result into the profile store.
+ * A profile is recognized across refreshes by its server and port, so a
+ * refresh only touches the profiles that changed and keeps local settings
+ * such as the backend or the local port.
+ */
+#ifndef SUBSCRIPTIONMANAGER_H
+#define SUBSCRIPTIONMANAGER_H
+#include <QObject>
+#include <QTimer>
+#include <QSet>
+#include <QVector>
+#include <QByteArray>
+#include <QNetworkAccessManager>
+#include "configuration.h"
+
+class QNetworkReply;
+
+class SubscriptionManager : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Entry
+    {
+        SSProfile profile;
+        bool valid;
+
+        Entry() : valid(false) {}
+    };
+
+    SubscriptionManager(Configuration *conf, QObject *parent = 0);
+    void refresh(const QString &name);
+    inline bool isRefreshing(const QString &name) const { return m_pending.contains(name); }
+
+    static QVector<QByteArray> splitBody(const QByteArray &body);
+    static Entry decode(const QByteArray &line);
+
+    static const int ScheduleCheckMSecs;
+
+signals:
+    void refreshed(const QString &name, int added, int updated, int removed, int invalid);
+    void failed(const QString &name, const QString &error);
+
+private:
+    Configuration *m_conf;
+    QNetworkAccessManager m_nam;
+    QTimer m_schedule;
+    QSet<QString> m_pending;
+
+    Subscription *find(const QString &name);
+    void decodeAll(const QString &name, const QByteArray &body);
+    void merge(const QString &name, const QVector<Entry> &entries);
+
+private slots:
+    void refreshDue();
+    void onReplyFinished(QNetworkReply *reply);
+};
+
+#endif // SUBSCRIPTIONMANAGER_H
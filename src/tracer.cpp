@@ -0,0 +1,147 @@
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QList>
+#include <QFile>
+#include <QTextStream>
+#include <QThread>
+#include <QCoreApplication>
+#include <atomic>
+#include "tracer.h"
+
+bool Tracer::enabled = false;
+
+namespace {
+
+struct TraceEvent
+{
+    const char *name;
+    const char *category;
+    qint64 ts;
+    qint64 dur;//-1 for instant events
+    quint64 id;
+};
+
+/*
+ * Written by its own thread only. Events are published by a release store
+ * of the count, so a dump running concurrently sees complete events only.
+ * A full buffer drops new events instead of wrapping around.
+ */
+struct ThreadBuffer
+{
+    static const int Capacity = 1 << 16;
+
+    TraceEvent events[Capacity];
+    std::atomic<int> count;
+    std::atomic<quint64> dropped;
+    int tid;
+    QString threadName;
+
+    ThreadBuffer() : count(0), dropped(0), tid(0) {}
+
+    void append(const TraceEvent &e)
+    {
+        int n = count.load(std::memory_order_relaxed);
+        if (n >= Capacity) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        events[n] = e;
+        count.store(n + 1, std::memory_order_release);
+    }
+};
+
+QElapsedTimer clock;
+QMutex registryMutex;
+QList<ThreadBuffer *> registry;//buffers live until the process exits, a dump may outlive their threads
+thread_local ThreadBuffer *localBuffer = 0;
+
+ThreadBuffer *buffer()
+{
+    if (Q_UNLIKELY(!localBuffer)) {
+        localBuffer = new ThreadBuffer;
+        QThread *t = QThread::currentThread();
+        localBuffer->threadName = t->objectName().isEmpty() ? QString(t->metaObject()->className()) : t->objectName();
+        if (QCoreApplication::instance() && t == QCoreApplication::instance()->thread()) {
+            localBuffer->threadName = "main";
+        }
+        QMutexLocker locker(&registryMutex);
+        localBuffer->tid = registry.size() + 1;
+        registry.append(localBuffer);
+    }
+    return localBuffer;
+}
+
+}
+
+void Tracer::enable()
+{
+    clock.start();
+    enabled = true;
+}
+
+qint64 Tracer::now()
+{
+    return clock.nsecsElapsed() / 1000;
+}
+
+void Tracer::complete(const char *name, const char *category, qint64 startUs, qint64 durationUs, quint64 id)
+{
+    if (!enabled) {
+        return;
+    }
+    TraceEvent e = { name, category, startUs, durationUs, id };
+    buffer()->append(e);
+}
+
+void Tracer::instant(const char *name, const char *category, quint64 id)
+{
+    if (!enabled) {
+        return;
+    }
+    TraceEvent e = { name, category, now(), -1, id };
+    buffer()->append(e);
+}
+
+bool Tracer::dump(const QString &file)
+{
+    QFile out(file);
+    if (!out.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return false;
+    }
+
+    QTextStream s(&out);
+    const qint64 pid = QCoreApplication::applicationPid();
+    s << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+    QMutexLocker locker(&registryMutex);
+    bool first = true;
+    for (QList<ThreadBuffer *>::const_iterator b = registry.constBegin(); b != registry.constEnd(); ++b) {
+        ThreadBuffer *buf = *b;
+        s << (first ? "" : ",\n");
+        first = false;
+        s << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << pid << ",\"tid\":" << buf->tid
+          << ",\"args\":{\"name\":\"" << buf->threadName << "\"}}";
+
+        int n = buf->count.load(std::memory_order_acquire);
+        for (int i = 0; i < n; ++i) {
+            const TraceEvent &e = buf->events[i];
+            s << ",\n{\"name\":\"" << e.name << "\",\"cat\":\"" << e.category << "\",\"pid\":" << pid << ",\"tid\":" << buf->tid << ",\"ts\":" << e.ts;
+            if (e.dur >= 0) {
+                s << ",\"ph\":\"X\",\"dur\":" << e.dur;
+            }
+            else {
+                s << ",\"ph\":\"i\",\"s\":\"t\"";
+            }
+            if (e.id) {
+                s << ",\"args\":{\"id\":" << e.id << "}";
+            }
+            s << "}";
+        }
+        quint64 dropped = buf->dropped.load(std::memory_order_relaxed);
+        if (dropped) {
+            s << ",\n{\"name\":\"dropped events\",\"ph\":\"C\",\"pid\":" << pid << ",\"tid\":" << buf->tid << ",\"ts\":" << now() << ",\"args\":{\"dropped\":" << dropped << "}}";
+        }
+    }
+    s << "\n]}\n";
+    return true;
+}
@@ -0,0 +1,53 @@
+/*
+ * Tracer Class
+ *
+ * Opt-in recorder of spans in Chrome's trace_event format, viewable in
+ * chrome://tracing or Perfetto.
+ * Every thread appends to its own fixed-size buffer without locking; the
+ * buffers are only walked when the trace is dumped. Event names must be
+ * string literals, nothing is copied while recording.
+ * When tracing is off, every probe costs a single branch on a static bool.
+ */
+#ifndef TRACER_H
+#define TRACER_H
+#include <QtGlobal>
+#include <QString>
+
+class Tracer
+{
+public:
+    static inline bool isEnabled() { return enabled; }
+    static void enable();
+    static qint64 now();//microseconds since tracing was enabled
+
+    static void complete(const char *name, const char *category, qint64 startUs, qint64 durationUs, quint64 id = 0);
+    static void instant(const char *name, const char *category, quint64 id = 0);
+    static bool dump(const QString &file);
+
+private:
+    static bool enabled;
+};
+
+class TraceScope
+{
+public:
+    inline TraceScope(const char *name, const char *category) :
+        m_name(name), m_category(category), m_start(Q_UNLIKELY(Tracer::isEnabled()) ? Tracer::now() : -1) {}
+    inline ~TraceScope()
+    {
+        if (Q_UNLIKELY(m_start >= 0)) {
+            Tracer::complete(m_name, m_category, m_start, Tracer::now() - m_start);
+        }
+    }
+
+private:
+    const char *m_name;
+    const char *m_category;
+    qint64 m_start;
+};
+
+#define SS_TRACE_CONCAT_(a, b) a##b
+#define SS_TRACE_CONCAT(a, b) SS_TRACE_CONCAT_(a, b)
+#define SS_TRACE_SCOPE(name, category) TraceScope SS_TRACE_CONCAT(traceScope_, __LINE__)(name, category)
+
+#endif // TRACER_H
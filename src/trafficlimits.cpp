@@ -0,0 +1,46 @@
+#include "trafficlimits.h"
+
+TrafficLimits::TrafficLimits() :
+    rate(0),
+    clientRate(0),
+    maxSessions(0)
+{}
+
+bool TrafficLimits::operator==(const TrafficLimits &o) const
+{
+    return rate == o.rate && clientRate == o.clientRate && maxSessions == o.maxSessions;
+}
+
+TrafficLimits TrafficLimits::fromJson(const QJsonObject &json)
+{
+    TrafficLimits l;
+    l.rate = qMax(qint64(0), qint64(json["rate"].toDouble()));
+    l.clientRate = qMax(qint64(0), qint64(json["client_rate"].toDouble()));
+    l.maxSessions = qMax(0, json["max_sessions"].toInt());
+    return l;
+}
+
+QJsonObject TrafficLimits::toJson() const
+{
+    QJsonObject json;
+    if (rate > 0) {
+        json["rate"] = QJsonValue(double(rate));
+    }
+    if (clientRate > 0) {
+        json["client_rate"] = QJsonValue(double(clientRate));
+    }
+    if (maxSessions > 0) {
+        json["max_sessions"] = QJsonValue(maxSessions);
+    }
+    return json;
+}
+
+QDataStream &operator<<(QDataStream &s, const TrafficLimits &l)
+{
+    return s << l.rate << l.clientRate << l.maxSessions;
+}
+
+QDataStream &operator>>(QDataStream &s, TrafficLimits &l)
+{
+    return s >> l.rate >> l.clientRate >> l.maxSessions;
+}
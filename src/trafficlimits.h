@@ -0,0 +1,33 @@
+/*
+ * Traffic Limits Class
+ *
+ * The per-profile limits of gui-config.json's "limits", enforced by the
+ * relay on the local side: a rate for the whole profile, a rate for each
+ * client address and a maximum number of concurrent sessions. Rates are in
+ * bytes per second and apply to each direction; 0 means no limit.
+ */
+#ifndef TRAFFICLIMITS_H
+#define TRAFFICLIMITS_H
+#include <QJsonObject>
+#include <QDataStream>
+
+struct TrafficLimits
+{
+    qint64 rate;
+    qint64 clientRate;
+    int maxSessions;
+
+    TrafficLimits();
+    inline bool isDefault() const { return rate == 0 && clientRate == 0 && maxSessions == 0; }
+    inline bool isShaping() const { return rate > 0 || clientRate > 0; }
+    bool operator==(const TrafficLimits &o) const;
+    inline bool operator!=(const TrafficLimits &o) const { return !(*this == o); }
+
+    static TrafficLimits fromJson(const QJsonObject &json);
+    QJsonObject toJson() const;
+};
+
+QDataStream &operator<<(QDataStream &s, const TrafficLimits &l);
+QDataStream &operator>>(QDataStream &s, TrafficLimits &l);
+
+#endif // TRAFFICLIMITS_H
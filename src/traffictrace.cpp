@@ -0,0 +1,210 @@
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QFile>
+#include <QHash>
+#include <QDateTime>
+#include <QCoreApplication>
+#include <algorithm>
+#include "traffictrace.h"
+
+bool TrafficTrace::enabled = false;
+
+namespace {
+
+const char Magic[] = "SSTRACE";
+const int MagicSize = 7;
+const int HeaderSize = MagicSize + 1 + 8;
+const quint64 SessionMask = (quint64(1) << 48) - 1;//drops the worker index from session ids
+
+QElapsedTimer clock;
+QMutex fileMutex;
+QFile *traceFile = 0;
+
+bool openedEarlier(const TrafficTrace::Session &a, const TrafficTrace::Session &b)
+{
+    return a.openUs < b.openUs;
+}
+
+}
+
+bool TrafficTrace::start(const QString &file)
+{
+    QMutexLocker locker(&fileMutex);
+    if (traceFile) {
+        return false;
+    }
+    QFile *f = new QFile(file);
+    if (!f->open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        delete f;
+        return false;
+    }
+
+    QByteArray header(Magic, MagicSize);
+    header.append(char(Version));
+    quint64 startMSecs = QDateTime::currentMSecsSinceEpoch();
+    for (int i = 0; i < 8; ++i) {
+        header.append(char(startMSecs >> (8 * i)));
+    }
+    f->write(header);
+    traceFile = f;
+    clock.start();
+    enabled = true;
+
+    //the relay workers flush their last block when they are destroyed, before this runs
+    qAddPostRoutine(&TrafficTrace::stop);
+    return true;
+}
+
+void TrafficTrace::stop()
+{
+    QMutexLocker locker(&fileMutex);
+    enabled = false;
+    if (traceFile) {
+        traceFile->close();
+        delete traceFile;
+        traceFile = 0;
+    }
+}
+
+qint64 TrafficTrace::now()
+{
+    return clock.nsecsElapsed() / 1000;
+}
+
+void TrafficTrace::writeBlock(const QByteArray &block)
+{
+    QByteArray length;
+    appendVarint(length, block.size());
+    QMutexLocker locker(&fileMutex);
+    if (traceFile) {
+        traceFile->write(length);
+        traceFile->write(block);
+    }
+}
+
+void TrafficTrace::appendVarint(QByteArray &out, quint64 v)
+{
+    while (v >= 0x80) {
+        out.append(char((v & 0x7f) | 0x80));
+        v >>= 7;
+    }
+    out.append(char(v));
+}
+
+bool TrafficTrace::readVarint(const uchar *&p, const uchar *end, quint64 *v)
+{
+    quint64 result = 0;
+    for (int shift = 0; p < end && shift < 64; shift += 7) {
+        uchar b = *p++;
+        result |= quint64(b & 0x7f) << shift;
+        if (!(b & 0x80)) {
+            *v = result;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool TrafficTrace::load(const QString &file, QVector<Session> *sessions, QString *error)
+{
+    QFile f(file);
+    if (!f.open(QIODevice::ReadOnly)) {
+        *error = f.errorString();
+        return false;
+    }
+    QByteArray data = f.readAll();
+    if (data.size() < HeaderSize || !data.startsWith(QByteArray(Magic, MagicSize))) {
+        *error = QString("not a traffic trace");
+        return false;
+    }
+    if (quint8(data.at(MagicSize)) != Version) {
+        *error = QString("unsupported trace version %1").arg(quint8(data.at(MagicSize)));
+        return false;
+    }
+
+    sessions->clear();
+    QHash<quint64, int> index;
+    const uchar *p = reinterpret_cast<const uchar *>(data.constData()) + HeaderSize;
+    const uchar *end = reinterpret_cast<const uchar *>(data.constData()) + data.size();
+    while (p < end) {
+        quint64 length, worker, t;
+        if (!readVarint(p, end, &length) || quint64(end - p) < length) {
+            break;//the recorder was killed in the middle of a block
+        }
+        const uchar *blockEnd = p + length;
+        if (!readVarint(p, blockEnd, &worker) || !readVarint(p, blockEnd, &t)) {
+            *error = QString("corrupt block");
+            return false;
+        }
+
+        while (p < blockEnd) {
+            uchar type = *p++;
+            quint64 gap, local, size = 0;
+            if (type < Open || type > Close || !readVarint(p, blockEnd, &gap) || !readVarint(p, blockEnd, &local)
+                    || ((type == Up || type == Down) && !readVarint(p, blockEnd, &size))) {
+                *error = QString("corrupt record");
+                return false;
+            }
+            t += gap;
+            quint64 key = (worker << 48) | local;
+
+            if (type == Open) {
+                Session s;
+                s.id = key;
+                s.openUs = t;
+                index.insert(key, sessions->size());
+                sessions->append(s);
+                continue;
+            }
+            QHash<quint64, int>::const_iterator it = index.constFind(key);
+            if (it == index.constEnd()) {
+                continue;//opened before the recording started
+            }
+            Session &s = (*sessions)[it.value()];
+            Event e;
+            e.type = EventType(type);
+            e.us = t - s.openUs;
+            e.size = quint32(size);
+            s.events.append(e);
+        }
+    }
+
+    //blocks of different workers are not in time order
+    std::stable_sort(sessions->begin(), sessions->end(), openedEarlier);
+    return true;
+}
+
+TraceBuffer::TraceBuffer(int worker) :
+    m_worker(worker),
+    m_last(0)
+{}
+
+TraceBuffer::~TraceBuffer()
+{
+    flush();
+}
+
+void TraceBuffer::append(TrafficTrace::EventType type, quint64 session, quint32 size)
+{
+    qint64 t = TrafficTrace::now();
+    if (m_block.isEmpty()) {
+        TrafficTrace::appendVarint(m_block, m_worker);
+        TrafficTrace::appendVarint(m_block, t);
+        m_last = t;
+    }
+    m_block.append(char(type));
+    TrafficTrace::appendVarint(m_block, quint64(qMax(Q_INT64_C(0), t - m_last)));
+    m_last = t;
+    TrafficTrace::appendVarint(m_block, session & SessionMask);
+    if (type == TrafficTrace::Up || type == TrafficTrace::Down) {
+        TrafficTrace::appendVarint(m_block, size);
+    }
+}
+
+void TraceBuffer::flush()
+{
+    if (!m_block.isEmpty()) {
+        TrafficTrace::writeBlock(m_block);
+        m_block.resize(0);//keeps the allocation for the next block
+    }
+}
@@ -0,0 +1,90 @@
+/*
+ * Traffic Trace
+ *
+ * Opt-in recorder of the shape of the traffic going through the relay:
+ * when sessions open, when their SOCKS request is answered, the size and
+ * time of every chunk each way, and when they close. No address and no
+ * payload is ever recorded.
+ *
+ * Every relay worker appends to its own TraceBuffer without locking, and
+ * writes it out as one block about once a second. A file is:
+ *   "SSTRACE" version:u8 start:i64le (epoch ms)
+ *   blocks of  length:varint worker:varint base:varint (us since start)
+ *     records of  type:u8 gap:varint (us since the previous record)
+ *                 session:varint [size:varint, Up and Down only]
+ * ss-bench replays such a file, see TrafficTrace::load().
+ */
+#ifndef TRAFFICTRACE_H
+#define TRAFFICTRACE_H
+#include <QString>
+#include <QByteArray>
+#include <QVector>
+
+class TrafficTrace
+{
+public:
+    enum EventType {
+        Open = 1,
+        Connected,//the SOCKS reply
+        Up,
+        Down,
+        Close
+    };
+
+    struct Event
+    {
+        EventType type;
+        qint64 us;//since the session opened
+        quint32 size;
+    };
+
+    struct Session
+    {
+        quint64 id;
+        qint64 openUs;//since the trace started
+        QVector<Event> events;//Connected, Up, Down and Close, in order
+    };
+
+    static inline bool isEnabled() { return enabled; }
+    static bool start(const QString &file);
+    static void stop();
+    static qint64 now();//microseconds since the recording started
+
+    static void writeBlock(const QByteArray &block);
+    static bool load(const QString &file, QVector<Session> *sessions, QString *error);
+
+    static void appendVarint(QByteArray &out, quint64 v);
+    static bool readVarint(const uchar *&p, const uchar *end, quint64 *v);
+
+    static const quint8 Version = 1;
+
+private:
+    static bool enabled;
+};
+
+/*
+ * Belongs to one relay worker and is only touched from its thread.
+ */
+class TraceBuffer
+{
+public:
+    TraceBuffer(int worker);
+    ~TraceBuffer();
+
+    inline void record(TrafficTrace::EventType type, quint64 session, quint32 size = 0)
+    {
+        if (Q_UNLIKELY(TrafficTrace::isEnabled())) {
+            append(type, session, size);
+        }
+    }
+    void flush();
+
+private:
+    int m_worker;
+    QByteArray m_block;
+    qint64 m_last;
+
+    void append(TrafficTrace::EventType type, quint64 session, quint32 size);
+};
+
+#endif // TRAFFICTRACE_H
@@ -0,0 +1,23 @@
+#-------------------------------------------------
+#
+#          log-bench
+#
+#  Micro-benchmark of the log event store's search
+#
+#-------------------------------------------------
+
+QT      += core
+QT      -= gui
+CONFIG  += c++11 console
+CONFIG  -= app_bundle
+
+TARGET   = log-bench
+TEMPLATE = app
+
+SRC = $$PWD/../../src
+INCLUDEPATH += $$SRC
+
+SOURCES += main.cpp \
+           $$SRC/logeventstore.cpp
+
+HEADERS += $$SRC/logeventstore.h
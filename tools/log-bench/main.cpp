@@ -0,0 +1,96 @@
+/*
+ * log-bench
+ *
+ * Fills a LogEventStore with synthetic backend events, a million by
+ * default, and times the searches the log filter of the main window runs:
+ * by type only, by a host that matches one destination, and by a pattern
+ * that matches many. Each search is repeated and the median is reported,
+ * which is what has to stay under 10 ms.
+ */
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QTextStream>
+#include <QVector>
+#include <algorithm>
+#include "logeventstore.h"
+
+static int rounds = 21;
+
+//runs the search a number of times, returns the median in milliseconds and the rows found
+static double measure(const LogEventStore &store, const QString &pattern, int mask, int *rows)
+{
+    QVector<double> msecs;
+    QElapsedTimer timer;
+    for (int i = 0; i < rounds; ++i) {
+        timer.start();
+        *rows = store.search(pattern, mask).size();
+        msecs.append(timer.nsecsElapsed() / 1e6);
+    }
+    std::sort(msecs.begin(), msecs.end());
+    return msecs[msecs.size() / 2];
+}
+
+static void report(QTextStream &out, const QString &search, int rows, double msecs)
+{
+    out << QString("%1 %2 %3\n").arg(search, -24).arg(rows, 10).arg(msecs, 10, 'f', 2);
+    out.flush();
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    a.setApplicationName("log-bench");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Micro-benchmark of log event search.");
+    parser.addHelpOption();
+    QCommandLineOption eventsOption(QStringList() << "n" << "events", "Events in the store.", "count", "1000000");
+    QCommandLineOption hostsOption(QStringList() << "hosts", "Distinct destination hosts.", "count", "20000");
+    QCommandLineOption roundsOption(QStringList() << "r" << "rounds", "Times every search runs.", "count", "21");
+    parser.addOption(eventsOption);
+    parser.addOption(hostsOption);
+    parser.addOption(roundsOption);
+    parser.process(a);
+
+    bool ok1, ok2, ok3;
+    int events = parser.value(eventsOption).toInt(&ok1);
+    int hosts = parser.value(hostsOption).toInt(&ok2);
+    rounds = parser.value(roundsOption).toInt(&ok3);
+    if (!ok1 || !ok2 || !ok3 || events <= 0 || hosts <= 0 || rounds <= 0 || events > LogEventStore::MaxEvents) {
+        QTextStream(stderr) << "Error: invalid arguments\n";
+        parser.showHelp(1);
+    }
+
+    //a skewed mix: most connects go to a few popular hosts, like real browsing
+    LogEventStore store;
+    QElapsedTimer timer;
+    timer.start();
+    quint32 seed = 1;
+    for (int i = 0; i < events; ++i) {
+        seed = seed * 1103515245 + 12345;
+        int h = (seed >> 8) % hosts;
+        h = h % (1 + (seed >> 24) % hosts);
+        LogEventStore::EventType type = (seed & 0xf) == 0 ? LogEventStore::Error : ((seed & 0xf) == 1 ? LogEventStore::Timeout : LogEventStore::Connect);
+        store.append(1500000000000LL + i, type, QString("host%1.example.com").arg(h), 443, QByteArray("connect to host.example.com:443"));
+    }
+
+    QTextStream out(stdout);
+    out << QString("filled %1 events over %2 hosts in %3 ms\n").arg(events).arg(hosts).arg(timer.elapsed());
+    out << QString("%1 %2 %3\n").arg("search", -24).arg("rows", 10).arg("median ms", 10);
+
+    int rows;
+    double msecs = measure(store, QString(), LogEventStore::AllMask, &rows);
+    report(out, "all", rows, msecs);
+    msecs = measure(store, QString(), LogEventStore::ErrorMask, &rows);
+    report(out, "errors", rows, msecs);
+    msecs = measure(store, "host0.example.com", LogEventStore::AllMask, &rows);
+    report(out, "one host", rows, msecs);
+    msecs = measure(store, "host7", LogEventStore::AllMask, &rows);
+    report(out, "some hosts", rows, msecs);
+    msecs = measure(store, "example", LogEventStore::TimeoutMask, &rows);
+    report(out, "all hosts, timeouts", rows, msecs);
+    msecs = measure(store, "no-such-host", LogEventStore::AllMask, &rows);
+    report(out, "no match", rows, msecs);
+    return 0;
+}
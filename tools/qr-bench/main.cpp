@@ -0,0 +1,100 @@
+/*
+ * qr-bench
+ *
+ * Times the three steps of showing a profile's QR code: encoding the URI,
+ * rasterizing the matrix for the widget size, and repainting QRWidget,
+ * both from its cached image and after a resize dropped it.
+ * Runs on the offscreen platform unless QT_QPA_PLATFORM says otherwise.
+ */
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QTextStream>
+#include <QImage>
+#include <functional>
+#include "qrmatrix.h"
+#include "qrwidget.h"
+
+static qint64 durationMSecs = 1000;
+
+//calls f in batches until the duration is up, returns the calls per second
+static double measure(const std::function<void()> &f)
+{
+    const int Batch = 16;
+    qint64 calls = 0;
+    QElapsedTimer timer;
+    timer.start();
+    while (timer.elapsed() < durationMSecs) {
+        for (int i = 0; i < Batch; ++i) {
+            f();
+        }
+        calls += Batch;
+    }
+    return calls / (timer.nsecsElapsed() / 1e9);
+}
+
+static void report(QTextStream &out, const QString &step, const QString &input, double perSecond)
+{
+    out << QString("%1 %2 %3 %4\n").arg(step, -10).arg(input, -14).arg(perSecond, 12, 'f', 0).arg(1e6 / perSecond, 10, 'f', 1);
+    out.flush();
+}
+
+int main(int argc, char *argv[])
+{
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QApplication a(argc, argv);
+    a.setApplicationName("qr-bench");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Micro-benchmark of QR encoding, rasterizing and repainting.");
+    parser.addHelpOption();
+    QCommandLineOption durationOption(QStringList() << "d" << "duration", "Milliseconds every step runs for.", "msecs", "1000");
+    parser.addOption(durationOption);
+    parser.process(a);
+
+    bool ok;
+    durationMSecs = parser.value(durationOption).toLongLong(&ok);
+    if (!ok || durationMSecs <= 0) {
+        QTextStream(stderr) << "Error: invalid arguments\n";
+        parser.showHelp(1);
+    }
+
+    //a plain profile and one with a plugin and a long remark, the largest codes the dialogue shows
+    const QByteArray shortUri("ss://YWVzLTI1Ni1jZmI6cGFzc3dvcmRAMTkyLjAuMi4xOjgzODg");
+    const QByteArray longUri("ss://Y2hhY2hhMjAtaWV0Zi1wb2x5MTMwNTpjb3JyZWN0IGhvcnNlIGJhdHRlcnkgc3RhcGxl@ss-tokyo-01.example.com:443"
+                             "/?plugin=obfs-local%3Bobfs%3Dhttp%3Bobfs-host%3Dwww.example.com#Tokyo%2001%20%E2%80%94%20premium");
+
+    QTextStream out(stdout);
+    out << QString("%1 %2 %3 %4\n").arg("step", -10).arg("input", -14).arg("per second", 12).arg("us each", 10);
+
+    QRMatrix matrix;
+    report(out, "encode", "short URI", measure([&] { matrix = QRMatrix::encode(shortUri); }));
+    report(out, "encode", "long URI", measure([&] { matrix = QRMatrix::encode(longUri); }));
+
+    //the widget sizes of the share dialogue, at 1x and 2x scaling
+    const int sides[] = { 256, 512 };
+    for (int side : sides) {
+        const int moduleSize = qMax(1, side / matrix.size());
+        QImage img;
+        report(out, "rasterize", QString("%1 px").arg(side), measure([&] { img = matrix.toImage(moduleSize); }));
+    }
+    QByteArray svg;
+    report(out, "svg", "long URI", measure([&] { svg = matrix.toSvg(); }));
+
+    QRWidget widget;
+    widget.setQRData(longUri);
+    for (int side : sides) {
+        widget.resize(side, side);
+        QImage target(side, side, QImage::Format_RGB32);
+        //a resize drops the cached image, so the second run rasterizes again on every paint
+        report(out, "repaint", QString("%1 px cached").arg(side), measure([&] { widget.render(&target); }));
+        report(out, "repaint", QString("%1 px resized").arg(side), measure([&] {
+            widget.resize(side - 1, side - 1);
+            widget.resize(side, side);
+            widget.render(&target);
+        }));
+    }
+    return 0;
+}
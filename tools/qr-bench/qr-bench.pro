@@ -0,0 +1,34 @@
+#-------------------------------------------------
+#
+#          qr-bench
+#
+#  Micro-benchmark of the QR code path of the share dialogue
+#
+#-------------------------------------------------
+
+QT      += core gui widgets
+CONFIG  += c++11 console
+CONFIG  -= app_bundle
+
+TARGET   = qr-bench
+TEMPLATE = app
+
+SRC = $$PWD/../../src
+INCLUDEPATH += $$SRC
+
+SOURCES += main.cpp \
+           $$SRC/qrmatrix.cpp \
+           $$SRC/qrwidget.cpp
+
+HEADERS += $$SRC/qrmatrix.h \
+           $$SRC/qrwidget.h
+
+win32: {
+    INCLUDEPATH += $$PWD/../../3rdparty/qrencode/include
+    LIBS += -L$$PWD/../../3rdparty/qrencode
+}
+unix: {
+    CONFIG    += link_pkgconfig
+    PKGCONFIG += libqrencode
+}
+LIBS += -lqrencode
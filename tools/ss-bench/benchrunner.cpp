@@ -0,0 +1,369 @@
+#include <QCoreApplication>
+#include <QThread>
+#include <QEventLoop>
+#include <QTimer>
+#include <QTcpSocket>
+#include <QHostAddress>
+#include <QElapsedTimer>
+#include <QDebug>
+#include "ss_process.h"
+#include "ssprofile.h"
+#include "sscipher.h"
+#include "socksrelay.h"
+#include "echoserver.h"
+#include "replayserver.h"
+#include "ssserver.h"
+#include "benchrunner.h"
+
+static const char *const Password = "ss-bench";
+
+static QThread *startThread(QObject *object)
+{
+    QThread *thread = new QThread;
+    object->moveToThread(thread);
+    thread->start();
+    return thread;
+}
+
+//the object is deleted from here once its thread is gone
+static void stopThread(QThread *thread, QObject *object)
+{
+    thread->quit();
+    thread->wait();
+    delete object;
+    delete thread;
+}
+
+BenchRunner::BenchRunner(const BenchOptions &options, QObject *parent) :
+    QObject(parent),
+    m_options(options),
+    m_out(stdout),
+    m_targetThread(0),
+    m_target(0),
+    m_targetPort(0),
+    m_traceUs(0)
+{}
+
+BenchRunner::~BenchRunner()
+{
+    if (m_targetThread) {
+        stopThread(m_targetThread, m_target);
+    }
+}
+
+QString BenchRunner::backendType(const QString &name)
+{
+    if (name == "libev") {
+        return "Shadowsocks-libev";
+    }
+    if (name == "nodejs") {
+        return "Shadowsocks-NodeJS";
+    }
+    if (name == "go") {
+        return "Shadowsocks-Go";
+    }
+    if (name == "python") {
+        return "Shadowsocks-Python";
+    }
+    if (name == "mux") {
+        return "Shadowsocks-libev";//unused, mux mode runs in-process
+    }
+    return QString();
+}
+
+int BenchRunner::run()
+{
+    bool replay = !m_options.replayFile.isEmpty();
+    if (replay) {
+        if (!loadTrace()) {
+            return 1;
+        }
+        m_target = new ReplayServer(&m_trace);
+        m_options.concurrency = QList<int>() << 0;//set by the trace
+        m_options.messageSizes = QList<int>() << 0;
+    }
+    else {
+        m_target = new EchoServer;
+    }
+    m_targetThread = startThread(m_target);
+    bool listening = false;
+    QMetaObject::invokeMethod(m_target, "listenLoopback", Qt::BlockingQueuedConnection, Q_RETURN_ARG(bool, listening));
+    if (!listening) {
+        qCritical() << "Error: cannot listen on loopback";
+        return 1;
+    }
+    m_targetPort = m_target->serverPort();
+
+    QStringList backends;
+    for (QStringList::const_iterator it = m_options.backends.constBegin(); it != m_options.backends.constEnd(); ++it) {
+        SSProfile p;
+        p.type = backendType(*it);
+        if (p.type.isEmpty()) {
+            qCritical() << "Error: unknown backend" << *it;
+            return 1;
+        }
+        p.setBackend();
+        if (p.backend.isEmpty() && *it != "mux") {
+            qWarning() << "Warning:" << *it << "is not installed, skipped";
+            continue;
+        }
+        backends << *it;
+    }
+    if (backends.isEmpty()) {
+        qCritical() << "Error: none of the backends is installed";
+        return 1;
+    }
+
+    printHeader();
+    int failures = 0;
+    Case c;
+    for (QStringList::const_iterator b = backends.constBegin(); b != backends.constEnd(); ++b) {
+        c.backend = *b;
+        for (QStringList::const_iterator m = m_options.methods.constBegin(); m != m_options.methods.constEnd(); ++m) {
+            c.method = *m;
+            for (QList<int>::const_iterator n = m_options.concurrency.constBegin(); n != m_options.concurrency.constEnd(); ++n) {
+                c.concurrency = *n;
+                for (QList<int>::const_iterator s = m_options.messageSizes.constBegin(); s != m_options.messageSizes.constEnd(); ++s) {
+                    c.messageSize = *s;
+                    LoadResult result;
+                    QString error;
+                    if (!runCase(c, &result, &error)) {
+                        ++failures;
+                    }
+                    printRow(c, result, error);
+                }
+            }
+        }
+    }
+    return failures == 0 ? 0 : 2;
+}
+
+bool BenchRunner::runCase(const Case &c, LoadResult *result, QString *error)
+{
+    if (!SSCipher::isSupported(c.method)) {
+        *error = "method not supported by the built-in server";
+        return false;
+    }
+
+    SSServer server;
+    if (!server.start(QHostAddress::LocalHost, 0, c.method, Password, 60)) {
+        *error = "built-in server cannot listen";
+        return false;
+    }
+
+    //the very path the GUI takes to start a profile
+    SSProfile profile;
+    profile.profileName = "ss-bench";
+    profile.type = backendType(c.backend);
+    profile.setBackend();
+    profile.server = "127.0.0.1";
+    profile.server_port = QString::number(server.serverPort());
+    profile.local_addr = "127.0.0.1";
+    profile.local_port = QString::number(SocksRelay::pickFreePort());
+    profile.method = c.method;
+    profile.password = Password;
+    profile.timeout = "60";
+    profile.mux = c.backend == "mux" ? MuxCarriers : 0;
+
+    SS_Process proc;
+    proc.setRelayMode(m_options.relay);
+    if (m_options.verbose) {
+        connect(&proc, &SS_Process::readReadyProcess, [](const QByteArray &o) {
+            QTextStream(stderr) << o;
+        });
+    }
+    proc.start(&profile, m_options.verbose);
+
+    bool ok = proc.isRunning() && waitForPort(profile.local_port.toUShort(), ReadyTimeoutMSecs);
+    if (ok) {
+        quint16 socksPort = profile.local_port.toUShort();
+        *result = m_options.replayFile.isEmpty() ? runLoad(socksPort, c) : runReplay(socksPort);
+        if (result->connections == 0) {
+            *error = "no connection went through";
+            ok = false;
+        }
+    }
+    else {
+        *error = "backend didn't start";
+    }
+
+    proc.stop();
+    server.stop();
+    return ok;
+}
+
+bool BenchRunner::waitForPort(quint16 port, int timeoutMSecs)
+{
+    QElapsedTimer elapsed;
+    elapsed.start();
+    while (elapsed.elapsed() < timeoutMSecs) {
+        QTcpSocket socket;
+        socket.connectToHost(QHostAddress::LocalHost, port);
+        if (socket.waitForConnected(200)) {
+            socket.abort();
+            return true;
+        }
+        QThread::msleep(50);
+        QCoreApplication::processEvents();
+    }
+    return false;
+}
+
+LoadResult BenchRunner::runLoad(quint16 socksPort, const Case &c)
+{
+    //leave cores to the backend, the server and the echo server
+    int threads = qMin(c.concurrency, qMax(1, QThread::idealThreadCount() / 2));
+
+    QEventLoop loop;
+    int remaining = threads;
+    QVector<QThread *> clientThreads;
+    QVector<LoadClient *> clients;
+    for (int i = 0; i < threads; ++i) {
+        LoadSettings s;
+        s.socksPort = socksPort;
+        s.echoPort = m_targetPort;
+        s.connections = c.concurrency / threads + (i < c.concurrency % threads ? 1 : 0);
+        s.messageSize = c.messageSize;
+        s.messagesPerConnection = m_options.messagesPerConnection;
+        s.durationMSecs = m_options.durationSeconds * 1000;
+
+        LoadClient *client = new LoadClient(s);
+        connect(client, &LoadClient::finished, &loop, [&loop, &remaining] {
+            if (--remaining == 0) {
+                loop.quit();
+            }
+        });
+        clientThreads.append(startThread(client));
+        clients.append(client);
+        QMetaObject::invokeMethod(client, "start", Qt::QueuedConnection);
+    }
+    QTimer::singleShot(m_options.durationSeconds * 1000 + LoadClient::GraceMSecs + ReadyTimeoutMSecs, &loop, &QEventLoop::quit);
+    loop.exec();
+
+    LoadResult total;
+    for (int i = 0; i < threads; ++i) {
+        clientThreads.at(i)->quit();
+        clientThreads.at(i)->wait();
+        total.merge(clients.at(i)->result());
+        delete clients.at(i);
+        delete clientThreads.at(i);
+    }
+    return total;
+}
+
+bool BenchRunner::loadTrace()
+{
+    QString error;
+    if (!TrafficTrace::load(m_options.replayFile, &m_trace, &error)) {
+        qCritical() << "Error: cannot load" << m_options.replayFile << error;
+        return false;
+    }
+
+    int replayable = 0;
+    quint64 bytes = 0;
+    qint64 end = 0;
+    for (QVector<TrafficTrace::Session>::const_iterator it = m_trace.constBegin(); it != m_trace.constEnd(); ++it) {
+        if (!ReplayScript::isReplayable(*it)) {
+            continue;
+        }
+        ++replayable;
+        for (QVector<TrafficTrace::Event>::const_iterator e = it->events.constBegin(); e != it->events.constEnd(); ++e) {
+            bytes += e->size;
+        }
+        if (!it->events.isEmpty()) {
+            end = qMax(end, it->openUs + it->events.last().us);
+        }
+    }
+    m_traceUs = m_trace.isEmpty() ? 0 : end - m_trace.first().openUs;
+    if (replayable == 0) {
+        qCritical() << "Error: no session to replay in" << m_options.replayFile;
+        return false;
+    }
+    m_out << QString("Replaying %1 of %2 sessions, %3 MiB over %4 s. Percentiles are how late responses arrive compared with the recording.\n")
+             .arg(replayable).arg(m_trace.size()).arg(bytes / (1024.0 * 1024.0), 0, 'f', 2).arg(m_traceUs / 1000000.0, 0, 'f', 1);
+    return true;
+}
+
+LoadResult BenchRunner::runReplay(quint16 socksPort)
+{
+    int threads = qBound(1, QThread::idealThreadCount() / 2, qMax(1, m_trace.size()));
+
+    QEventLoop loop;
+    int remaining = threads;
+    QVector<QThread *> clientThreads;
+    QVector<ReplayClient *> clients;
+    for (int i = 0; i < threads; ++i) {
+        ReplayClient *client = new ReplayClient(&m_trace, i, threads, socksPort, m_targetPort);
+        connect(client, &ReplayClient::finished, &loop, [&loop, &remaining] {
+            if (--remaining == 0) {
+                loop.quit();
+            }
+        });
+        clientThreads.append(startThread(client));
+        clients.append(client);
+    }
+    //started together so that the shards share the time base
+    for (int i = 0; i < threads; ++i) {
+        QMetaObject::invokeMethod(clients.at(i), "start", Qt::QueuedConnection);
+    }
+    QTimer::singleShot(int(m_traceUs / 1000) * 2 + ReplayTimeoutMSecs, &loop, &QEventLoop::quit);
+    loop.exec();
+
+    LoadResult total;
+    for (int i = 0; i < threads; ++i) {
+        clientThreads.at(i)->quit();
+        clientThreads.at(i)->wait();
+        total.merge(clients.at(i)->result());
+        delete clients.at(i);
+        delete clientThreads.at(i);
+    }
+    return total;
+}
+
+void BenchRunner::printHeader()
+{
+    if (m_options.csv) {
+        m_out << "backend,method,concurrency,message_size,mib_per_s,connections_per_s,rtt_p50_us,rtt_p90_us,rtt_p99_us,rtt_p999_us,handshake_p50_us,errors,error\n";
+    }
+    else {
+        m_out << QString("%1 %2 %3 %4 %5 %6 %7 %8 %9 %10 %11 %12\n")
+                 .arg("backend", -7).arg("method", -17).arg("conc", 5).arg("size", 7)
+                 .arg("MiB/s", 9).arg("conn/s", 9).arg("p50", 9).arg("p90", 9).arg("p99", 9).arg("p99.9", 9)
+                 .arg("handshake", 10).arg("errors", 7);
+    }
+    m_out.flush();
+}
+
+void BenchRunner::printRow(const Case &c, const LoadResult &r, const QString &error)
+{
+    double seconds = r.elapsedUs > 0 ? r.elapsedUs / 1000000.0 : 1.0;
+    double mibps = r.bytes / seconds / (1024.0 * 1024.0);
+    double cps = r.connections / seconds;
+
+    if (m_options.csv) {
+        m_out << QString("%1,%2,%3,%4,%5,%6,%7,%8,%9,%10,%11,%12,\"%13\"\n")
+                 .arg(c.backend).arg(c.method).arg(c.concurrency).arg(c.messageSize)
+                 .arg(mibps, 0, 'f', 2).arg(cps, 0, 'f', 1)
+                 .arg(r.roundTrip.percentile(50)).arg(r.roundTrip.percentile(90))
+                 .arg(r.roundTrip.percentile(99)).arg(r.roundTrip.percentile(99.9))
+                 .arg(r.handshake.percentile(50)).arg(r.errors).arg(error);
+    }
+    else {
+        m_out << QString("%1 %2 %3 %4 %5 %6 %7 %8 %9 %10 %11 %12")
+                 .arg(c.backend, -7).arg(c.method, -17)
+                 .arg(c.concurrency > 0 ? QString::number(c.concurrency) : QString("-"), 5)
+                 .arg(c.messageSize > 0 ? QString::number(c.messageSize) : QString("-"), 7)
+                 .arg(mibps, 9, 'f', 2).arg(cps, 9, 'f', 1)
+                 .arg(LatencyHistogram::formatMicroseconds(r.roundTrip.percentile(50)), 9)
+                 .arg(LatencyHistogram::formatMicroseconds(r.roundTrip.percentile(90)), 9)
+                 .arg(LatencyHistogram::formatMicroseconds(r.roundTrip.percentile(99)), 9)
+                 .arg(LatencyHistogram::formatMicroseconds(r.roundTrip.percentile(99.9)), 9)
+                 .arg(LatencyHistogram::formatMicroseconds(r.handshake.percentile(50)), 10)
+                 .arg(r.errors, 7);
+        if (!error.isEmpty()) {
+            m_out << "  " << error;
+        }
+        m_out << "\n";
+    }
+    m_out.flush();
+}
@@ -0,0 +1,76 @@
+/*
+ * Bench Runner Class
+ *
+ * Runs every combination of backend, method, concurrency and message size
+ * in turn: the built-in SSServer for the method, the backend started through
+ * SS_Process exactly as the GUI does, and the load clients on top.
+ * With a traffic trace, every backend and method replays it instead.
+ * Everything stays on loopback.
+ */
+#ifndef BENCHRUNNER_H
+#define BENCHRUNNER_H
+#include <QObject>
+#include <QStringList>
+#include <QTextStream>
+#include <QList>
+#include "loadclient.h"
+#include "traffictrace.h"
+
+class QThread;
+class QTcpServer;
+
+struct BenchOptions
+{
+    QStringList backends;//libev, nodejs, go, python
+    QStringList methods;
+    QList<int> concurrency;
+    QList<int> messageSizes;
+    int messagesPerConnection;
+    int durationSeconds;
+    bool relay;//through ss-qt5's SOCKS relay as well
+    QString replayFile;//replaces the echo load if set
+    bool csv;
+    bool verbose;
+};
+
+class BenchRunner : public QObject
+{
+    Q_OBJECT
+
+public:
+    BenchRunner(const BenchOptions &options, QObject *parent = 0);
+    ~BenchRunner();
+    int run();//the process exit code
+
+    static QString backendType(const QString &name);//as SSProfile::type, empty if unknown
+    static const int ReadyTimeoutMSecs = 5000;
+    static const int MuxCarriers = 4;//for the mux pseudo backend
+    static const int ReplayTimeoutMSecs = 30000;//on top of twice the recorded duration
+
+private:
+    struct Case
+    {
+        QString backend;
+        QString method;
+        int concurrency;
+        int messageSize;
+    };
+
+    BenchOptions m_options;
+    QTextStream m_out;
+    QThread *m_targetThread;
+    QTcpServer *m_target;//echo or replay server
+    quint16 m_targetPort;
+    QVector<TrafficTrace::Session> m_trace;
+    qint64 m_traceUs;//from the first session opening to the last event
+
+    bool runCase(const Case &c, LoadResult *result, QString *error);
+    LoadResult runLoad(quint16 socksPort, const Case &c);
+    LoadResult runReplay(quint16 socksPort);
+    bool loadTrace();
+    static bool waitForPort(quint16 port, int timeoutMSecs);
+    void printHeader();
+    void printRow(const Case &c, const LoadResult &r, const QString &error);
+};
+
+#endif // BENCHRUNNER_H
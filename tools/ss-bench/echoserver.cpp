@@ -0,0 +1,20 @@
+#include <QTcpSocket>
+#include "echoserver.h"
+
+bool EchoServer::listenLoopback()
+{
+    return listen(QHostAddress::LocalHost, 0);
+}
+
+void EchoServer::incomingConnection(qintptr socketDescriptor)
+{
+    QTcpSocket *socket = new QTcpSocket(this);
+    if (!socket->setSocketDescriptor(socketDescriptor)) {
+        delete socket;
+        return;
+    }
+    connect(socket, &QTcpSocket::readyRead, socket, [socket] {
+        socket->write(socket->readAll());
+    });
+    connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+}
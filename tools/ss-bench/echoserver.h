@@ -0,0 +1,25 @@
+/*
+ * Echo Server Class
+ *
+ * The target every benchmark session connects to through the proxy.
+ * It writes back whatever it reads, so the client can time round trips.
+ */
+#ifndef ECHOSERVER_H
+#define ECHOSERVER_H
+#include <QTcpServer>
+
+class EchoServer : public QTcpServer
+{
+    Q_OBJECT
+
+public:
+    EchoServer(QObject *parent = 0) : QTcpServer(parent) {}
+
+public slots:
+    bool listenLoopback();//on a free port, see serverPort()
+
+protected:
+    void incomingConnection(qintptr socketDescriptor);
+};
+
+#endif // ECHOSERVER_H
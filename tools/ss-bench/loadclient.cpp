@@ -0,0 +1,199 @@
+#include <QHostAddress>
+#include "socksaddress.h"
+#include "loadclient.h"
+
+BenchConnection::BenchConnection(LoadClient *client) :
+    QObject(client),
+    m_client(client),
+    m_socket(this),
+    m_state(Idle),
+    m_received(0),
+    m_sent(0)
+{
+    connect(&m_socket, &QTcpSocket::connected, this, &BenchConnection::onConnected);
+    connect(&m_socket, &QTcpSocket::readyRead, this, &BenchConnection::onReadyRead);
+    connect(&m_socket, &QTcpSocket::disconnected, this, &BenchConnection::onDisconnected);
+    connect(&m_socket, static_cast<void (QAbstractSocket::*)(QAbstractSocket::SocketError)>(&QAbstractSocket::error), this, &BenchConnection::onError);
+}
+
+void BenchConnection::open()
+{
+    if (m_client->m_stopping) {
+        m_client->checkDone();
+        return;
+    }
+    m_state = Greeting;
+    m_buffer.clear();
+    m_sent = 0;
+    m_timer.start();
+    m_socket.connectToHost(QHostAddress::LocalHost, m_client->m_settings.socksPort);
+}
+
+void BenchConnection::onConnected()
+{
+    m_socket.write("\x05\x01\x00", 3);//no authentication
+}
+
+void BenchConnection::onReadyRead()
+{
+    m_buffer.append(m_socket.readAll());
+
+    if (m_state == Greeting) {
+        if (m_buffer.size() < 2) {
+            return;
+        }
+        if (m_buffer.at(0) != 5 || m_buffer.at(1) != 0) {
+            fail();
+            return;
+        }
+        m_buffer.remove(0, 2);
+        m_state = Request;
+        m_socket.write(m_client->m_request);
+        return;
+    }
+
+    if (m_state == Request) {
+        //VER REP RSV ATYP BND.ADDR BND.PORT
+        if (m_buffer.size() < 4) {
+            return;
+        }
+        int addrLen = SocksAddress::parse(m_buffer.constData() + 3, m_buffer.size() - 3, 0, 0);
+        if (addrLen == 0) {
+            return;
+        }
+        if (addrLen < 0 || m_buffer.at(1) != 0) {
+            fail();
+            return;
+        }
+        m_buffer.clear();//the echo server speaks only when spoken to
+        m_client->m_result.handshake.record(m_timer.nsecsElapsed() / 1000);
+        ++m_client->m_result.connections;
+        m_state = Echo;
+        if (m_client->m_stopping) {
+            m_state = Closing;
+            m_socket.disconnectFromHost();
+        } else {
+            sendMessage();
+        }
+        return;
+    }
+
+    if (m_state == Echo) {
+        m_received += m_buffer.size();
+        m_buffer.clear();
+        if (m_received < m_client->m_settings.messageSize) {
+            return;
+        }
+        m_client->m_result.roundTrip.record(m_timer.nsecsElapsed() / 1000);
+        m_client->m_result.bytes += m_client->m_settings.messageSize;
+        if (m_client->m_stopping || ++m_sent >= m_client->m_settings.messagesPerConnection) {
+            m_state = Closing;
+            m_socket.disconnectFromHost();
+        } else {
+            sendMessage();
+        }
+    }
+}
+
+void BenchConnection::sendMessage()
+{
+    m_received = 0;
+    m_timer.restart();
+    m_socket.write(m_client->m_payload);
+}
+
+void BenchConnection::fail()
+{
+    m_state = Idle;//before abort(), which emits disconnected()
+    m_socket.abort();
+    ++m_client->m_result.errors;
+    m_client->connectionClosed(this, true);
+}
+
+void BenchConnection::onDisconnected()
+{
+    if (m_state == Closing) {
+        m_state = Idle;
+        m_client->connectionClosed(this, false);
+    }
+    else if (m_state != Idle) {
+        fail();
+    }
+}
+
+void BenchConnection::onError()
+{
+    if (m_state != Idle && m_state != Closing) {
+        fail();
+    }
+}
+
+LoadClient::LoadClient(const LoadSettings &settings, QObject *parent) :
+    QObject(parent),
+    m_settings(settings),
+    m_stopTimer(this),
+    m_stopping(false),
+    m_done(false)
+{
+    m_stopTimer.setSingleShot(true);
+    connect(&m_stopTimer, &QTimer::timeout, this, &LoadClient::stop);
+}
+
+void LoadClient::start()
+{
+    m_payload = QByteArray(m_settings.messageSize, 'x');
+    m_request = QByteArray("\x05\x01\x00", 3) + SocksAddress::encode("127.0.0.1", m_settings.echoPort);
+    for (int i = 0; i < m_settings.connections; ++i) {
+        m_connections.append(new BenchConnection(this));
+    }
+
+    m_elapsed.start();
+    m_stopTimer.start(m_settings.durationMSecs);
+    for (QVector<BenchConnection *>::iterator it = m_connections.begin(); it != m_connections.end(); ++it) {
+        (*it)->open();
+    }
+}
+
+void LoadClient::connectionClosed(BenchConnection *connection, bool failed)
+{
+    if (!m_stopping) {
+        //don't hammer a backend that refuses connections
+        QTimer::singleShot(failed ? RetryMSecs : 0, connection, &BenchConnection::open);
+        return;
+    }
+    checkDone();
+}
+
+void LoadClient::checkDone()
+{
+    for (QVector<BenchConnection *>::const_iterator it = m_connections.constBegin(); it != m_connections.constEnd(); ++it) {
+        if (!(*it)->isIdle()) {
+            return;
+        }
+    }
+    finish();
+}
+
+void LoadClient::stop()
+{
+    m_stopping = true;
+    QTimer::singleShot(GraceMSecs, this, &LoadClient::finish);
+    checkDone();
+}
+
+void LoadClient::finish()
+{
+    if (m_done) {
+        return;
+    }
+    m_done = true;
+    m_result.elapsedUs = m_elapsed.nsecsElapsed() / 1000;
+
+    //still waiting for their message after the grace period, counted as errors
+    for (QVector<BenchConnection *>::iterator it = m_connections.begin(); it != m_connections.end(); ++it) {
+        if (!(*it)->isIdle()) {
+            (*it)->abort();
+        }
+    }
+    emit finished();
+}
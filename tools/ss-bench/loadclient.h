@@ -0,0 +1,129 @@
+/*
+ * Load Client Class
+ *
+ * Drives a number of SOCKS5 connections through the proxy to the echo
+ * server from its own thread. Every connection sends a message, waits for
+ * it to come back, and reconnects after a given number of messages, until
+ * the run is over.
+ */
+#ifndef LOADCLIENT_H
+#define LOADCLIENT_H
+#include <QObject>
+#include <QTcpSocket>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QVector>
+#include "latencyhistogram.h"
+
+struct LoadSettings
+{
+    quint16 socksPort;
+    quint16 echoPort;
+    int connections;
+    int messageSize;
+    int messagesPerConnection;
+    int durationMSecs;
+};
+
+struct LoadResult
+{
+    LatencyHistogram roundTrip;//one message there and back
+    LatencyHistogram handshake;//TCP connect to the SOCKS5 reply
+    quint64 bytes;//echoed, counted once
+    quint64 connections;//that completed the handshake
+    quint64 errors;
+    qint64 elapsedUs;
+
+    LoadResult() : bytes(0), connections(0), errors(0), elapsedUs(0) {}
+
+    void merge(const LoadResult &o)
+    {
+        roundTrip.merge(o.roundTrip);
+        handshake.merge(o.handshake);
+        bytes += o.bytes;
+        connections += o.connections;
+        errors += o.errors;
+        elapsedUs = qMax(elapsedUs, o.elapsedUs);
+    }
+};
+
+class LoadClient;
+
+class BenchConnection : public QObject
+{
+    Q_OBJECT
+
+public:
+    BenchConnection(LoadClient *client);
+    inline bool isIdle() const { return m_state == Idle; }
+    inline void abort() { m_socket.abort(); }
+
+public slots:
+    void open();
+
+private:
+    enum State {
+        Idle,
+        Greeting,
+        Request,
+        Echo,
+        Closing
+    };
+
+    LoadClient *m_client;
+    QTcpSocket m_socket;
+    State m_state;
+    QByteArray m_buffer;
+    int m_received;
+    int m_sent;
+    QElapsedTimer m_timer;
+
+    void sendMessage();
+    void fail();
+
+private slots:
+    void onConnected();
+    void onReadyRead();
+    void onDisconnected();
+    void onError();
+};
+
+class LoadClient : public QObject
+{
+    Q_OBJECT
+
+public:
+    LoadClient(const LoadSettings &settings, QObject *parent = 0);
+    inline const LoadResult &result() const { return m_result; }
+
+    static const int GraceMSecs = 2000;//for the connections to finish their message
+    static const int RetryMSecs = 100;
+
+signals:
+    void finished();
+
+public slots:
+    void start();
+
+private:
+    friend class BenchConnection;
+
+    LoadSettings m_settings;
+    LoadResult m_result;
+    QByteArray m_payload;
+    QByteArray m_request;//SOCKS5 CONNECT to the echo server
+    QVector<BenchConnection *> m_connections;
+    QTimer m_stopTimer;
+    QElapsedTimer m_elapsed;
+    bool m_stopping;
+    bool m_done;
+
+    void connectionClosed(BenchConnection *connection, bool failed);
+    void checkDone();
+
+private slots:
+    void stop();
+    void finish();
+};
+
+#endif // LOADCLIENT_H
@@ -0,0 +1,87 @@
+/*
+ * ss-bench
+ *
+ * Compares the shadowsocks backends on this machine, offline: every backend
+ * is started through SS_Process against the built-in server on loopback and
+ * driven with SOCKS5 load towards a local echo server, or with the sessions
+ * of a traffic trace recorded by ss-qt5 --record-traffic.
+ */
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QTextStream>
+#include "sscipher.h"
+#include "benchrunner.h"
+
+static QList<int> intList(const QString &value, bool *ok)
+{
+    QList<int> list;
+    QStringList parts = value.split(',', QString::SkipEmptyParts);
+    for (QStringList::const_iterator it = parts.constBegin(); it != parts.constEnd(); ++it) {
+        int n = it->trimmed().toInt(ok);
+        if (!*ok || n <= 0) {
+            *ok = false;
+            return QList<int>();
+        }
+        list << n;
+    }
+    *ok = !list.isEmpty();
+    return list;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    a.setApplicationName("ss-bench");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("End-to-end benchmark of the shadowsocks backends on loopback.");
+    parser.addHelpOption();
+    QCommandLineOption backendOption(QStringList() << "b" << "backend", "Backends to compare: libev, nodejs, go, python, and mux for ss-qt5's own mux mode. All installed ones by default.", "list", "libev,nodejs,go,python");
+    QCommandLineOption methodOption(QStringList() << "m" << "method", "Encryption methods.", "list", "aes-256-cfb");
+    QCommandLineOption concurrencyOption(QStringList() << "c" << "concurrency", "Concurrent connections.", "list", "1,16");
+    QCommandLineOption sizeOption(QStringList() << "s" << "size", "Message sizes in bytes.", "list", "1024,65536");
+    QCommandLineOption messagesOption(QStringList() << "n" << "messages", "Messages per connection before it reconnects.", "count", "100");
+    QCommandLineOption durationOption(QStringList() << "d" << "duration", "Seconds every combination runs for.", "seconds", "10");
+    QCommandLineOption relayOption("relay", "Go through the ss-qt5 SOCKS relay as well.");
+    QCommandLineOption replayOption("replay", "Replay a traffic trace instead of the echo load.", "file");
+    QCommandLineOption csvOption("csv", "Print CSV instead of a table.");
+    QCommandLineOption listOption("list-methods", "List the methods the built-in server supports and exit.");
+    QCommandLineOption verboseOption("v", "Print the backends' output.");
+    parser.addOption(backendOption);
+    parser.addOption(methodOption);
+    parser.addOption(concurrencyOption);
+    parser.addOption(sizeOption);
+    parser.addOption(messagesOption);
+    parser.addOption(durationOption);
+    parser.addOption(relayOption);
+    parser.addOption(replayOption);
+    parser.addOption(csvOption);
+    parser.addOption(listOption);
+    parser.addOption(verboseOption);
+    parser.process(a);
+
+    if (parser.isSet(listOption)) {
+        QTextStream(stdout) << SSCipher::supportedMethods().join('\n') << '\n';
+        return 0;
+    }
+
+    BenchOptions options;
+    bool ok1, ok2, ok3 = false, ok4 = false;
+    options.backends = parser.value(backendOption).split(',', QString::SkipEmptyParts);
+    options.methods = parser.value(methodOption).split(',', QString::SkipEmptyParts);
+    options.concurrency = intList(parser.value(concurrencyOption), &ok1);
+    options.messageSizes = intList(parser.value(sizeOption), &ok2);
+    options.messagesPerConnection = parser.value(messagesOption).toInt(&ok3);
+    options.durationSeconds = parser.value(durationOption).toInt(&ok4);
+    options.relay = parser.isSet(relayOption);
+    options.replayFile = parser.value(replayOption);
+    options.csv = parser.isSet(csvOption);
+    options.verbose = parser.isSet(verboseOption);
+    if (!ok1 || !ok2 || !ok3 || !ok4 || options.messagesPerConnection <= 0 || options.durationSeconds <= 0 || options.methods.isEmpty()) {
+        QTextStream(stderr) << "Error: invalid arguments\n";
+        parser.showHelp(1);
+    }
+
+    BenchRunner runner(options);
+    return runner.run();
+}
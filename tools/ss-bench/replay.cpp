@@ -0,0 +1,272 @@
+#include <QHostAddress>
+#include "socksaddress.h"
+#include "replay.h"
+
+ReplayScript::ReplayScript(const TrafficTrace::Session *session, TrafficTrace::EventType mine, LatencyHistogram *lag) :
+    m_session(session),
+    m_mine(mine),
+    m_peer(mine == TrafficTrace::Up ? TrafficTrace::Down : TrafficTrace::Up),
+    m_lag(lag),
+    m_index(0),
+    m_counted(false),
+    m_expected(0),
+    m_lastUs(0),
+    m_lastActual(0),
+    m_beginUs(0),
+    m_beginActual(0)
+{}
+
+bool ReplayScript::isReplayable(const TrafficTrace::Session &session)
+{
+    //sessions the server never answered can't be reproduced
+    for (QVector<TrafficTrace::Event>::const_iterator it = session.events.constBegin(); it != session.events.constEnd(); ++it) {
+        if (it->type == TrafficTrace::Connected) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void ReplayScript::begin(qint64 nowUs)
+{
+    const QVector<TrafficTrace::Event> &events = m_session->events;
+    m_index = 0;
+    while (m_index < events.size() && events.at(m_index).type != TrafficTrace::Connected) {
+        ++m_index;
+    }
+    m_lastUs = m_index < events.size() ? events.at(m_index).us : 0;
+    ++m_index;
+    m_lastActual = nowUs;
+    m_beginUs = m_lastUs;
+    m_beginActual = nowUs;
+}
+
+ReplayScript::Step ReplayScript::next(qint64 nowUs, quint64 received, quint32 *size, qint64 *waitUs)
+{
+    const QVector<TrafficTrace::Event> &events = m_session->events;
+    while (m_index < events.size()) {
+        const TrafficTrace::Event &e = events.at(m_index);
+
+        if (e.type == m_peer) {
+            if (!m_counted) {
+                m_expected += e.size;
+                m_counted = true;
+            }
+            if (received < m_expected) {
+                return NeedBytes;
+            }
+            if (m_lag) {
+                m_lag->record(qMax(Q_INT64_C(0), (nowUs - m_beginActual) - (e.us - m_beginUs)));
+            }
+        }
+        else if (e.type == m_mine || e.type == TrafficTrace::Close) {
+            qint64 due = m_lastActual + (e.us - m_lastUs);
+            if (nowUs < due) {
+                *waitUs = due - nowUs;
+                return Wait;
+            }
+        }
+
+        if (e.type == m_peer || e.type == m_mine || e.type == TrafficTrace::Close) {
+            m_lastUs = e.us;
+            m_lastActual = nowUs;
+        }
+        m_counted = false;
+        ++m_index;
+        if (e.type == m_mine) {
+            *size = e.size;
+            return Send;
+        }
+        if (e.type == TrafficTrace::Close) {
+            return Done;
+        }
+    }
+    return Done;
+}
+
+ReplayConnection::ReplayConnection(int index, ReplayClient *client) :
+    QObject(client),
+    m_index(index),
+    m_client(client),
+    m_session(&client->m_sessions->at(index)),
+    m_script(m_session, TrafficTrace::Up, &client->m_result.roundTrip),
+    m_socket(this),
+    m_timer(this),
+    m_state(Greeting),
+    m_received(0),
+    m_startUs(0)
+{
+    m_timer.setSingleShot(true);
+    m_timer.setTimerType(Qt::PreciseTimer);
+    connect(&m_timer, &QTimer::timeout, this, &ReplayConnection::advance);
+    connect(&m_socket, &QTcpSocket::connected, this, &ReplayConnection::onConnected);
+    connect(&m_socket, &QTcpSocket::readyRead, this, &ReplayConnection::onReadyRead);
+    connect(&m_socket, static_cast<void (QAbstractSocket::*)(QAbstractSocket::SocketError)>(&QAbstractSocket::error), this, &ReplayConnection::onError);
+}
+
+void ReplayConnection::open()
+{
+    m_startUs = m_client->nowUs();
+    m_socket.connectToHost(QHostAddress::LocalHost, m_client->m_socksPort);
+}
+
+void ReplayConnection::onConnected()
+{
+    m_socket.write("\x05\x01\x00", 3);//no authentication
+}
+
+void ReplayConnection::onReadyRead()
+{
+    QByteArray data = m_socket.readAll();
+    if (m_state == Running) {
+        m_received += data.size();
+        m_client->m_result.bytes += data.size();
+        advance();
+        return;
+    }
+    if (m_state == Finished) {
+        return;
+    }
+
+    m_buffer.append(data);
+    if (m_state == Greeting) {
+        if (m_buffer.size() < 2) {
+            return;
+        }
+        if (m_buffer.at(0) != 5 || m_buffer.at(1) != 0) {
+            finish(true);
+            return;
+        }
+        m_buffer.remove(0, 2);
+        m_state = Request;
+        m_socket.write(m_client->m_request);
+    }
+
+    //VER REP RSV ATYP BND.ADDR BND.PORT
+    if (m_buffer.size() < 4) {
+        return;
+    }
+    int addrLen = SocksAddress::parse(m_buffer.constData() + 3, m_buffer.size() - 3, 0, 0);
+    if (addrLen == 0) {
+        return;
+    }
+    if (addrLen < 0 || m_buffer.at(1) != 0) {
+        finish(true);
+        return;
+    }
+    qint64 now = m_client->nowUs();
+    m_client->m_result.handshake.record(now - m_startUs);
+    ++m_client->m_result.connections;
+    m_received = m_buffer.size() - 3 - addrLen;
+    m_buffer.clear();
+
+    //tells the replay server which session to play
+    QByteArray header;
+    for (int i = 0; i < 8; ++i) {
+        header.append(char(quint64(m_index) >> (8 * i)));
+    }
+    m_socket.write(header);
+    m_state = Running;
+    m_script.begin(now);
+    advance();
+}
+
+void ReplayConnection::advance()
+{
+    while (m_state == Running) {
+        quint32 size = 0;
+        qint64 waitUs = 0;
+        switch (m_script.next(m_client->nowUs(), m_received, &size, &waitUs)) {
+        case ReplayScript::Send:
+            for (quint32 sent = 0; sent < size; sent += m_client->m_zeros.size()) {
+                m_socket.write(m_client->m_zeros.constData(), qMin(quint32(m_client->m_zeros.size()), size - sent));
+            }
+            m_client->m_result.bytes += size;
+            break;
+        case ReplayScript::Wait:
+            m_timer.start(int((waitUs + 999) / 1000));
+            return;
+        case ReplayScript::NeedBytes:
+            return;
+        case ReplayScript::Done:
+            m_state = Finished;
+            m_socket.disconnectFromHost();
+            finish(false);
+            return;
+        }
+    }
+}
+
+void ReplayConnection::onError()
+{
+    if (m_state != Finished) {
+        finish(true);
+    }
+}
+
+void ReplayConnection::finish(bool failed)
+{
+    if (failed) {
+        m_state = Finished;
+        m_socket.abort();
+        ++m_client->m_result.errors;
+    }
+    m_timer.stop();
+    m_client->sessionFinished(this);
+}
+
+ReplayClient::ReplayClient(const QVector<TrafficTrace::Session> *sessions, int shard, int shards, quint16 socksPort, quint16 targetPort, QObject *parent) :
+    QObject(parent),
+    m_sessions(sessions),
+    m_nextOpen(0),
+    m_open(0),
+    m_socksPort(socksPort),
+    m_zeros(64 * 1024, '\0'),
+    m_openTimer(this),
+    m_baseUs(sessions->isEmpty() ? 0 : sessions->first().openUs)
+{
+    for (int i = shard; i < sessions->size(); i += shards) {
+        if (ReplayScript::isReplayable(sessions->at(i))) {
+            m_mine.append(i);
+        }
+    }
+    m_request = QByteArray("\x05\x01\x00", 3) + SocksAddress::encode("127.0.0.1", targetPort);
+    m_openTimer.setSingleShot(true);
+    m_openTimer.setTimerType(Qt::PreciseTimer);
+    connect(&m_openTimer, &QTimer::timeout, this, &ReplayClient::openDue);
+}
+
+void ReplayClient::start()
+{
+    m_clock.start();
+    openDue();
+}
+
+void ReplayClient::openDue()
+{
+    qint64 now = nowUs();
+    while (m_nextOpen < m_mine.size()) {
+        int index = m_mine.at(m_nextOpen);
+        qint64 due = m_sessions->at(index).openUs - m_baseUs;
+        if (due > now) {
+            m_openTimer.start(int((due - now + 999) / 1000));
+            return;
+        }
+        ++m_nextOpen;
+        ++m_open;
+        (new ReplayConnection(index, this))->open();
+    }
+    if (m_open == 0) {
+        m_result.elapsedUs = nowUs();
+        emit finished();
+    }
+}
+
+void ReplayClient::sessionFinished(ReplayConnection *connection)
+{
+    connection->deleteLater();
+    if (--m_open == 0 && m_nextOpen == m_mine.size()) {
+        m_result.elapsedUs = nowUs();
+        emit finished();
+    }
+}
@@ -0,0 +1,128 @@
+/*
+ * Traffic replay
+ *
+ * Regenerates the sessions of a traffic trace (see TrafficTrace) through the
+ * proxy with synthetic payloads. Both ends walk the same script: a side
+ * sends its chunk once the peer's chunks recorded before it have arrived
+ * and the recorded gap has passed, so request and response keep their order
+ * and their spacing whatever the proxy adds.
+ */
+#ifndef REPLAY_H
+#define REPLAY_H
+#include <QObject>
+#include <QTcpSocket>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QVector>
+#include "traffictrace.h"
+#include "loadclient.h"
+
+class ReplayScript
+{
+public:
+    enum Step {
+        Send,
+        Wait,//for *waitUs
+        NeedBytes,//from the peer
+        Done
+    };
+
+    //lag, if given, records how late every chunk of the peer arrives compared with the recording
+    ReplayScript(const TrafficTrace::Session *session, TrafficTrace::EventType mine, LatencyHistogram *lag = 0);
+    void begin(qint64 nowUs);//right after the SOCKS reply
+    Step next(qint64 nowUs, quint64 received, quint32 *size, qint64 *waitUs);
+
+    static bool isReplayable(const TrafficTrace::Session &session);
+
+private:
+    const TrafficTrace::Session *m_session;
+    TrafficTrace::EventType m_mine;
+    TrafficTrace::EventType m_peer;
+    LatencyHistogram *m_lag;
+    int m_index;
+    bool m_counted;//the peer event at m_index is in m_expected
+    quint64 m_expected;
+    qint64 m_lastUs;//recorded time of the last event passed
+    qint64 m_lastActual;//and when it was passed here
+    qint64 m_beginUs;
+    qint64 m_beginActual;
+};
+
+class ReplayClient;
+
+class ReplayConnection : public QObject
+{
+    Q_OBJECT
+
+public:
+    ReplayConnection(int index, ReplayClient *client);
+
+public slots:
+    void open();
+
+private:
+    enum State {
+        Greeting,
+        Request,
+        Running,
+        Finished
+    };
+
+    int m_index;
+    ReplayClient *m_client;
+    const TrafficTrace::Session *m_session;
+    ReplayScript m_script;
+    QTcpSocket m_socket;
+    QTimer m_timer;
+    State m_state;
+    QByteArray m_buffer;
+    quint64 m_received;
+    qint64 m_startUs;
+
+    void finish(bool failed);
+
+private slots:
+    void onConnected();
+    void onReadyRead();
+    void advance();
+    void onError();
+};
+
+class ReplayClient : public QObject
+{
+    Q_OBJECT
+
+public:
+    //plays the sessions whose index modulo shards is shard
+    ReplayClient(const QVector<TrafficTrace::Session> *sessions, int shard, int shards, quint16 socksPort, quint16 targetPort, QObject *parent = 0);
+    inline const LoadResult &result() const { return m_result; }
+    inline qint64 nowUs() const { return m_clock.nsecsElapsed() / 1000; }
+
+signals:
+    void finished();
+
+public slots:
+    void start();
+
+private:
+    friend class ReplayConnection;
+
+    const QVector<TrafficTrace::Session> *m_sessions;
+    QVector<int> m_mine;//indexes into m_sessions, in opening order
+    int m_nextOpen;
+    int m_open;
+    quint16 m_socksPort;
+    QByteArray m_request;
+    QByteArray m_zeros;
+    LoadResult m_result;
+    QElapsedTimer m_clock;
+    QTimer m_openTimer;
+    qint64 m_baseUs;//openUs of the first session
+
+    void sessionFinished(ReplayConnection *connection);
+
+private slots:
+    void openDue();
+};
+
+#endif // REPLAY_H
@@ -0,0 +1,93 @@
+#include "replayserver.h"
+
+ReplayServer::ReplayServer(const QVector<TrafficTrace::Session> *sessions, QObject *parent) :
+    QTcpServer(parent),
+    m_sessions(sessions),
+    m_zeros(64 * 1024, '\0')
+{}
+
+bool ReplayServer::listenLoopback()
+{
+    return listen(QHostAddress::LocalHost, 0);
+}
+
+void ReplayServer::incomingConnection(qintptr socketDescriptor)
+{
+    ReplaySession *session = new ReplaySession(m_sessions, m_zeros, this);
+    if (!session->start(socketDescriptor)) {
+        delete session;
+    }
+}
+
+ReplaySession::ReplaySession(const QVector<TrafficTrace::Session> *sessions, const QByteArray &zeros, QObject *parent) :
+    QObject(parent),
+    m_sessions(sessions),
+    m_zeros(zeros),
+    m_socket(this),
+    m_timer(this),
+    m_script(0),
+    m_received(0)
+{
+    m_timer.setSingleShot(true);
+    m_timer.setTimerType(Qt::PreciseTimer);
+    connect(&m_timer, &QTimer::timeout, this, &ReplaySession::advance);
+    connect(&m_socket, &QTcpSocket::readyRead, this, &ReplaySession::onReadyRead);
+    connect(&m_socket, &QTcpSocket::disconnected, this, &QObject::deleteLater);
+}
+
+ReplaySession::~ReplaySession()
+{
+    delete m_script;
+}
+
+bool ReplaySession::start(qintptr socketDescriptor)
+{
+    m_clock.start();
+    return m_socket.setSocketDescriptor(socketDescriptor);
+}
+
+void ReplaySession::onReadyRead()
+{
+    if (m_script) {
+        m_received += m_socket.readAll().size();
+        advance();
+        return;
+    }
+
+    m_header.append(m_socket.read(8 - m_header.size()));
+    if (m_header.size() < 8) {
+        return;
+    }
+    quint64 index = 0;
+    for (int i = 0; i < 8; ++i) {
+        index |= quint64(uchar(m_header.at(i))) << (8 * i);
+    }
+    if (index >= quint64(m_sessions->size())) {
+        m_socket.abort();
+        return;
+    }
+    m_script = new ReplayScript(&m_sessions->at(int(index)), TrafficTrace::Down);
+    m_script->begin(m_clock.nsecsElapsed() / 1000);
+    m_received = m_socket.readAll().size();
+    advance();
+}
+
+void ReplaySession::advance()
+{
+    for (;;) {
+        quint32 size = 0;
+        qint64 waitUs = 0;
+        switch (m_script->next(m_clock.nsecsElapsed() / 1000, m_received, &size, &waitUs)) {
+        case ReplayScript::Send:
+            for (quint32 sent = 0; sent < size; sent += m_zeros.size()) {
+                m_socket.write(m_zeros.constData(), qMin(quint32(m_zeros.size()), size - sent));
+            }
+            break;
+        case ReplayScript::Wait:
+            m_timer.start(int((waitUs + 999) / 1000));
+            return;
+        default://the client closes
+            return;
+        }
+    }
+}
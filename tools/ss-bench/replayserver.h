@@ -0,0 +1,57 @@
+/*
+ * Replay Server Class
+ *
+ * The target of replayed sessions: every connection starts with the index
+ * of its session in the trace, and gets the recorded responses back.
+ */
+#ifndef REPLAYSERVER_H
+#define REPLAYSERVER_H
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTimer>
+#include <QElapsedTimer>
+#include "replay.h"
+
+class ReplayServer : public QTcpServer
+{
+    Q_OBJECT
+
+public:
+    ReplayServer(const QVector<TrafficTrace::Session> *sessions, QObject *parent = 0);
+
+public slots:
+    bool listenLoopback();//on a free port, see serverPort()
+
+protected:
+    void incomingConnection(qintptr socketDescriptor);
+
+private:
+    const QVector<TrafficTrace::Session> *m_sessions;
+    QByteArray m_zeros;
+};
+
+class ReplaySession : public QObject
+{
+    Q_OBJECT
+
+public:
+    ReplaySession(const QVector<TrafficTrace::Session> *sessions, const QByteArray &zeros, QObject *parent = 0);
+    ~ReplaySession();
+    bool start(qintptr socketDescriptor);
+
+private:
+    const QVector<TrafficTrace::Session> *m_sessions;
+    QByteArray m_zeros;
+    QTcpSocket m_socket;
+    QTimer m_timer;
+    QElapsedTimer m_clock;
+    QByteArray m_header;
+    ReplayScript *m_script;
+    quint64 m_received;
+
+private slots:
+    void onReadyRead();
+    void advance();
+};
+
+#endif // REPLAYSERVER_H
@@ -0,0 +1,30 @@
+#-------------------------------------------------
+#
+#          ss-bench
+#
+#  End-to-end benchmark of the shadowsocks backends
+#
+#-------------------------------------------------
+
+QT      += core network concurrent
+QT      -= gui
+CONFIG  += c++11 console
+CONFIG  -= app_bundle
+
+TARGET   = ss-bench
+TEMPLATE = app
+
+include($$PWD/../../src/proxy.pri)
+
+SOURCES += main.cpp \
+           benchrunner.cpp \
+           loadclient.cpp \
+           echoserver.cpp \
+           replay.cpp \
+           replayserver.cpp
+
+HEADERS += benchrunner.h \
+           loadclient.h \
+           echoserver.h \
+           replay.h \
+           replayserver.h
@@ -0,0 +1,107 @@
+/*
+ * ssuri-bench
+ *
+ * Measures how fast SSUri parses and builds the URI shapes subscriptions
+ * are made of: legacy and SIP002 links, with a plugin, with an IPv6 host
+ * and with a remark long enough to push the decode buffer to the heap.
+ */
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QTextStream>
+#include <QVector>
+#include "ssuri.h"
+
+struct Shape
+{
+    const char *name;
+    QByteArray uri;
+};
+
+static QVector<Shape> shapes()
+{
+    QVector<Shape> list;
+    Shape s;
+    s.name = "legacy";
+    s.uri = SSUri::build(SSUri::Legacy, "aes-256-cfb", "correct horse battery", "ss.example.com", "8388");
+    list << s;
+    s.name = "sip002";
+    s.uri = SSUri::build(SSUri::Sip002, "chacha20-ietf-poly1305", "correct horse battery", "ss.example.com", "8388", QString(), QString(), "Tokyo 01");
+    list << s;
+    s.name = "plugin";
+    s.uri = SSUri::build(SSUri::Sip002, "aes-128-gcm", "correct horse battery", "198.51.100.7", "443", "obfs-local", "obfs=http;obfs-host=www.example.com", "Tokyo 02");
+    list << s;
+    s.name = "ipv6";
+    s.uri = SSUri::build(SSUri::Sip002, "aes-256-cfb", "correct horse battery", "2001:db8::1", "8388");
+    list << s;
+    s.name = "long";
+    s.uri = SSUri::build(SSUri::Sip002, "aes-256-cfb", "correct horse battery", "ss.example.com", "8388", QString(), QString(), QString(SSUri::InlineSize, QChar(0x6771)));
+    list << s;
+    return list;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    a.setApplicationName("ssuri-bench");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Throughput of the ss:// URI parser and builder.");
+    parser.addHelpOption();
+    QCommandLineOption durationOption(QStringList() << "d" << "duration", "Milliseconds every shape runs for.", "msecs", "1000");
+    parser.addOption(durationOption);
+    parser.process(a);
+
+    bool ok;
+    qint64 duration = parser.value(durationOption).toLongLong(&ok);
+    if (!ok || duration <= 0) {
+        QTextStream(stderr) << "Error: invalid arguments\n";
+        parser.showHelp(1);
+    }
+
+    QTextStream out(stdout);
+    out << QString("%1 %2 %3 %4 %5\n").arg("shape", -8).arg("bytes", 6).arg("parse/s", 12).arg("MiB/s", 9).arg("build/s", 12);
+    QVector<Shape> list = shapes();
+    for (QVector<Shape>::const_iterator it = list.constBegin(); it != list.constEnd(); ++it) {
+        SSUri uri;
+        if (!uri.parse(it->uri)) {
+            QTextStream(stderr) << "Error: " << it->name << " doesn't parse: " << it->uri << '\n';
+            return 1;
+        }
+
+        //batches between clock reads, so that the clock isn't what is measured
+        const int Batch = 1000;
+        qint64 parsed = 0;
+        quint64 sink = 0;
+        QElapsedTimer timer;
+        timer.start();
+        while (timer.elapsed() < duration) {
+            for (int i = 0; i < Batch; ++i) {
+                uri.parse(it->uri);
+                sink += uri.portNumber;
+            }
+            parsed += Batch;
+        }
+        double parseSecs = timer.nsecsElapsed() / 1e9;
+
+        const QString method = uri.method.toString(), password = uri.password.toString(), host = uri.host.toString();
+        const QString port = uri.port.toString(), plugin = uri.plugin.toString(), opts = uri.pluginOpts.toString(), remark = uri.remark.toString();
+        qint64 built = 0;
+        timer.restart();
+        while (timer.elapsed() < duration) {
+            for (int i = 0; i < Batch; ++i) {
+                sink += SSUri::build(uri.format, method, password, host, port, plugin, opts, remark).size();
+            }
+            built += Batch;
+        }
+        double buildSecs = timer.nsecsElapsed() / 1e9;
+
+        out << QString("%1 %2 %3 %4 %5\n").arg(it->name, -8).arg(it->uri.size(), 6)
+               .arg(parsed / parseSecs, 12, 'f', 0).arg(parsed * it->uri.size() / parseSecs / (1024.0 * 1024.0), 9, 'f', 1)
+               .arg(built / buildSecs, 12, 'f', 0);
+        if (sink == 0) {//keeps the loops from being optimized away
+            out << "";
+        }
+    }
+    return 0;
+}
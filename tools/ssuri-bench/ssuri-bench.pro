@@ -0,0 +1,23 @@
+#-------------------------------------------------
+#
+#          ssuri-bench
+#
+#  Throughput of the ss:// URI parser and builder
+#
+#-------------------------------------------------
+
+QT      += core
+QT      -= gui
+CONFIG  += c++11 console
+CONFIG  -= app_bundle
+
+TARGET   = ssuri-bench
+TEMPLATE = app
+
+SRC = $$PWD/../../src
+INCLUDEPATH += $$SRC
+
+SOURCES += main.cpp \
+           $$SRC/ssuri.cpp
+
+HEADERS += $$SRC/ssuri.h
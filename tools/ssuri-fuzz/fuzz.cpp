@@ -0,0 +1,56 @@
+/*
+ * ssuri-fuzz
+ *
+ * Feeds arbitrary bytes to SSUri::parse. Besides what the sanitizers find,
+ * it aborts on a malformed span, or when a URI built from the parsed fields
+ * doesn't parse back to the same fields.
+ */
+#include <cstdlib>
+#include <cstdint>
+#include "ssuri.h"
+
+static bool sameUtf8(const SSUri::Span &s)
+{
+    //build() takes QStrings, bytes that aren't UTF-8 can't survive the trip
+    return QString::fromUtf8(s.data, s.size).toUtf8() == QByteArray(s.data, s.size);
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    //a copy on the heap, so that ASan sees reads past the end
+    QByteArray input(reinterpret_cast<const char *>(data), int(size));
+    SSUri uri;
+    if (!uri.parse(input)) {
+        return 0;
+    }
+
+    const SSUri::Span spans[] = { uri.method, uri.password, uri.host, uri.port, uri.plugin, uri.pluginOpts, uri.remark };
+    for (const SSUri::Span &s : spans) {
+        if (s.size < 0 || (s.size > 0 && !s.data)) {
+            abort();
+        }
+    }
+
+    //round trip through SIP002, which can carry every field
+    for (const SSUri::Span &s : spans) {
+        if (!sameUtf8(s)) {
+            return 0;
+        }
+    }
+    QString host = uri.host.toString();
+    if (host.contains(QChar('[')) || host.contains(QChar(']')) || host.contains(QChar('/')) || host.contains(QChar('?'))
+            || host.contains(QChar('#')) || host.contains(QChar('@'))) {
+        return 0;//build() writes the host as it is
+    }
+    QByteArray rebuilt = SSUri::build(SSUri::Sip002, uri.method.toString(), uri.password.toString(), host, uri.port.toString(),
+                                      uri.plugin.toString(), uri.pluginOpts.toString(), uri.remark.toString());
+    SSUri again;
+    if (!again.parse(rebuilt)) {
+        abort();
+    }
+    if (again.method.toString() != uri.method.toString().toLower() || again.password.toString() != uri.password.toString()
+            || again.host.toString() != host || again.portNumber != uri.portNumber) {
+        abort();
+    }
+    return 0;
+}
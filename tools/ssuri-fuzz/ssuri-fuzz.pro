@@ -0,0 +1,29 @@
+#-------------------------------------------------
+#
+#          ssuri-fuzz
+#
+#  libFuzzer target for the ss:// URI parser
+#
+#-------------------------------------------------
+
+QT      += core
+QT      -= gui
+CONFIG  += c++11 console
+CONFIG  -= app_bundle
+
+TARGET   = ssuri-fuzz
+TEMPLATE = app
+
+#libFuzzer comes with clang and provides main()
+QMAKE_CXX  = clang++
+QMAKE_LINK = clang++
+QMAKE_CXXFLAGS += -g -fsanitize=fuzzer,address,undefined
+QMAKE_LFLAGS   += -fsanitize=fuzzer,address,undefined
+
+SRC = $$PWD/../../src
+INCLUDEPATH += $$SRC
+
+SOURCES += fuzz.cpp \
+           $$SRC/ssuri.cpp
+
+HEADERS += $$SRC/ssuri.h